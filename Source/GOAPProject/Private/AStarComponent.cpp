@@ -7,6 +7,7 @@
 #include "..\Public\GOAPAction.h"
 #include "..\Public\GOAPGoal.h"
 #include "..\Public\WorldState.h"
+#include "..\Public\AStarSearch.h"
 #include "Templates/IsTrivial.h"
 
 #include "Templates/Less.h"
@@ -34,122 +35,69 @@ void UAStarComponent::OnUnregister()
 	Super::OnUnregister();
 }
 
-TSharedPtr<FStateNode> UAStarComponent::Search(UGOAPGoal* Goal, const FWorldState& InitialState) //graph needs to be V, E
+namespace
 {
-	//Fringe is a priority queue in textbook A*
-	//Use TArray's heap functionality to mimic a priority queue
-	if (!IsValid(Goal))
+	/** Successor policy for UAStarComponent
+	  * Candidate edges come straight from the action lookup table and context preconditions are
+	  * verified on every expansion.
+	  */
+	struct FActionTableSuccessors
 	{
-		return nullptr;
-	}
-
-	FPriorityQueue Fringe;
-
-	//To save time, ALL nodes are added to a single set, and keep track of whether they're closed
-	//This does mean that we're using additional space, but it's easier and faster, I think
-	TSet<NodePtr, FStateNode::SetKeyFuncs> NodePool;
-
-	NodePtr CurrentNode = MakeShared<FStateNode>(InitialState, Goal->GetGoalCondition());
-
-	Fringe.Push(CurrentNode);
-	NodePool.Add(CurrentNode);
-	//TODO: empty the fringe before exiting
-	while (Fringe.Num() != 0) 
-	{
-
-		//pop the lowest cost node from p-queue
-		Fringe.Pop(CurrentNode);
-		if (!CurrentNode.IsValid())
-		{
-			break;
-		}
-		CurrentNode->MarkClosed();
-		//This is a regressive search
-		//a goal node g is any node s.t. all values of the node's state match that of the initial state
-		if (CurrentNode->IsGoal())
-		{
-			break;
-		}
-
-		if (CurrentNode->GetDepth() > MaxDepth)
-		{
-			//Do not want to accidentally generate partial plan
-			//if last node in fringe went over MaxDepth
-			CurrentNode = nullptr;
-			continue;
-		}
-
-		//Generate candidate edges (actions)
+		const FStateNode::LookupTable& ActionTable;
 		TArray<TWeakObjectPtr<UGOAPAction>> CandidateEdges;
-		CurrentNode->GetNeighboringEdges(ActionTable, CandidateEdges);
-
 		TSet<UGOAPAction*> VisitedActions;
-		for (auto ActionHandle : CandidateEdges) 
+
+		explicit FActionTableSuccessors(const FStateNode::LookupTable& InActionTable) : ActionTable(InActionTable) {}
+
+		template<typename EmitType>
+		FORCEINLINE void Generate(FStateNode& Node, EmitType&& Emit)
 		{
+			//Generate candidate edges (actions)
+			CandidateEdges.Reset();
+			Node.GetNeighboringEdges(ActionTable, CandidateEdges);
 
-			
-			if (!ActionHandle.IsValid())
+			VisitedActions.Reset();
+			for (auto ActionHandle : CandidateEdges)
 			{
-				UE_LOG(LogAction, Error, TEXT("Bad Action access in planner!!"));
-				UE_LOG(LogAction, Error, TEXT("You probably dumped the ActionSet somewhere, again"));
-				continue;
-			}
+				if (!ActionHandle.IsValid())
+				{
+					UE_LOG(LogAction, Error, TEXT("Bad Action access in planner!!"));
+					UE_LOG(LogAction, Error, TEXT("You probably dumped the ActionSet somewhere, again"));
+					continue;
+				}
 
-			//Can move this stuff into GenerateNeighbors
-			UGOAPAction* Action = ActionHandle.Get();
-			//verify context preconditions
-			//skip action if it has already been visited for this node
-			if (!Action->VerifyContext() || VisitedActions.Contains(Action))
-			{
-				continue;
-			}
-			
-			//mark edge as visited for current node
-			VisitedActions.Add(Action);
+				UGOAPAction* Action = ActionHandle.Get();
+				//verify context preconditions
+				//skip action if it has already been visited for this node
+				if (!Action->VerifyContext() || VisitedActions.Contains(Action))
+				{
+					continue;
+				}
+				//mark edge as visited for current node
+				VisitedActions.Add(Action);
 
-			//Create the Child node 
-			NodePtr ChildNode = MakeShared<FStateNode>(*CurrentNode);
-			if (!ChildNode.IsValid())
-			{
-				continue;
-			}
-			if (!ChildNode->ChainBackward(*Action))
-			{
-				continue;
-			}
-			//check if node exists already
-			const NodePtr* FindNode = NodePool.Find(ChildNode);
-			if(FindNode != nullptr && FindNode->IsValid())
-			{
-				NodePtr ExistingNode = *FindNode;
-				if (ChildNode->GetForwardCost() < ExistingNode->GetForwardCost())
+				//Create the Child node 
+				TSharedPtr<FStateNode> ChildNode = MakeShared<FStateNode>(Node);
+				if (ChildNode->ChainBackward(*Action))
 				{
-					ExistingNode->ReParent(*ChildNode);
-					if (ExistingNode->IsClosed())
-					{
-						ExistingNode->MarkOpened();
-						Fringe.Push(ExistingNode);
-					}
-					else
-					{
-						Fringe.ReSort();
-					}
+					Emit(ChildNode);
 				}
 			}
-			else
-			{
-				ChildNode->MarkOpened(); //just in case we haven't
-				Fringe.Push(ChildNode);
-				NodePool.Add(ChildNode);
-			}
 		}
-	}
-	
-	if (CurrentNode.IsValid())
+	};
+}
+
+TSharedPtr<FStateNode> UAStarComponent::Search(UGOAPGoal* Goal, const FWorldState& InitialState) //graph needs to be V, E
+{
+	if (!IsValid(Goal))
 	{
-		return CurrentNode;
+		return nullptr;
 	}
-	return nullptr;
+
+	NodePtr StartNode = MakeShared<FStateNode>(InitialState, Goal->GetGoalCondition());
+	FActionTableSuccessors Successors(ActionTable);
+	FPlannerSearchStats Stats;
+	return TRegressiveSearch<>::Run(StartNode, Successors, FNoExtraHeuristic(), FDepthLimitedGoal(MaxDepth), Stats);
 }
 
 void UAStarComponent::AddAction(UGOAPAction* Action)
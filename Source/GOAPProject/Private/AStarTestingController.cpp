@@ -6,6 +6,7 @@
 #include "..\Public\GOAPAction.h"
 #include "..\Public\AStarComponent.h"
 #include "..\Public\WorldProperty.h"
+#include "..\Public\PlannerBenchmark.h"
 
 AAStarTestingController::AAStarTestingController()
 	: Super()
@@ -18,6 +19,8 @@ AAStarTestingController::AAStarTestingController()
 
 void AAStarTestingController::Plan()
 {
+	FPlannerBenchmarkResult Result = FPlannerBenchmark::Run(BenchmarkParams);
+	UE_LOG(LogPlannerBenchmark, Log, TEXT("%s"), *Result.ToJson());
 }
 
 void AAStarTestingController::BeginPlay()
@@ -6,6 +6,7 @@
 #include "..\Public\AITask_Operator.h"
 #include "BrainComponent.h"
 #include "..\Public\PlannerComponent.h"
+#include "..\Public\GOAPCostProvider.h"
 #include "AIController.h"
 #include "Tasks/AITask.h"
 #include "GameFramework/Character.h"
@@ -33,6 +34,11 @@ UGOAPAction::UGOAPAction(const FObjectInitializer& ObjectInitializer) :
 {
 
 }
+
+int32 UGOAPAction::SnapshotCost(const FWorldState& WS) const
+{
+	return CostProvider ? CostProvider->CalcCost(AIOwner, WS, Cost()) : Cost();
+}
 void UGOAPAction::AddEffect(const EWorldKey& Key, const FAISymEffect& Effect)
 {
 	Effects.Add(Effect);
@@ -322,3 +328,104 @@ EActionResult UGOAPAction_Operator::AbortAction()
 	}
 	return EActionResult::Aborted;
 }
+
+bool UGOAPAction_Macro::Combine(const TArray<const UGOAPAction*>& Chain, TArray<FWorldProperty>& OutPreconditions, TArray<FAISymEffect>& OutEffects, int32& OutCost)
+{
+	OutPreconditions.Reset();
+	OutEffects.Reset();
+	OutCost = 0;
+
+	//Values set by the steps so far
+	FWorldState Produced;
+	uint32 ProducedKeys = 0;
+	for (const UGOAPAction* Action : Chain)
+	{
+		if (!Action || Action->IsA<UGOAPAction_Macro>() || Action->GetCostProvider())
+		{
+			return false;
+		}
+		for (const FWorldProperty& Precondition : Action->GetPreconditions())
+		{
+			if (!Precondition.IsRHSAbsolute())
+			{
+				return false;
+			}
+			if (ProducedKeys & (1u << (uint32)Precondition.Key))
+			{
+				if (!Produced.CheckCondition(Precondition))
+				{
+					return false;
+				}
+				continue;
+			}
+			for (const FWorldProperty& Existing : OutPreconditions)
+			{
+				if (Existing.Key == Precondition.Key && Existing.Comparator == ESymbolTest::Eq && Precondition.Comparator == ESymbolTest::Eq && Existing.Value != Precondition.Value)
+				{
+					return false;
+				}
+			}
+			OutPreconditions.Add(Precondition);
+		}
+		for (const FAISymEffect& Effect : Action->GetEffects())
+		{
+			if (Effect.KeyRHS != EWorldKey::SYMBOL_MAX || Effect.Op != ESymbolOp::Set)
+			{
+				return false;
+			}
+			Produced.SetProp(Effect.Key, Effect.Value);
+			ProducedKeys |= 1u << (uint32)Effect.Key;
+			OutEffects.RemoveAll([&Effect](const FAISymEffect& Existing) { return Existing.Key == Effect.Key; });
+			OutEffects.Add(Effect);
+		}
+		OutCost += Action->Cost();
+	}
+	return Chain.Num() > 1;
+}
+
+void UGOAPAction_Macro::Setup(const FString& InName, const TArray<int32>& InStepIndices, const TArray<FWorldProperty>& InPreconditions, const TArray<FAISymEffect>& InEffects, int32 InCost)
+{
+	ActionName = InName;
+	StepIndices = InStepIndices;
+	Preconditions = InPreconditions;
+	Effects = InEffects;
+	EdgeCost = InCost;
+}
+
+void UGOAPAction_Macro::ResolveSteps(const TArray<UGOAPAction*>& ActionSet)
+{
+	Steps.Reset(StepIndices.Num());
+	for (int32 StepIdx : StepIndices)
+	{
+		UGOAPAction* Step = ActionSet.IsValidIndex(StepIdx) ? ActionSet[StepIdx] : nullptr;
+		if (!Step || Step == this)
+		{
+			UE_LOG(LogAction, Error, TEXT("Macro %s has a bad step index %d, was the asset's action list reordered?"), *GetActionName(), StepIdx);
+			Steps.Reset();
+			return;
+		}
+		Steps.Add(Step);
+	}
+}
+
+bool UGOAPAction_Macro::VerifyContext()
+{
+	if (Steps.Num() == 0)
+	{
+		return false;
+	}
+	for (UGOAPAction* Step : Steps)
+	{
+		if (!Step->VerifyContext())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+EActionResult UGOAPAction_Macro::StartAction()
+{
+	ensureMsgf(false, TEXT("Macro %s should have been expanded into its steps"), *GetActionName());
+	return EActionResult::Failed;
+}
@@ -0,0 +1,246 @@
+#include "../Public/GOAPCooldownSubsystem.h"
+#include "../Public/PlannerComponent.h"
+#include "Engine/World.h"
+
+UGOAPCooldownSubsystem* UGOAPCooldownSubsystem::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UGOAPCooldownSubsystem>() : nullptr;
+}
+
+void UGOAPCooldownSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	for (int32& Head : SlotHeads)
+	{
+		Head = INDEX_NONE;
+	}
+}
+
+void UGOAPCooldownSubsystem::Deinitialize()
+{
+	Entries.Reset();
+	FreeHead = INDEX_NONE;
+	NumActive = 0;
+	for (int32& Head : SlotHeads)
+	{
+		Head = INDEX_NONE;
+	}
+	Super::Deinitialize();
+}
+
+FCooldownTimerHandle UGOAPCooldownSubsystem::Schedule(UPlannerComponent& Owner, const FGameplayTag& Tag, float EndTime)
+{
+	SyncToWorldTime(GetWorldTick(*Owner.GetWorld()));
+
+	int32 EntryIdx = FreeHead;
+	if (EntryIdx != INDEX_NONE)
+	{
+		FreeHead = Entries[EntryIdx].Next;
+	}
+	else
+	{
+		EntryIdx = Entries.AddDefaulted();
+	}
+
+	FTimerEntry& Entry = Entries[EntryIdx];
+	Entry.Owner = &Owner;
+	Entry.Tag = Tag;
+	//Round up so we never wake before the cooldown has actually ended
+	Entry.ExpireTick = FMath::Max((uint64)FMath::CeilToInt(FMath::Max(EndTime, 0.f) / CooldownTickSeconds), CurrentTick + 1);
+	Entry.Serial = NextSerial++;
+	Link(EntryIdx);
+	++NumActive;
+
+	FCooldownTimerHandle Handle;
+	Handle.Index = EntryIdx;
+	Handle.Serial = Entry.Serial;
+	return Handle;
+}
+
+void UGOAPCooldownSubsystem::Cancel(FCooldownTimerHandle& Handle)
+{
+	if (Handle.IsValid() && Entries.IsValidIndex(Handle.Index) && Entries[Handle.Index].Serial == Handle.Serial)
+	{
+		Unlink(Handle.Index);
+		Release(Handle.Index);
+	}
+	Handle.Reset();
+}
+
+void UGOAPCooldownSubsystem::Tick(float DeltaTime)
+{
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+	const uint64 NowTick = GetWorldTick(*World);
+	SyncToWorldTime(NowTick);
+	Advance(NowTick);
+}
+
+uint64 UGOAPCooldownSubsystem::GetWorldTick(const UWorld& World)
+{
+	return (uint64)(FMath::Max(World.GetTimeSeconds(), 0.f) / CooldownTickSeconds);
+}
+
+void UGOAPCooldownSubsystem::SyncToWorldTime(uint64 NowTick)
+{
+	if (NumActive == 0)
+	{
+		CurrentTick = NowTick;
+		return;
+	}
+	if (NowTick >= CurrentTick)
+	{
+		return;
+	}
+
+	//Rare, so walking every slot is fine
+	TArray<int32, TInlineAllocator<64>> Active;
+	for (int32& Head : SlotHeads)
+	{
+		for (int32 EntryIdx = Head; EntryIdx != INDEX_NONE; EntryIdx = Entries[EntryIdx].Next)
+		{
+			Active.Add(EntryIdx);
+		}
+		Head = INDEX_NONE;
+	}
+	for (int32 EntryIdx : Active)
+	{
+		FTimerEntry& Entry = Entries[EntryIdx];
+		Entry.ExpireTick = NowTick + FMath::Max<uint64>(Entry.ExpireTick - CurrentTick, 1);
+	}
+	CurrentTick = NowTick;
+	for (int32 EntryIdx : Active)
+	{
+		Link(EntryIdx);
+	}
+}
+
+bool UGOAPCooldownSubsystem::IsTickable() const
+{
+	return !HasAnyFlags(RF_ClassDefaultObject) && NumActive != 0;
+}
+
+TStatId UGOAPCooldownSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGOAPCooldownSubsystem, STATGROUP_Tickables);
+}
+
+void UGOAPCooldownSubsystem::Link(int32 EntryIdx)
+{
+	FTimerEntry& Entry = Entries[EntryIdx];
+	const uint64 Delta = Entry.ExpireTick - CurrentTick;
+
+	int32 Level = 0;
+	while (Level < NumLevels - 1 && Delta >= (1ull << (SlotBits * (Level + 1))))
+	{
+		++Level;
+	}
+	//Anything past the last level waits in the furthest slot and gets re-linked when it cascades
+	const uint64 MaxDelta = (1ull << (SlotBits * NumLevels)) - 1;
+	const uint64 SlotTick = CurrentTick + FMath::Min(Delta, MaxDelta);
+	const int32 Slot = Level * SlotsPerLevel + (int32)((SlotTick >> (SlotBits * Level)) & (SlotsPerLevel - 1));
+
+	Entry.Slot = Slot;
+	Entry.Prev = INDEX_NONE;
+	Entry.Next = SlotHeads[Slot];
+	if (Entry.Next != INDEX_NONE)
+	{
+		Entries[Entry.Next].Prev = EntryIdx;
+	}
+	SlotHeads[Slot] = EntryIdx;
+}
+
+void UGOAPCooldownSubsystem::Unlink(int32 EntryIdx)
+{
+	FTimerEntry& Entry = Entries[EntryIdx];
+	if (Entry.Prev != INDEX_NONE)
+	{
+		Entries[Entry.Prev].Next = Entry.Next;
+	}
+	else
+	{
+		SlotHeads[Entry.Slot] = Entry.Next;
+	}
+	if (Entry.Next != INDEX_NONE)
+	{
+		Entries[Entry.Next].Prev = Entry.Prev;
+	}
+	Entry.Prev = INDEX_NONE;
+	Entry.Next = INDEX_NONE;
+	Entry.Slot = INDEX_NONE;
+}
+
+void UGOAPCooldownSubsystem::Release(int32 EntryIdx)
+{
+	FTimerEntry& Entry = Entries[EntryIdx];
+	Entry.Owner = nullptr;
+	Entry.Serial = 0;
+	Entry.Next = FreeHead;
+	FreeHead = EntryIdx;
+	--NumActive;
+}
+
+void UGOAPCooldownSubsystem::Cascade(int32 Level)
+{
+	const int32 Slot = Level * SlotsPerLevel + (int32)((CurrentTick >> (SlotBits * Level)) & (SlotsPerLevel - 1));
+	int32 EntryIdx = SlotHeads[Slot];
+	SlotHeads[Slot] = INDEX_NONE;
+	while (EntryIdx != INDEX_NONE)
+	{
+		const int32 Next = Entries[EntryIdx].Next;
+		Link(EntryIdx);
+		EntryIdx = Next;
+	}
+}
+
+void UGOAPCooldownSubsystem::Advance(uint64 TargetTick)
+{
+	while (CurrentTick < TargetTick && NumActive != 0)
+	{
+		++CurrentTick;
+
+		//Higher levels first so their entries can land in a lower slot that cascades this tick too
+		for (int32 Level = NumLevels - 1; Level > 0; --Level)
+		{
+			if ((CurrentTick & ((1ull << (SlotBits * Level)) - 1)) == 0)
+			{
+				Cascade(Level);
+			}
+		}
+
+		const int32 Slot = (int32)(CurrentTick & (SlotsPerLevel - 1));
+		int32 EntryIdx = SlotHeads[Slot];
+		SlotHeads[Slot] = INDEX_NONE;
+		while (EntryIdx != INDEX_NONE)
+		{
+			FTimerEntry& Entry = Entries[EntryIdx];
+			const int32 Next = Entry.Next;
+			if (Entry.ExpireTick > CurrentTick)
+			{
+				Link(EntryIdx);
+			}
+			else
+			{
+				UPlannerComponent* Owner = Entry.Owner.Get();
+				const FGameplayTag Tag = Entry.Tag;
+				Entry.Slot = INDEX_NONE;
+				Release(EntryIdx);
+				//Owner may schedule a new cooldown from here, the entry is already free
+				if (Owner)
+				{
+					Owner->OnCooldownExpired(Tag);
+				}
+			}
+			EntryIdx = Next;
+		}
+	}
+	//Nothing left to fire, jump straight to now
+	if (NumActive == 0)
+	{
+		CurrentTick = FMath::Max(CurrentTick, TargetTick);
+	}
+}
@@ -0,0 +1,50 @@
+#include "..\Public\GOAPCostProvider.h"
+#include "..\Public\WorldState.h"
+#include "AIController.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Object.h"
+
+UGOAPCostProvider::UGOAPCostProvider(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+
+}
+
+UGOAPCost_BBDistance::UGOAPCost_BBDistance(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	//Both the pawn and the target move without any world state key changing, so there's nothing to cache on
+	bAlwaysRefresh = true;
+}
+
+int32 UGOAPCost_BBDistance::CalcCost(AAIController* AIOwner, const FWorldState& WS, int32 BaseCost) const
+{
+	if (!AIOwner || !AIOwner->GetPawn() || !AIOwner->GetBlackboardComponent() || DistancePerCost <= 0.f)
+	{
+		return BaseCost;
+	}
+	UBlackboardComponent* BBComp = AIOwner->GetBlackboardComponent();
+	const FBlackboard::FKey KeyID = BBComp->GetKeyID(BBTargetName);
+	if (KeyID == FBlackboard::InvalidKey)
+	{
+		return BaseCost;
+	}
+
+	FVector TargetLocation;
+	if (BBComp->GetKeyType(KeyID) == UBlackboardKeyType_Object::StaticClass())
+	{
+		const AActor* TargetActor = Cast<AActor>(BBComp->GetValue<UBlackboardKeyType_Object>(KeyID));
+		if (!TargetActor)
+		{
+			return BaseCost;
+		}
+		TargetLocation = TargetActor->GetActorLocation();
+	}
+	else if (!BBComp->GetLocationFromEntry(KeyID, TargetLocation))
+	{
+		return BaseCost;
+	}
+
+	const float Distance = FVector::Dist(AIOwner->GetPawn()->GetActorLocation(), TargetLocation);
+	return BaseCost + FMath::CeilToInt(Distance / DistancePerCost);
+}
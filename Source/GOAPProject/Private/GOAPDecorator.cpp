@@ -6,6 +6,18 @@
 #include "Perception/AISense_Damage.h"
 #include "AIController.h"
 #include "..\Public\PlannerComponent.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY(LogDecorator);
+
+namespace
+{
+	TAutoConsoleVariable<int32> CVarVerifyDecoratorCache(
+		TEXT("GOAP.Decorators.VerifyCache"),
+		0,
+		TEXT("Re-run cached decorators and report any whose cached result is stale"),
+		ECVF_Cheat);
+}
 
 UGOAPDecorator::UGOAPDecorator(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
@@ -13,6 +25,48 @@ UGOAPDecorator::UGOAPDecorator(const FObjectInitializer& ObjectInitializer)
 
 }
 
+void UGOAPDecorator::SetOwner(UPlannerComponent& OwnerComponent)
+{
+	OwnerPlanner = &OwnerComponent;
+	FDecoratorInvalidation Invalidation;
+	bCanCache = DescribeInvalidation(Invalidation);
+	bCacheOnWSVersion = Invalidation.bWorldState;
+	bHasCachedValue = false;
+}
+
+bool UGOAPDecorator::GetConditionValue(AAIController& AIOwner, const FWorldStateSnapshot& Snapshot)
+{
+	const FWorldState& WS = Snapshot.WS;
+	if (!bCanCache)
+	{
+		return CalcRawConditionValue(AIOwner, WS);
+	}
+
+	const float Now = GetWorld() ? GetWorld()->GetTimeSeconds() : 0.f;
+	const bool bSameWS = !bCacheOnWSVersion || CachedWSVersion == Snapshot.Version;
+	if (bHasCachedValue && bSameWS && (CacheExpireTime <= 0.f || Now < CacheExpireTime))
+	{
+#if !UE_BUILD_SHIPPING
+		if (CVarVerifyDecoratorCache.GetValueOnGameThread() != 0)
+		{
+			const bool bFresh = CalcRawConditionValue(AIOwner, WS);
+			if (bFresh != bCachedValue)
+			{
+				UE_LOG(LogDecorator, Warning, TEXT("%s on %s cached %d but evaluates to %d, it's missing an invalidation event"),
+					*GetName(), *GetNameSafe(AIOwner.GetPawn()), bCachedValue, bFresh);
+			}
+		}
+#endif
+		return bCachedValue;
+	}
+
+	CacheExpireTime = 0.f;
+	CachedWSVersion = Snapshot.Version;
+	bCachedValue = CalcRawConditionValue(AIOwner, WS);
+	bHasCachedValue = true;
+	return bCachedValue;
+}
+
 UGOAPDec_ShouldFlushOut::UGOAPDec_ShouldFlushOut(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
@@ -43,13 +97,26 @@ bool UGOAPDec_ShouldFlushOut::CalcRawConditionValue(AAIController& AIOwner, cons
 		{
 			bool bSensed = Info->LastSensedStimuli[StimID].WasSuccessfullySensed();
 			float fAge = Info->LastSensedStimuli[StimID].GetAge();
-			return (!bSensed && fAge < AgeThreshold);
+			if (!bSensed && fAge < AgeThreshold)
+			{
+				//Flips once the stimulus is old enough
+				InvalidateAt(GetWorld()->GetTimeSeconds() + (AgeThreshold - fAge));
+				return true;
+			}
+			return false;
 		}
 	}
 
 	return false;
 }
 
+bool UGOAPDec_ShouldFlushOut::DescribeInvalidation(FDecoratorInvalidation& OutInvalidation) const
+{
+	OutInvalidation.BBKeys.Add(BBTargetName);
+	OutInvalidation.bPerception = true;
+	return true;
+}
+
 UGOAPDec_IsKeyOfType::UGOAPDec_IsKeyOfType(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
@@ -72,6 +139,12 @@ bool UGOAPDec_IsKeyOfType::CalcRawConditionValue(AAIController& AIOwner, const F
 	return false;
 }
 
+bool UGOAPDec_IsKeyOfType::DescribeInvalidation(FDecoratorInvalidation& OutInvalidation) const
+{
+	OutInvalidation.BBKeys.Add(BBTargetName);
+	return true;
+}
+
 UGOAPDec_DamagedSince::UGOAPDec_DamagedSince(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
@@ -96,12 +169,23 @@ bool UGOAPDec_DamagedSince::CalcRawConditionValue(AAIController& AIOwner, const
 			
 			bool bSensed = Info->LastSensedStimuli[StimID].WasSuccessfullySensed();
 			float fAge = Info->LastSensedStimuli[StimID].GetAge();
-			return (bSensed && fAge < AgeThreshold);
+			if (bSensed && fAge < AgeThreshold)
+			{
+				InvalidateAt(GetWorld()->GetTimeSeconds() + (AgeThreshold - fAge));
+				return true;
+			}
+			return false;
 		}
 	}
 	return false;
 }
 
+bool UGOAPDec_DamagedSince::DescribeInvalidation(FDecoratorInvalidation& OutInvalidation) const
+{
+	OutInvalidation.bPerception = true;
+	return true;
+}
+
 UGOAPDec_TagCooldown::UGOAPDec_TagCooldown(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
@@ -109,7 +193,7 @@ UGOAPDec_TagCooldown::UGOAPDec_TagCooldown(const FObjectInitializer& ObjectIniti
 
 bool UGOAPDec_TagCooldown::CalcRawConditionValue(AAIController& AIOwner, const FWorldState& WS)
 {
-	UPlannerComponent* PlannerComp = AIOwner.FindComponentByClass<UPlannerComponent>();
+	UPlannerComponent* PlannerComp = OwnerPlanner ? OwnerPlanner : AIOwner.FindComponentByClass<UPlannerComponent>();
 	if (!PlannerComp)
 	{
 		UE_LOG(LogTemp, Warning, TEXT("No plannerComp found"));
@@ -123,7 +207,18 @@ bool UGOAPDec_TagCooldown::CalcRawConditionValue(AAIController& AIOwner, const F
 		return true;
 	}
 	
-	return (GetWorld()->GetTimeSeconds() >= EndTime);
+	if (GetWorld()->GetTimeSeconds() >= EndTime)
+	{
+		return true;
+	}
+	InvalidateAt(EndTime);
+	return false;
+}
+
+bool UGOAPDec_TagCooldown::DescribeInvalidation(FDecoratorInvalidation& OutInvalidation) const
+{
+	OutInvalidation.Tags.Add(CooldownTag);
+	return true;
 }
 
 void UGOAPDec_TagCooldown::OnTaskDeactivated(UPlannerComponent& OwnerComp)
@@ -1,6 +1,7 @@
 #include "..\Public\GOAPGoal.h"
 #include "..\Public\WorldState.h"
 #include "..\Public\GOAPDecorator.h"
+#include "..\Public\PlannerComponent.h"
 #include "BehaviorTree/BlackboardData.h"
 #include "AIController.h"
 
@@ -15,12 +16,12 @@ UGOAPGoal::UGOAPGoal() :
 {
 }
 
-bool UGOAPGoal::ValidateContextPreconditions(const FWorldState& WS) const
+bool UGOAPGoal::ValidateContextPreconditions(const FWorldStateSnapshot& Snapshot) const
 {
 	//For now. Will check decorators here
 	for (auto* Decorator : Decorators)
 	{
-		if (!Decorator->CalcRawConditionValue(*AIOwner, WS))
+		if (!Decorator->GetConditionValue(*AIOwner, Snapshot))
 		{
 			return false;
 		}
@@ -35,7 +36,7 @@ void UGOAPGoal::SetOwner(AAIController& Controller, UPlannerComponent& OwnerComp
 
 }
 
-void UGOAPGoal::OnWSUpdated(const FWorldState& WorldState)
+bool UGOAPGoal::OnWSUpdated(const FWorldState& WorldState)
 {
 	bool bSuccess = true;
 	for (auto& Precondition : Preconditions)
@@ -46,8 +47,14 @@ void UGOAPGoal::OnWSUpdated(const FWorldState& WorldState)
 			break;
 		}
 	}
-	CacheValidity(bSuccess);
+	return SetValidity(bSuccess);
+}
 
+bool UGOAPGoal::SetValidity(bool bValid)
+{
+	const bool bChanged = (bValid != bCachedValidity);
+	CacheValidity(bValid);
+	return bChanged;
 }
 
 void UGOAPGoal::OnPlanFinished()
@@ -56,6 +63,10 @@ void UGOAPGoal::OnPlanFinished()
 	{
 		return;
 	}
+	if (UWorld* World = OwnerComp->GetWorld())
+	{
+		LastFinishedTime = World->GetTimeSeconds();
+	}
 	for (auto* Decorator : Decorators)
 	{
 		Decorator->OnTaskDeactivated(*OwnerComp);
@@ -65,4 +76,17 @@ void UGOAPGoal::OnPlanFinished()
 float UGOAPGoal::GetInsistence() const
 {
 	return Insistence;
+}
+
+void UGOAPGoal::SetInsistence(float NewInsistence)
+{
+	if (NewInsistence == Insistence)
+	{
+		return;
+	}
+	Insistence = NewInsistence;
+	if (OwnerComp)
+	{
+		OwnerComp->OnGoalPriorityChanged(*this);
+	}
 }
\ No newline at end of file
@@ -0,0 +1,333 @@
+#include "../Public/GOAPInsistenceSubsystem.h"
+#include "../Public/GOAPGoal.h"
+#include "../Public/PlannerComponent.h"
+#include "../Public/GOAPStats.h"
+#include "AIController.h"
+#include "Curves/CurveFloat.h"
+#include "Engine/World.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Bool.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Float.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Int.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Object.h"
+#include "HAL/IConsoleManager.h"
+
+namespace
+{
+	TAutoConsoleVariable<float> CVarInsistenceInterval(
+		TEXT("GOAP.InsistenceInterval"),
+		0.1f,
+		TEXT("Seconds between batched goal insistence updates"),
+		ECVF_Default);
+}
+
+UGOAPInsistenceSubsystem* UGOAPInsistenceSubsystem::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UGOAPInsistenceSubsystem>() : nullptr;
+}
+
+void UGOAPInsistenceSubsystem::RegisterPlanner(UPlannerComponent& Planner)
+{
+	FRegisteredPlanner* Registered = Planners.FindByPredicate([&Planner](const FRegisteredPlanner& Entry) { return Entry.Planner.Get() == &Planner; });
+	if (!Registered)
+	{
+		Registered = &Planners[Planners.AddDefaulted()];
+		Registered->Planner = &Planner;
+	}
+	Registered->Goals.Reset();
+	Registered->Terms.Reset();
+	for (UGOAPGoal* Goal : Planner.GetGoals())
+	{
+		if (!Goal || Goal->GetInsistenceTerms().Num() == 0)
+		{
+			continue;
+		}
+		const int32 GoalIdx = Registered->Goals.Add(Goal);
+		for (const FInsistenceTerm& Term : Goal->GetInsistenceTerms())
+		{
+			if (!Term.Curve)
+			{
+				continue;
+			}
+			FBakedTerm& Baked = Registered->Terms[Registered->Terms.Add(BakeTerm(Term, Planner))];
+			Baked.GoalIdx = GoalIdx;
+		}
+	}
+}
+
+void UGOAPInsistenceSubsystem::UnregisterPlanner(UPlannerComponent& Planner)
+{
+	Planners.RemoveAllSwap([&Planner](const FRegisteredPlanner& Entry) { return Entry.Planner.Get() == &Planner; });
+}
+
+void UGOAPInsistenceSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+#if WITH_EDITOR
+	FCoreUObjectDelegates::OnObjectModified.AddUObject(this, &UGOAPInsistenceSubsystem::OnObjectModified);
+#endif
+}
+
+void UGOAPInsistenceSubsystem::Deinitialize()
+{
+#if WITH_EDITOR
+	FCoreUObjectDelegates::OnObjectModified.RemoveAll(this);
+#endif
+	Planners.Reset();
+	CurveIndices.Reset();
+	BakedCurves.Reset();
+	DirtyCurves.Reset();
+	BatchGoals.Reset();
+	Super::Deinitialize();
+}
+
+#if WITH_EDITOR
+void UGOAPInsistenceSubsystem::OnObjectModified(UObject* Object)
+{
+	//Sent before the edit lands, the next update bakes the edited curve
+	if (const UCurveFloat* Curve = Cast<UCurveFloat>(Object))
+	{
+		const TWeakObjectPtr<const UCurveFloat> CurveKey(Curve);
+		if (CurveIndices.Contains(CurveKey))
+		{
+			DirtyCurves.AddUnique(CurveKey);
+		}
+	}
+}
+#endif
+
+void UGOAPInsistenceSubsystem::Tick(float DeltaTime)
+{
+	TimeUntilUpdate -= DeltaTime;
+	if (TimeUntilUpdate > 0.f)
+	{
+		return;
+	}
+	TimeUntilUpdate = CVarInsistenceInterval.GetValueOnGameThread();
+	UpdateInsistence();
+}
+
+bool UGOAPInsistenceSubsystem::IsTickable() const
+{
+	return !HasAnyFlags(RF_ClassDefaultObject) && Planners.Num() != 0;
+}
+
+TStatId UGOAPInsistenceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGOAPInsistenceSubsystem, STATGROUP_Tickables);
+}
+
+void UGOAPInsistenceSubsystem::UpdateInsistence()
+{
+	SCOPE_CYCLE_COUNTER(STAT_GOAP_InsistenceUpdate);
+
+	for (const TWeakObjectPtr<const UCurveFloat>& CurveKey : DirtyCurves)
+	{
+		const UCurveFloat* Curve = CurveKey.Get();
+		const int32* CurveIdx = CurveIndices.Find(CurveKey);
+		if (Curve && CurveIdx)
+		{
+			BakeCurve(*Curve, BakedCurves[*CurveIdx]);
+		}
+	}
+	DirtyCurves.Reset();
+
+	TermInputs.Reset();
+	TermCurves.Reset();
+	TermWeights.Reset();
+	TermGoals.Reset();
+	BatchGoals.Reset();
+
+	//Gather. This is the only part that touches game code
+	for (int32 PlannerIdx = Planners.Num() - 1; PlannerIdx >= 0; --PlannerIdx)
+	{
+		const FRegisteredPlanner& Registered = Planners[PlannerIdx];
+		const UPlannerComponent* Planner = Registered.Planner.Get();
+		if (!Planner)
+		{
+			Planners.RemoveAtSwap(PlannerIdx);
+			continue;
+		}
+		const float Now = Planner->GetWorld()->GetTimeSeconds();
+		//Every goal of a planner reads the same published state
+		const FWorldStateSnapshot Snapshot = Planner->GetWorldStateSnapshot();
+		const int32 FirstGoal = BatchGoals.Num();
+		for (const TWeakObjectPtr<UGOAPGoal>& Goal : Registered.Goals)
+		{
+			BatchGoals.Add(Goal.Get());
+		}
+		for (const FBakedTerm& Term : Registered.Terms)
+		{
+			const UGOAPGoal* Goal = BatchGoals[FirstGoal + Term.GoalIdx];
+			if (!Goal)
+			{
+				continue;
+			}
+			TermInputs.Add(GatherInput(Term, *Planner, Snapshot.WS, *Goal, Now));
+			TermCurves.Add(Term.CurveIdx);
+			TermWeights.Add(Term.Weight);
+			TermGoals.Add(FirstGoal + Term.GoalIdx);
+		}
+	}
+
+	//Evaluate every term against the lookup tables in one tight loop
+	const int32 NumTerms = TermInputs.Num();
+	TermValues.SetNumUninitialized(NumTerms, false);
+	const FBakedCurve* Curves = BakedCurves.GetData();
+	for (int32 TermIdx = 0; TermIdx < NumTerms; ++TermIdx)
+	{
+		const FBakedCurve& Curve = Curves[TermCurves[TermIdx]];
+		const float T = FMath::Clamp((TermInputs[TermIdx] - Curve.MinTime) * Curve.InvStep, 0.f, float(NumCurveSamples - 1));
+		const int32 Lo = FMath::Min((int32)T, NumCurveSamples - 2);
+		TermValues[TermIdx] = TermWeights[TermIdx] * FMath::Lerp(Curve.Samples[Lo], Curve.Samples[Lo + 1], T - Lo);
+	}
+
+	GoalInsistence.Reset();
+	GoalInsistence.AddZeroed(BatchGoals.Num());
+	for (int32 TermIdx = 0; TermIdx < NumTerms; ++TermIdx)
+	{
+		GoalInsistence[TermGoals[TermIdx]] += TermValues[TermIdx];
+	}
+
+	//Publish, goals only notify their planner if the value actually changed
+	for (int32 GoalIdx = 0; GoalIdx < BatchGoals.Num(); ++GoalIdx)
+	{
+		if (BatchGoals[GoalIdx])
+		{
+			BatchGoals[GoalIdx]->SetInsistence(FMath::Max(GoalInsistence[GoalIdx], 0.f));
+		}
+	}
+}
+
+int32 UGOAPInsistenceSubsystem::FindOrBakeCurve(const UCurveFloat& Curve)
+{
+	const TWeakObjectPtr<const UCurveFloat> CurveKey(&Curve);
+	if (const int32* Found = CurveIndices.Find(CurveKey))
+	{
+		return *Found;
+	}
+	const int32 Index = BakedCurves.AddDefaulted();
+	BakeCurve(Curve, BakedCurves[Index]);
+	CurveIndices.Add(CurveKey, Index);
+	return Index;
+}
+
+void UGOAPInsistenceSubsystem::BakeCurve(const UCurveFloat& Curve, FBakedCurve& OutBaked)
+{
+	float MinTime = 0.f;
+	float MaxTime = 0.f;
+	Curve.GetTimeRange(MinTime, MaxTime);
+	const float Step = (MaxTime - MinTime) / (NumCurveSamples - 1);
+	OutBaked.MinTime = MinTime;
+	OutBaked.InvStep = (Step > KINDA_SMALL_NUMBER) ? 1.f / Step : 0.f;
+	for (int32 Sample = 0; Sample < NumCurveSamples; ++Sample)
+	{
+		OutBaked.Samples[Sample] = Curve.GetFloatValue(MinTime + Step * Sample);
+	}
+}
+
+UGOAPInsistenceSubsystem::FBakedTerm UGOAPInsistenceSubsystem::BakeTerm(const FInsistenceTerm& Term, const UPlannerComponent& Planner)
+{
+	FBakedTerm Baked;
+	Baked.CurveIdx = FindOrBakeCurve(*Term.Curve);
+	Baked.Weight = Term.Weight;
+	switch (Term.Input)
+	{
+	case EInsistenceInput::WSKey:
+		Baked.Input = (Term.WSKey != EWorldKey::SYMBOL_MAX) ? EBakedInput::WSKey : EBakedInput::None;
+		Baked.WSKey = Term.WSKey;
+		return Baked;
+	case EInsistenceInput::TimeSinceFinished:
+		Baked.Input = EBakedInput::TimeSinceFinished;
+		return Baked;
+	default:
+		break;
+	}
+
+	const UBlackboardComponent* BBComp = Planner.GetBlackboardComponent();
+	Baked.KeyID = BBComp ? BBComp->GetKeyID(Term.BBKeyName) : FBlackboard::InvalidKey;
+	if (Baked.KeyID == FBlackboard::InvalidKey)
+	{
+		return Baked;
+	}
+	const TSubclassOf<UBlackboardKeyType> KeyType = BBComp->GetKeyType(Baked.KeyID);
+	if (Term.Input == EInsistenceInput::BBValue)
+	{
+		if (KeyType == UBlackboardKeyType_Int::StaticClass())
+		{
+			Baked.Input = EBakedInput::BBInt;
+		}
+		else if (KeyType == UBlackboardKeyType_Float::StaticClass())
+		{
+			Baked.Input = EBakedInput::BBFloat;
+		}
+		else if (KeyType == UBlackboardKeyType_Bool::StaticClass())
+		{
+			Baked.Input = EBakedInput::BBBool;
+		}
+		else
+		{
+			UE_LOG(LogGoal, Warning, TEXT("%s: insistence term reads %s, which isn't an int, float or bool key"), *GetNameSafe(Planner.GetOwner()), *Term.BBKeyName.ToString());
+		}
+		return Baked;
+	}
+	//BBDistance
+	Baked.Input = (KeyType == UBlackboardKeyType_Object::StaticClass()) ? EBakedInput::BBObjectDistance : EBakedInput::BBLocationDistance;
+	return Baked;
+}
+
+float UGOAPInsistenceSubsystem::GatherInput(const FBakedTerm& Term, const UPlannerComponent& Planner, const FWorldState& WS, const UGOAPGoal& Goal, float Now) const
+{
+	switch (Term.Input)
+	{
+	case EBakedInput::WSKey:
+		return (float)WS.GetProp(Term.WSKey);
+	case EBakedInput::TimeSinceFinished:
+		return Now - Goal.GetLastFinishedTime();
+	case EBakedInput::None:
+		return 0.f;
+	default:
+		break;
+	}
+
+	const UBlackboardComponent* BBComp = Planner.GetBlackboardComponent();
+	if (!BBComp)
+	{
+		return 0.f;
+	}
+	switch (Term.Input)
+	{
+	case EBakedInput::BBInt:
+		return (float)BBComp->GetValue<UBlackboardKeyType_Int>(Term.KeyID);
+	case EBakedInput::BBFloat:
+		return BBComp->GetValue<UBlackboardKeyType_Float>(Term.KeyID);
+	case EBakedInput::BBBool:
+		return BBComp->GetValue<UBlackboardKeyType_Bool>(Term.KeyID) ? 1.f : 0.f;
+	default:
+		break;
+	}
+
+	//Distances
+	const AAIController* AIOwner = Planner.GetAIOwner();
+	const APawn* Pawn = AIOwner ? AIOwner->GetPawn() : nullptr;
+	if (!Pawn)
+	{
+		return 0.f;
+	}
+	FVector TargetLocation;
+	if (Term.Input == EBakedInput::BBObjectDistance)
+	{
+		const AActor* TargetActor = Cast<AActor>(BBComp->GetValue<UBlackboardKeyType_Object>(Term.KeyID));
+		if (!TargetActor)
+		{
+			return 0.f;
+		}
+		TargetLocation = TargetActor->GetActorLocation();
+	}
+	else if (!BBComp->GetLocationFromEntry(Term.KeyID, TargetLocation))
+	{
+		return 0.f;
+	}
+	return FVector::Dist(Pawn->GetActorLocation(), TargetLocation);
+}
@@ -0,0 +1,716 @@
+#include "../Public/GOAPPlannerSubsystem.h"
+#include "../Public/GOAPGoal.h"
+#include "../Public/GOAPStats.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+
+//FPlannerAgentBatch
+int32 FPlannerAgentBatch::Add()
+{
+	WorldStates.AddDefaulted();
+	DirtyKeys.Add(0);
+	ActionExpectedKeys.Add(0);
+	ActionExpectedValues.AddDefaulted();
+	GoalExpectedKeys.Add(0);
+	GoalExpectedValues.AddDefaulted();
+	ReplanCauses.Add(EReplanCause::NoPlan);
+	GoalStarts.Add(Goals.Num());
+	GoalCounts.Add(0);
+	SquadIndices.Add(INDEX_NONE);
+	LocalKeys.Add(0);
+	SquadVersions.Add(0);
+	Snapshots.Add(MakeShared<FWorldStateSnapshotStore, ESPMode::ThreadSafe>());
+	return Flags.Add(0);
+}
+
+void FPlannerAgentBatch::RemoveAtSwap(int32 AgentIdx)
+{
+	LeaveSquad(AgentIdx);
+
+	//Goals stay packed, so everything after the removed range moves down
+	const int32 Start = GoalStarts[AgentIdx];
+	const int32 Count = GoalCounts[AgentIdx];
+	if (Count > 0)
+	{
+		Goals.RemoveAt(Start, Count, false);
+		for (int32& OtherStart : GoalStarts)
+		{
+			if (OtherStart > Start)
+			{
+				OtherStart -= Count;
+			}
+		}
+	}
+
+	WorldStates.RemoveAtSwap(AgentIdx, 1, false);
+	DirtyKeys.RemoveAtSwap(AgentIdx, 1, false);
+	ActionExpectedKeys.RemoveAtSwap(AgentIdx, 1, false);
+	ActionExpectedValues.RemoveAtSwap(AgentIdx, 1, false);
+	GoalExpectedKeys.RemoveAtSwap(AgentIdx, 1, false);
+	GoalExpectedValues.RemoveAtSwap(AgentIdx, 1, false);
+	Flags.RemoveAtSwap(AgentIdx, 1, false);
+	ReplanCauses.RemoveAtSwap(AgentIdx, 1, false);
+	GoalStarts.RemoveAtSwap(AgentIdx, 1, false);
+	GoalCounts.RemoveAtSwap(AgentIdx, 1, false);
+	SquadIndices.RemoveAtSwap(AgentIdx, 1, false);
+	LocalKeys.RemoveAtSwap(AgentIdx, 1, false);
+	SquadVersions.RemoveAtSwap(AgentIdx, 1, false);
+	Snapshots.RemoveAtSwap(AgentIdx, 1, false);
+}
+
+SIZE_T FPlannerAgentBatch::GetAllocatedSize() const
+{
+	return WorldStates.GetAllocatedSize() + DirtyKeys.GetAllocatedSize()
+		+ ActionExpectedKeys.GetAllocatedSize() + ActionExpectedValues.GetAllocatedSize()
+		+ GoalExpectedKeys.GetAllocatedSize() + GoalExpectedValues.GetAllocatedSize()
+		+ Flags.GetAllocatedSize() + ReplanCauses.GetAllocatedSize()
+		+ GoalStarts.GetAllocatedSize() + GoalCounts.GetAllocatedSize() + Goals.GetAllocatedSize()
+		+ SquadIndices.GetAllocatedSize() + LocalKeys.GetAllocatedSize() + SquadVersions.GetAllocatedSize()
+		+ Squads.GetAllocatedSize() + Snapshots.GetAllocatedSize() + Snapshots.Num() * sizeof(FWorldStateSnapshotStore);
+}
+
+void FPlannerAgentBatch::SetGoals(int32 AgentIdx, TArray<FBatchedGoal>& InGoals)
+{
+	//Goals are only set once per agent, when it starts, so appending keeps them packed
+	if (GoalCounts[AgentIdx] > 0)
+	{
+		const int32 Start = GoalStarts[AgentIdx];
+		const int32 Count = GoalCounts[AgentIdx];
+		Goals.RemoveAt(Start, Count, false);
+		for (int32& OtherStart : GoalStarts)
+		{
+			if (OtherStart > Start)
+			{
+				OtherStart -= Count;
+			}
+		}
+	}
+	GoalStarts[AgentIdx] = Goals.Num();
+	GoalCounts[AgentIdx] = InGoals.Num();
+	for (FBatchedGoal& Goal : InGoals)
+	{
+		Goals.Add(MoveTemp(Goal));
+	}
+}
+
+void FPlannerAgentBatch::AddExpected(int32 AgentIdx, bool bGoal, EWorldKey Key, uint8 Value)
+{
+	if (bGoal)
+	{
+		GoalExpectedKeys[AgentIdx] |= 1u << (uint32)Key;
+		GoalExpectedValues[AgentIdx].SetProp(Key, Value);
+	}
+	else
+	{
+		ActionExpectedKeys[AgentIdx] |= 1u << (uint32)Key;
+		ActionExpectedValues[AgentIdx].SetProp(Key, Value);
+	}
+}
+
+void FPlannerAgentBatch::ClearExpected(int32 AgentIdx, bool bAction, bool bGoal)
+{
+	if (bAction)
+	{
+		ActionExpectedKeys[AgentIdx] = 0;
+	}
+	if (bGoal)
+	{
+		GoalExpectedKeys[AgentIdx] = 0;
+	}
+}
+
+int32 FPlannerAgentBatch::CreateSquad(uint32 SharedKeys, const FWorldState& InitialWS)
+{
+	int32 SquadIdx = Squads.IndexOfByPredicate([](const FSquadWorldState& Squad) { return !Squad.bInUse; });
+	if (SquadIdx == INDEX_NONE)
+	{
+		SquadIdx = Squads.AddDefaulted();
+	}
+	FSquadWorldState& Squad = Squads[SquadIdx];
+	Squad.WS = InitialWS;
+	Squad.SharedKeys = SharedKeys;
+	//Versions keep counting through reuse so old members can't mistake the new squad for theirs
+	Squad.Version += 1;
+	Squad.NumMembers = 0;
+	Squad.bInUse = true;
+	return SquadIdx;
+}
+
+void FPlannerAgentBatch::DestroySquad(int32 SquadIdx)
+{
+	if (!Squads.IsValidIndex(SquadIdx) || !Squads[SquadIdx].bInUse)
+	{
+		return;
+	}
+	for (int32 AgentIdx = 0; AgentIdx < Num() && Squads[SquadIdx].NumMembers > 0; ++AgentIdx)
+	{
+		if (SquadIndices[AgentIdx] == SquadIdx)
+		{
+			LeaveSquad(AgentIdx);
+		}
+	}
+	Squads[SquadIdx].bInUse = false;
+}
+
+void FPlannerAgentBatch::JoinSquad(int32 AgentIdx, int32 SquadIdx)
+{
+	LeaveSquad(AgentIdx);
+	if (!Squads.IsValidIndex(SquadIdx) || !Squads[SquadIdx].bInUse)
+	{
+		return;
+	}
+	FSquadWorldState& Squad = Squads[SquadIdx];
+	//The first member seeds the shared facts
+	if (Squad.NumMembers == 0)
+	{
+		uint32 SharedKeys = Squad.SharedKeys;
+		while (SharedKeys != 0)
+		{
+			const uint32 KeyIdx = FPlatformMath::CountTrailingZeros(SharedKeys);
+			SharedKeys &= SharedKeys - 1;
+			Squad.WS.SetProp((EWorldKey)KeyIdx, WorldStates[AgentIdx].GetProp((EWorldKey)KeyIdx));
+		}
+		Squad.Version += 1;
+	}
+	Squad.NumMembers += 1;
+	SquadIndices[AgentIdx] = SquadIdx;
+	LocalKeys[AgentIdx] = 0;
+	SquadVersions[AgentIdx] = Squad.Version - 1;
+	SyncSquad(AgentIdx);
+}
+
+void FPlannerAgentBatch::LeaveSquad(int32 AgentIdx)
+{
+	const int32 SquadIdx = SquadIndices[AgentIdx];
+	if (SquadIdx == INDEX_NONE)
+	{
+		return;
+	}
+	//The synced values are already in WorldStates, so they just stop updating
+	SyncSquad(AgentIdx);
+	Squads[SquadIdx].NumMembers -= 1;
+	SquadIndices[AgentIdx] = INDEX_NONE;
+	LocalKeys[AgentIdx] = 0;
+}
+
+void FPlannerAgentBatch::SetSquadProp(int32 SquadIdx, EWorldKey Key, uint8 Value)
+{
+	FSquadWorldState& Squad = Squads[SquadIdx];
+	checkSlow(Squad.bInUse);
+	if (Squad.WS.GetProp(Key) != Value)
+	{
+		Squad.WS.SetProp(Key, Value);
+		Squad.Version += 1;
+	}
+}
+
+bool FPlannerAgentBatch::IsSharedKey(int32 AgentIdx, EWorldKey Key) const
+{
+	const int32 SquadIdx = SquadIndices[AgentIdx];
+	return SquadIdx != INDEX_NONE && (Squads[SquadIdx].SharedKeys & (1u << (uint32)Key)) != 0;
+}
+
+void FPlannerAgentBatch::WriteSharedKey(int32 AgentIdx, EWorldKey Key)
+{
+	if (IsSharedKey(AgentIdx, Key) && (LocalKeys[AgentIdx] & (1u << (uint32)Key)) == 0)
+	{
+		//Our next sync finds the value we already have, so only the other members see a change
+		SetSquadProp(SquadIndices[AgentIdx], Key, WorldStates[AgentIdx].GetProp(Key));
+	}
+}
+
+bool FPlannerAgentBatch::ApplyEffect(int32 AgentIdx, const FAISymEffect& Effect)
+{
+	if (!WorldStates[AgentIdx].ApplyEffect(Effect))
+	{
+		return false;
+	}
+	WriteSharedKey(AgentIdx, Effect.Key);
+	return true;
+}
+
+void FPlannerAgentBatch::OverrideSquadKey(int32 AgentIdx, EWorldKey Key)
+{
+	if (IsSharedKey(AgentIdx, Key))
+	{
+		LocalKeys[AgentIdx] |= 1u << (uint32)Key;
+	}
+}
+
+void FPlannerAgentBatch::RevertSquadKey(int32 AgentIdx, EWorldKey Key)
+{
+	if (LocalKeys[AgentIdx] & (1u << (uint32)Key))
+	{
+		LocalKeys[AgentIdx] &= ~(1u << (uint32)Key);
+		//Force the next sync even if the squad didn't change
+		SquadVersions[AgentIdx] -= 1;
+	}
+}
+
+void FPlannerAgentBatch::SyncSquad(int32 AgentIdx)
+{
+	const int32 SquadIdx = SquadIndices[AgentIdx];
+	if (SquadIdx == INDEX_NONE)
+	{
+		return;
+	}
+	const FSquadWorldState& Squad = Squads[SquadIdx];
+	if (SquadVersions[AgentIdx] == Squad.Version)
+	{
+		return;
+	}
+	SquadVersions[AgentIdx] = Squad.Version;
+
+	FWorldState& WS = WorldStates[AgentIdx];
+	uint32 Inherited = Squad.SharedKeys & ~LocalKeys[AgentIdx];
+	while (Inherited != 0)
+	{
+		const uint32 KeyIdx = FPlatformMath::CountTrailingZeros(Inherited);
+		Inherited &= Inherited - 1;
+		const uint8 Value = Squad.WS.GetProp((EWorldKey)KeyIdx);
+		if (WS.GetProp((EWorldKey)KeyIdx) != Value)
+		{
+			WS.SetProp((EWorldKey)KeyIdx, Value);
+			//Same path as the agent's own writes, so expected effects still apply
+			DirtyKeys[AgentIdx] |= 1u << KeyIdx;
+		}
+	}
+}
+
+namespace
+{
+	//Keys in Mask that hold the same value in both states
+	FORCEINLINE uint32 MatchingKeys(const FWorldState& WS, const FWorldState& Expected, uint32 Mask)
+	{
+		uint32 Matching = 0;
+		while (Mask != 0)
+		{
+			const uint32 KeyIdx = FPlatformMath::CountTrailingZeros(Mask);
+			Mask &= Mask - 1;
+			if (WS.GetProp((EWorldKey)KeyIdx) == Expected.GetProp((EWorldKey)KeyIdx))
+			{
+				Matching |= 1u << KeyIdx;
+			}
+		}
+		return Matching;
+	}
+}
+
+void FPlannerAgentBatch::CheckExpectedEffects(int32 AgentIdx)
+{
+	uint32 Dirty = DirtyKeys[AgentIdx];
+	if (Dirty == 0)
+	{
+		return;
+	}
+	DirtyKeys[AgentIdx] = 0;
+	Flags[AgentIdx] |= EPlannerAgentFlags::GoalsDirty;
+
+	//Writes the current action or goal said would happen don't invalidate the plan
+	if (HasFlag(AgentIdx, EPlannerAgentFlags::HasCurrentAction))
+	{
+		const FWorldState& WS = WorldStates[AgentIdx];
+		Dirty &= ~MatchingKeys(WS, ActionExpectedValues[AgentIdx], Dirty & ActionExpectedKeys[AgentIdx]);
+		Dirty &= ~MatchingKeys(WS, GoalExpectedValues[AgentIdx], Dirty & GoalExpectedKeys[AgentIdx]);
+	}
+	if (Dirty != 0)
+	{
+		Flags[AgentIdx] |= EPlannerAgentFlags::ReplanNeeded;
+		ReplanCauses[AgentIdx] = EReplanCause::WorldStateChanged;
+	}
+}
+
+void FPlannerAgentBatch::ValidateGoals(int32 AgentIdx)
+{
+	if (!HasFlag(AgentIdx, EPlannerAgentFlags::GoalsDirty))
+	{
+		return;
+	}
+	Flags[AgentIdx] &= ~EPlannerAgentFlags::GoalsDirty;
+
+	const FWorldState& WS = WorldStates[AgentIdx];
+	const int32 End = GoalStarts[AgentIdx] + GoalCounts[AgentIdx];
+	for (int32 GoalIdx = GoalStarts[AgentIdx]; GoalIdx < End; ++GoalIdx)
+	{
+		FBatchedGoal& Goal = Goals[GoalIdx];
+		bool bValid = true;
+		for (const FWorldProperty& Precondition : Goal.Preconditions)
+		{
+			if (!WS.CheckCondition(Precondition))
+			{
+				bValid = false;
+				break;
+			}
+		}
+		if (bValid != Goal.bValid)
+		{
+			Goal.bValid = bValid;
+			Goal.bChanged = true;
+			Flags[AgentIdx] |= EPlannerAgentFlags::GoalsChanged;
+		}
+	}
+}
+
+void FPlannerAgentBatch::RunPasses(bool bForceSingleThread)
+{
+	const int32 NumAgents = Num();
+	const int32 NumChunks = FMath::DivideAndRoundUp(NumAgents, AgentsPerChunk);
+
+	//Every agent only touches its own entries and squads are read only here, so chunks don't need any locking
+	ParallelFor(NumChunks, [this, NumAgents](int32 ChunkIdx)
+	{
+		const int32 End = FMath::Min((ChunkIdx + 1) * AgentsPerChunk, NumAgents);
+		for (int32 AgentIdx = ChunkIdx * AgentsPerChunk; AgentIdx < End; ++AgentIdx)
+		{
+			SyncSquad(AgentIdx);
+			CheckExpectedEffects(AgentIdx);
+		}
+	}, bForceSingleThread);
+
+	ParallelFor(NumChunks, [this, NumAgents](int32 ChunkIdx)
+	{
+		const int32 End = FMath::Min((ChunkIdx + 1) * AgentsPerChunk, NumAgents);
+		for (int32 AgentIdx = ChunkIdx * AgentsPerChunk; AgentIdx < End; ++AgentIdx)
+		{
+			ValidateGoals(AgentIdx);
+		}
+	}, bForceSingleThread);
+}
+
+int32 FPlannerAgentBatch::PublishSnapshots()
+{
+	//A publish is a 16 byte compare and at most one copy, not worth going wide for
+	int32 NumPublished = 0;
+	for (int32 AgentIdx = 0; AgentIdx < Num(); ++AgentIdx)
+	{
+		NumPublished += Snapshots[AgentIdx]->Publish(WorldStates[AgentIdx]) ? 1 : 0;
+	}
+	++PublishEpoch;
+	return NumPublished;
+}
+
+//UGOAPPlannerSubsystem
+UGOAPPlannerSubsystem* UGOAPPlannerSubsystem::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UGOAPPlannerSubsystem>() : nullptr;
+}
+
+int32 UGOAPPlannerSubsystem::RegisterAgent(UPlannerComponent& Planner)
+{
+	Owners.Add(&Planner);
+	return Agents.Add();
+}
+
+void UGOAPPlannerSubsystem::UnregisterAgent(int32 AgentIdx)
+{
+	if (!Owners.IsValidIndex(AgentIdx))
+	{
+		return;
+	}
+	if (bUpdatingAgents)
+	{
+		Owners[AgentIdx] = nullptr;
+		PendingRemovals.AddUnique(AgentIdx);
+		return;
+	}
+	RemoveAgent(AgentIdx);
+}
+
+void UGOAPPlannerSubsystem::RemoveAgent(int32 AgentIdx)
+{
+	Agents.RemoveAtSwap(AgentIdx);
+	Owners.RemoveAtSwap(AgentIdx, 1, false);
+	//The last agent took the removed slot
+	if (Owners.IsValidIndex(AgentIdx))
+	{
+		if (UPlannerComponent* Moved = Owners[AgentIdx].Get())
+		{
+			Moved->AgentIndex = AgentIdx;
+		}
+	}
+}
+
+void UGOAPPlannerSubsystem::SetAgentGoals(int32 AgentIdx, const TArray<UGOAPGoal*>& InGoals)
+{
+	TArray<FBatchedGoal> Batched;
+	Batched.Reserve(InGoals.Num());
+	for (UGOAPGoal* Goal : InGoals)
+	{
+		FBatchedGoal& Entry = Batched[Batched.AddDefaulted()];
+		Entry.Goal = Goal;
+		Entry.Preconditions.Append(Goal->GetPreconditions());
+		Entry.bValid = Goal->IsValid();
+	}
+	Agents.SetGoals(AgentIdx, Batched);
+}
+
+int32 UGOAPPlannerSubsystem::CreateSquad(const TArray<EWorldKey>& SharedKeys)
+{
+	uint32 KeyMask = 0;
+	for (EWorldKey Key : SharedKeys)
+	{
+		if (Key != EWorldKey::SYMBOL_MAX)
+		{
+			KeyMask |= 1u << (uint32)Key;
+		}
+	}
+	return Agents.CreateSquad(KeyMask, FWorldState());
+}
+
+void UGOAPPlannerSubsystem::DestroySquad(int32 SquadId)
+{
+	Agents.DestroySquad(SquadId);
+}
+
+void UGOAPPlannerSubsystem::SetSquadWSProp(int32 SquadId, EWorldKey Key, uint8 Value)
+{
+	if (Agents.Squads.IsValidIndex(SquadId) && Agents.Squads[SquadId].bInUse
+		&& ensureMsgf(FWorldStateLayout::IsValidValue(Key, Value), TEXT("Squad value %d doesn't fit world state key %d"), Value, (int32)Key))
+	{
+		Agents.SetSquadProp(SquadId, Key, Value);
+	}
+}
+
+void UGOAPPlannerSubsystem::PostWSProp(UPlannerComponent* Agent, EWorldKey Key, uint8 Value)
+{
+	if (Agent && ensureMsgf(FWorldStateLayout::IsValidValue(Key, Value), TEXT("Posted value %d doesn't fit world state key %d"), Value, (int32)Key))
+	{
+		FPostedWSWrite Write;
+		Write.Agent = Agent;
+		Write.Key = Key;
+		Write.Value = Value;
+		PostedWrites.Enqueue(Write);
+	}
+}
+
+void UGOAPPlannerSubsystem::RequestBindingSync(UPlannerComponent& Agent)
+{
+	BindingSyncs.Add(&Agent);
+}
+
+void UGOAPPlannerSubsystem::ApplyBindingSyncs()
+{
+	if (BindingSyncs.Num() == 0)
+	{
+		return;
+	}
+	INC_DWORD_STAT_BY(STAT_GOAP_BindingSyncs, BindingSyncs.Num());
+	CSV_CUSTOM_STAT(GOAP, BindingSyncs, BindingSyncs.Num(), ECsvCustomStatOp::Accumulate);
+
+	//Blackboard changes made while syncing wait for the next frame
+	TArray<TWeakObjectPtr<UPlannerComponent>> Syncs = MoveTemp(BindingSyncs);
+	BindingSyncs.Reset();
+	for (const TWeakObjectPtr<UPlannerComponent>& Agent : Syncs)
+	{
+		if (UPlannerComponent* Planner = Agent.Get())
+		{
+			Planner->SyncBlackboardBindings();
+		}
+	}
+}
+
+void UGOAPPlannerSubsystem::ApplyPostedWrites()
+{
+	check(IsInGameThread());
+	if (PostedWrites.IsEmpty())
+	{
+		return;
+	}
+	PostedKeys.SetNumZeroed(Agents.Num());
+	PostedValues.SetNum(Agents.Num());
+
+	//Queue order is post order, so overwriting keeps the last writer
+	int32 NumWrites = 0;
+	FPostedWSWrite Write;
+	while (PostedWrites.Dequeue(Write))
+	{
+		++NumWrites;
+		const UPlannerComponent* Planner = Write.Agent.Get();
+		if (!Planner || !PostedKeys.IsValidIndex(Planner->AgentIndex))
+		{
+			continue;
+		}
+		const int32 AgentIdx = Planner->AgentIndex;
+		if (PostedKeys[AgentIdx] == 0)
+		{
+			PostedAgents.Add(AgentIdx);
+		}
+		PostedKeys[AgentIdx] |= 1u << (uint32)Write.Key;
+		PostedValues[AgentIdx].SetProp(Write.Key, Write.Value);
+	}
+	INC_DWORD_STAT_BY(STAT_GOAP_PostedWrites, NumWrites);
+	CSV_CUSTOM_STAT(GOAP, PostedWrites, NumWrites, ECsvCustomStatOp::Accumulate);
+
+	for (int32 AgentIdx : PostedAgents)
+	{
+		if (UPlannerComponent* Planner = Owners[AgentIdx].Get())
+		{
+			for (uint32 Key = 0; Key < (uint32)EWorldKey::SYMBOL_MAX; ++Key)
+			{
+				if (PostedKeys[AgentIdx] & (1u << Key))
+				{
+					Planner->SetWSProp((EWorldKey)Key, PostedValues[AgentIdx].GetProp((EWorldKey)Key));
+				}
+			}
+		}
+		PostedKeys[AgentIdx] = 0;
+	}
+	PostedAgents.Reset();
+}
+
+void UGOAPPlannerSubsystem::Deinitialize()
+{
+	Agents = FPlannerAgentBatch();
+	Owners.Reset();
+	PendingRemovals.Reset();
+	PostedWrites.Empty();
+	BindingSyncs.Reset();
+	Super::Deinitialize();
+}
+
+void UGOAPPlannerSubsystem::ApplyGoalChanges(int32 AgentIdx, UPlannerComponent& Planner)
+{
+	const int32 End = Agents.GoalStarts[AgentIdx] + Agents.GoalCounts[AgentIdx];
+	for (int32 GoalIdx = Agents.GoalStarts[AgentIdx]; GoalIdx < End; ++GoalIdx)
+	{
+		FBatchedGoal& Goal = Agents.Goals[GoalIdx];
+		if (Goal.bChanged)
+		{
+			Goal.bChanged = false;
+			if (Goal.Goal->SetValidity(Goal.bValid))
+			{
+				Planner.OnGoalPriorityChanged(*Goal.Goal);
+			}
+		}
+	}
+}
+
+void UGOAPPlannerSubsystem::Tick(float DeltaTime)
+{
+	//Components that went away without Cleanup
+	for (int32 AgentIdx = Owners.Num() - 1; AgentIdx >= 0; --AgentIdx)
+	{
+		if (!Owners[AgentIdx].IsValid())
+		{
+			RemoveAgent(AgentIdx);
+		}
+	}
+
+	//Sensor writes from other threads and blackboard bindings land before the batch checks them against the expected effects.
+	//A binding wins over a posted write to the same key
+	ApplyPostedWrites();
+	ApplyBindingSyncs();
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_GOAP_AgentBatch);
+		CSV_SCOPED_TIMING_STAT(GOAP, AgentBatch);
+		Agents.RunPasses();
+	}
+
+	//Planners can start new planners from here, those wait for the next frame
+	bUpdatingAgents = true;
+	const int32 NumAgents = Owners.Num();
+	for (int32 AgentIdx = 0; AgentIdx < NumAgents; ++AgentIdx)
+	{
+		UPlannerComponent* Planner = Owners[AgentIdx].Get();
+		if (!Planner)
+		{
+			continue;
+		}
+		if (Agents.HasFlag(AgentIdx, EPlannerAgentFlags::GoalsChanged))
+		{
+			Agents.SetFlag(AgentIdx, EPlannerAgentFlags::GoalsChanged, false);
+			ApplyGoalChanges(AgentIdx, *Planner);
+		}
+		if (!Agents.HasFlag(AgentIdx, EPlannerAgentFlags::Running))
+		{
+			continue;
+		}
+		if (Agents.HasFlag(AgentIdx, EPlannerAgentFlags::PlanUpdateNeeded))
+		{
+			Planner->UpdatePlanExecution();
+		}
+		//Do any replans last
+		if (Owners[AgentIdx].IsValid() && (Agents.HasFlag(AgentIdx, EPlannerAgentFlags::ReplanNeeded) || !Agents.HasFlag(AgentIdx, EPlannerAgentFlags::HasPlan)))
+		{
+			//Squad members replan together below
+			if (Agents.SquadIndices[AgentIdx] != INDEX_NONE)
+			{
+				SquadReplans.Add(AgentIdx);
+				continue;
+			}
+			Planner->ProcessReplanRequest();
+		}
+	}
+	ProcessSquadReplans();
+	bUpdatingAgents = false;
+
+	//Highest first, so the agent swapped into a removed slot is never one still waiting to be removed
+	PendingRemovals.Sort(TGreater<int32>());
+	for (int32 AgentIdx : PendingRemovals)
+	{
+		RemoveAgent(AgentIdx);
+	}
+	PendingRemovals.Reset();
+
+	//Everything that changes the world state this frame has run, readers get it all in one version
+	const int32 NumPublished = Agents.PublishSnapshots();
+	INC_DWORD_STAT_BY(STAT_GOAP_PublishedSnapshots, NumPublished);
+	CSV_CUSTOM_STAT(GOAP, PublishedSnapshots, NumPublished, ECsvCustomStatOp::Accumulate);
+
+	SET_DWORD_STAT(STAT_GOAP_FringePeak, FrameFringePeak);
+	FrameFringePeak = 0;
+}
+
+void UGOAPPlannerSubsystem::AddSearchStats(const FPlannerSearchStats& Stats)
+{
+	check(IsInGameThread());
+	FrameFringePeak = FMath::Max(FrameFringePeak, Stats.FringePeak);
+}
+
+void UGOAPPlannerSubsystem::ProcessSquadReplans()
+{
+	if (SquadReplans.Num() == 0)
+	{
+		return;
+	}
+	//A context per squad with members replanning, filled in one pass over the agents since role
+	//limits count every member, not just the ones replanning
+	SquadContexts.Reset();
+	for (int32 AgentIdx : SquadReplans)
+	{
+		SquadContexts.FindOrAdd(Agents.SquadIndices[AgentIdx]);
+	}
+	for (int32 AgentIdx = 0; AgentIdx < Owners.Num(); ++AgentIdx)
+	{
+		const int32 SquadIdx = Agents.SquadIndices[AgentIdx];
+		FSquadPlanContext* Context = (SquadIdx != INDEX_NONE) ? SquadContexts.Find(SquadIdx) : nullptr;
+		const UPlannerComponent* Member = Context ? Owners[AgentIdx].Get() : nullptr;
+		if (Member && Member->GetCurrentGoalIndex() != INDEX_NONE)
+		{
+			Context->Assign(Member->Asset, Member->GetCurrentGoalIndex(), 1);
+		}
+	}
+
+	//SquadReplans is in agent order, so the first member to solve a goal is the one that shares its plan
+	for (int32 AgentIdx : SquadReplans)
+	{
+		if (UPlannerComponent* Planner = Owners[AgentIdx].Get())
+		{
+			//Null if an earlier replan took the agent out of its squad
+			Planner->ProcessReplanRequest(SquadContexts.Find(Agents.SquadIndices[AgentIdx]));
+		}
+	}
+	SquadReplans.Reset();
+}
+
+bool UGOAPPlannerSubsystem::IsTickable() const
+{
+	return !HasAnyFlags(RF_ClassDefaultObject) && Owners.Num() != 0;
+}
+
+TStatId UGOAPPlannerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGOAPPlannerSubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,26 @@
+#include "../Public/GOAPStats.h"
+
+DEFINE_STAT(STAT_GOAP_Search);
+DEFINE_STAT(STAT_GOAP_Successors);
+DEFINE_STAT(STAT_GOAP_ChainBackward);
+DEFINE_STAT(STAT_GOAP_ProcessReplan);
+DEFINE_STAT(STAT_GOAP_UpdatePlanExecution);
+DEFINE_STAT(STAT_GOAP_ServiceTick);
+DEFINE_STAT(STAT_GOAP_GoalValidation);
+DEFINE_STAT(STAT_GOAP_AgentBatch);
+DEFINE_STAT(STAT_GOAP_InsistenceUpdate);
+
+DEFINE_STAT(STAT_GOAP_NodesExpanded);
+DEFINE_STAT(STAT_GOAP_NodesGenerated);
+DEFINE_STAT(STAT_GOAP_DuplicateHits);
+DEFINE_STAT(STAT_GOAP_Reparents);
+DEFINE_STAT(STAT_GOAP_MutexPrunes);
+DEFINE_STAT(STAT_GOAP_FringePeak);
+DEFINE_STAT(STAT_GOAP_Replans);
+DEFINE_STAT(STAT_GOAP_SquadSharedPlans);
+DEFINE_STAT(STAT_GOAP_SquadSearches);
+DEFINE_STAT(STAT_GOAP_PostedWrites);
+DEFINE_STAT(STAT_GOAP_BindingSyncs);
+DEFINE_STAT(STAT_GOAP_PublishedSnapshots);
+
+CSV_DEFINE_CATEGORY_MODULE(GOAPPROJECT_API, GOAP, true);
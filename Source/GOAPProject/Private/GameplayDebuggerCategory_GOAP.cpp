@@ -2,12 +2,16 @@
 
 #if WITH_GAMEPLAY_DEBUGGER
 
-
+#include "../Public/PlannerComponent.h"
+#include "../Public/GOAPAction.h"
+#include "../Public/GOAPGoal.h"
 #include "GameFramework/Pawn.h"
+#include "AIController.h"
+#include "Engine/World.h"
 
 FGameplayDebuggerCategory_GOAP::FGameplayDebuggerCategory_GOAP()
 {
-
+	SetDataPackReplication<FRepData>(&DataPack);
 }
 
 TSharedRef<FGameplayDebuggerCategory> FGameplayDebuggerCategory_GOAP::MakeInstance()
@@ -15,13 +19,122 @@ TSharedRef<FGameplayDebuggerCategory> FGameplayDebuggerCategory_GOAP::MakeInstan
 	return MakeShareable(new FGameplayDebuggerCategory_GOAP());
 }
 
-void FGameplayDebuggerCategory_GOAP::CollectData(APlayerController* OwnerPC, AActor* DebugActor) 
+void FGameplayDebuggerCategory_GOAP::FRepData::Serialize(FArchive& Ar)
+{
+	Ar << PlannerName;
+	Ar << GoalName;
+	Ar << PlanSteps;
+	Ar << CurrentStep;
+	Ar << WorldStateValues;
+	Ar << MeanSearchMs;
+	Ar << MaxSearchMs;
+	Ar << LastNodesExpanded;
+	Ar << ReplanCount;
+	Ar << ReplanCauses;
+	Ar << DuplicateRate;
+	Ar << CacheHitRate;
+	Ar << TimeSinceReplan;
+}
+
+UPlannerComponent* FGameplayDebuggerCategory_GOAP::FindPlannerComponent(AActor* DebugActor)
 {
 	APawn* MyPawn = Cast<APawn>(DebugActor);
-	if (MyPawn)
+	AAIController* Controller = MyPawn ? Cast<AAIController>(MyPawn->GetController()) : nullptr;
+	if (!Controller)
 	{
+		return nullptr;
+	}
+	UPlannerComponent* PlannerComp = Cast<UPlannerComponent>(Controller->GetBrainComponent());
+	return PlannerComp ? PlannerComp : Controller->FindComponentByClass<UPlannerComponent>();
+}
+
+void FGameplayDebuggerCategory_GOAP::CollectData(APlayerController* OwnerPC, AActor* DebugActor) 
+{
+	DataPack = FRepData();
+
+	UPlannerComponent* PlannerComp = FindPlannerComponent(DebugActor);
+	if (!PlannerComp)
+	{
+		return;
+	}
+
+	DataPack.PlannerName = GetNameSafe(PlannerComp->GetOwner());
+	UGOAPGoal* Goal = PlannerComp->GetCurrentGoal();
+	DataPack.GoalName = Goal ? Goal->GetTaskName() : FString(TEXT("None"));
+
+	const FPlanInstance& Plan = PlannerComp->GetPlanInstance();
+	for (int32 Offset = 0; Offset < Plan.Num(); ++Offset)
+	{
+		const FPlanStepInfo& Step = Plan.GetStep(Offset);
+		DataPack.PlanSteps.Add(Step.Action ? Step.Action->GetActionName() : FString(TEXT("None")));
+	}
+	//Steps are listed from the head of the ring
+	DataPack.CurrentStep = Plan.HasCurrentAction() ? 0 : INDEX_NONE;
+
+	const FWorldState& WorldState = PlannerComp->GetWorldState();
+	for (uint32 Key = 0; Key < WorldState.Num(); ++Key)
+	{
+		DataPack.WorldStateValues.Add(PlannerComp->DescribeWSValue((EWorldKey)Key, WorldState.GetProp((EWorldKey)Key)));
+	}
 
+	const FPlannerDebugStats& Stats = PlannerComp->GetDebugStats();
+	DataPack.MeanSearchMs = Stats.GetMeanSearchMs();
+	DataPack.MaxSearchMs = Stats.GetMaxSearchMs();
+	DataPack.LastNodesExpanded = Stats.LastNodesExpanded;
+	DataPack.ReplanCount = Stats.ReplanCount;
+	DataPack.ReplanCauses.Append(Stats.ReplanCauses, (int32)EReplanCause::MAX);
+	DataPack.DuplicateRate = Stats.GetDuplicateRate();
+	DataPack.CacheHitRate = Stats.GetCacheHitRate();
+	if (Stats.ReplanCount > 0)
+	{
+		DataPack.TimeSinceReplan = PlannerComp->GetWorld()->GetTimeSeconds() - Stats.LastReplanTime;
+	}
+}
+
+void FGameplayDebuggerCategory_GOAP::DrawData(APlayerController* OwnerPC, FGameplayDebuggerCanvasContext& CanvasContext)
+{
+	if (DataPack.PlannerName.IsEmpty())
+	{
+		CanvasContext.Print(TEXT("{red}No planner component"));
+		return;
+	}
+
+	CanvasContext.Printf(TEXT("Planner: {yellow}%s"), *DataPack.PlannerName);
+	CanvasContext.Printf(TEXT("Goal: {yellow}%s"), *DataPack.GoalName);
+	for (int32 Idx = 0; Idx < DataPack.PlanSteps.Num(); ++Idx)
+	{
+		const TCHAR* Color = (Idx == DataPack.CurrentStep) ? TEXT("{green}") : TEXT("{grey}");
+		CanvasContext.Printf(TEXT("  %s%d. %s"), Color, Idx, *DataPack.PlanSteps[Idx]);
+	}
+
+	CanvasContext.Printf(TEXT("Search: {white}%.3f ms avg, %.3f ms max, %d nodes last"), DataPack.MeanSearchMs, DataPack.MaxSearchMs, DataPack.LastNodesExpanded);
+	CanvasContext.Printf(TEXT("Duplicate nodes: {white}%.1f%%{grey}, action and squad plan cache hits: {white}%.1f%%"), DataPack.DuplicateRate * 100.f, DataPack.CacheHitRate * 100.f);
+	if (DataPack.TimeSinceReplan >= 0.f)
+	{
+		CanvasContext.Printf(TEXT("Replans: {white}%d, last %.2fs ago"), DataPack.ReplanCount, DataPack.TimeSinceReplan);
+	}
+	else
+	{
+		CanvasContext.Printf(TEXT("Replans: {white}%d"), DataPack.ReplanCount);
+	}
+
+	const UEnum* CauseEnum = StaticEnum<EReplanCause>();
+	FString Causes;
+	for (int32 Idx = 0; Idx < DataPack.ReplanCauses.Num(); ++Idx)
+	{
+		if (DataPack.ReplanCauses[Idx] > 0)
+		{
+			Causes += FString::Printf(TEXT("%s: %d  "), *CauseEnum->GetNameStringByValue(Idx), DataPack.ReplanCauses[Idx]);
+		}
+	}
+	CanvasContext.Printf(TEXT("  {grey}%s"), *Causes);
+
+	const UEnum* KeyEnum = StaticEnum<EWorldKey>();
+	CanvasContext.Print(TEXT("WorldState"));
+	for (int32 Key = 0; Key < DataPack.WorldStateValues.Num(); ++Key)
+	{
+		CanvasContext.Printf(TEXT("  %s: {white}%s"), *KeyEnum->GetNameStringByValue(Key), *DataPack.WorldStateValues[Key]);
 	}
 }
 
-#endif //WITH_GAMEPLAY_DEBUGGER
\ No newline at end of file
+#endif //WITH_GAMEPLAY_DEBUGGER
@@ -1 +1,136 @@
-#include "..\Public\PlannerAsset.h"
\ No newline at end of file
+#include "..\Public\PlannerAsset.h"
+#include "../Public/GOAPAction.h"
+#include "../Public/GOAPGoal.h"
+#include "../Public/ShooterPlannerSchema.h"
+
+#define LOCTEXT_NAMESPACE "PlannerAsset"
+
+namespace
+{
+	FString GetKeyName(EWorldKey Key)
+	{
+		return StaticEnum<EWorldKey>()->GetNameStringByValue((int64)Key);
+	}
+
+	void ValidateConditions(const TArray<FWorldProperty>& Conditions, const FString& Owner, TArray<FText>& OutErrors)
+	{
+		for (const FWorldProperty& Condition : Conditions)
+		{
+			//Other comparators against an out of range value are constant, but not wrong
+			if (Condition.Comparator == ESymbolTest::Eq && Condition.IsRHSAbsolute() && !FWorldStateLayout::IsValidValue(Condition.Key, Condition.Value))
+			{
+				OutErrors.Add(FText::Format(LOCTEXT("ConditionTooWide", "{0}: condition {1} == {2} can never be true, the key only holds values up to {3}"),
+					FText::FromString(Owner), FText::FromString(GetKeyName(Condition.Key)), Condition.Value, FWorldStateLayout::ValueMask((uint32)Condition.Key)));
+			}
+		}
+	}
+
+	void ValidateEffects(const TArray<FAISymEffect>& Effects, const FString& Owner, TArray<FText>& OutErrors)
+	{
+		for (const FAISymEffect& Effect : Effects)
+		{
+			if (Effect.Op == ESymbolOp::Set && Effect.IsRHSAbsolute() && !FWorldStateLayout::IsValidValue(Effect.Key, Effect.Value))
+			{
+				OutErrors.Add(FText::Format(LOCTEXT("EffectTooWide", "{0}: effect {1} = {2} would be truncated, the key only holds values up to {3}"),
+					FText::FromString(Owner), FText::FromString(GetKeyName(Effect.Key)), Effect.Value, FWorldStateLayout::ValueMask((uint32)Effect.Key)));
+			}
+		}
+	}
+}
+
+const FCompiledPlannerDomain& UPlannerAsset::GetCompiledDomain()
+{
+	check(IsInGameThread());
+	if (!CompiledDomain.bCompiled)
+	{
+		CompiledDomain.Compile(Actions, Goals);
+		CompiledDomain.SourcePath = GetPathName();
+		CompiledDomain.LogDiagnostics(*this, Actions, Goals);
+		TArray<FText> Errors;
+		if (!ValidateWorldStateValues(Errors))
+		{
+			for (const FText& Error : Errors)
+			{
+				UE_LOG(LogAction, Error, TEXT("%s: %s"), *GetName(), *Error.ToString());
+			}
+		}
+	}
+	return CompiledDomain;
+}
+
+bool UPlannerAsset::ValidateWorldStateValues(TArray<FText>& OutErrors) const
+{
+	const int32 NumErrors = OutErrors.Num();
+	for (const FWSKeyConfig& KeyConfig : WSKeyDefaults)
+	{
+		if (KeyConfig.Type == EWSValueType::Absolute && KeyConfig.KeyLHS != EWorldKey::SYMBOL_MAX && !FWorldStateLayout::IsValidValue(KeyConfig.KeyLHS, KeyConfig.Value))
+		{
+			OutErrors.Add(FText::Format(LOCTEXT("DefaultTooWide", "Default {0} = {1} would be truncated, the key only holds values up to {2}"),
+				FText::FromString(GetKeyName(KeyConfig.KeyLHS)), KeyConfig.Value, FWorldStateLayout::ValueMask((uint32)KeyConfig.KeyLHS)));
+		}
+	}
+	for (const UGOAPAction* Action : Actions)
+	{
+		if (Action)
+		{
+			ValidateConditions(Action->GetPreconditions(), Action->GetActionName(), OutErrors);
+			ValidateEffects(Action->GetEffects(), Action->GetActionName(), OutErrors);
+		}
+	}
+	for (UGOAPGoal* Goal : Goals)
+	{
+		if (Goal)
+		{
+			ValidateConditions(Goal->GetPreconditions(), Goal->GetName(), OutErrors);
+			ValidateEffects(Goal->GetEffects(), Goal->GetName(), OutErrors);
+		}
+	}
+	return OutErrors.Num() == NumErrors;
+}
+
+bool UPlannerAsset::ValidateSearchType(TArray<FText>& OutErrors) const
+{
+	if (SearchType != EPlannerSearchType::NativeShooter)
+	{
+		return true;
+	}
+	typedef TStaticPlanner<FShooterPlannerSchema> FNativePlanner;
+	const int32 NumErrors = OutErrors.Num();
+	for (const UGOAPAction* Action : Actions)
+	{
+		if (!Action)
+		{
+			continue;
+		}
+		const int32 SchemaIdx = FNativePlanner::FindAction(Action->GetActionName());
+		if (SchemaIdx == INDEX_NONE)
+		{
+			OutErrors.Add(FText::Format(LOCTEXT("NotInSchema", "{0} isn't an action of the native shooter schema"), FText::FromString(Action->GetActionName())));
+		}
+		else if (!FNativePlanner::MatchesAction(SchemaIdx, *Action))
+		{
+			OutErrors.Add(FText::Format(LOCTEXT("SchemaMismatch", "{0}: preconditions, effects or cost differ from FShooterPlannerSchema"), FText::FromString(Action->GetActionName())));
+		}
+	}
+	return OutErrors.Num() == NumErrors;
+}
+
+#if WITH_EDITOR
+void UPlannerAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	//Recompiling here also surfaces dead actions and unreachable goals while the asset is being edited
+	CompiledDomain.Reset();
+	GetCompiledDomain();
+}
+
+EDataValidationResult UPlannerAsset::IsDataValid(TArray<FText>& ValidationErrors)
+{
+	const bool bValuesValid = ValidateWorldStateValues(ValidationErrors);
+	const bool bSearchTypeValid = ValidateSearchType(ValidationErrors);
+	const EDataValidationResult Result = (bValuesValid && bSearchTypeValid) ? EDataValidationResult::Valid : EDataValidationResult::Invalid;
+	return CombineDataValidationResults(Super::IsDataValid(ValidationErrors), Result);
+}
+#endif
+
+#undef LOCTEXT_NAMESPACE
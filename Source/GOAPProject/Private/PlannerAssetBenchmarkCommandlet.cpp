@@ -0,0 +1,233 @@
+#include "../Public/PlannerAssetBenchmarkCommandlet.h"
+#include "../Public/PlannerAsset.h"
+#include "../Public/PlannerBenchmark.h"
+#include "../Public/PlannerComponent.h"
+#include "../Public/GOAPGoal.h"
+#include "AssetRegistryModule.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "Dom/JsonObject.h"
+#include "UObject/Package.h"
+
+namespace
+{
+	struct FAssetBenchmarkReport
+	{
+		FString AssetPath;
+		int32 NumActions = 0;
+		int32 NumGoals = 0;
+		int32 NumSearches = 0;
+		int32 NumFailed = 0;
+		double TotalMs = 0.0;
+		double WorstMs = 0.0;
+		int64 TotalNodesExpanded = 0;
+		int32 WorstNodesExpanded = 0;
+		int32 DeepestPlan = 0;
+		//From the asset's compiled domain
+		int32 NumDeadActions = 0;
+		int32 NumUnreachableGoals = 0;
+		double MeanRelevantActions = 0.0;
+		int32 NumMutexes = 0;
+		int64 TotalMutexPrunes = 0;
+
+		TSharedRef<FJsonObject> ToJson() const
+		{
+			TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+			Root->SetStringField(TEXT("asset"), AssetPath);
+			Root->SetNumberField(TEXT("actions"), NumActions);
+			Root->SetNumberField(TEXT("goals"), NumGoals);
+			Root->SetNumberField(TEXT("searches"), NumSearches);
+			Root->SetNumberField(TEXT("failure_rate"), NumSearches > 0 ? double(NumFailed) / NumSearches : 0.0);
+			Root->SetNumberField(TEXT("mean_ms"), NumSearches > 0 ? TotalMs / NumSearches : 0.0);
+			Root->SetNumberField(TEXT("worst_ms"), WorstMs);
+			Root->SetNumberField(TEXT("mean_nodes_expanded"), NumSearches > 0 ? double(TotalNodesExpanded) / NumSearches : 0.0);
+			Root->SetNumberField(TEXT("worst_nodes_expanded"), WorstNodesExpanded);
+			Root->SetNumberField(TEXT("deepest_plan"), DeepestPlan);
+			Root->SetNumberField(TEXT("dead_actions"), NumDeadActions);
+			Root->SetNumberField(TEXT("unreachable_goals"), NumUnreachableGoals);
+			Root->SetNumberField(TEXT("mean_relevant_actions"), MeanRelevantActions);
+			Root->SetNumberField(TEXT("mutexes"), NumMutexes);
+			Root->SetNumberField(TEXT("mutex_prunes"), TotalMutexPrunes);
+			return Root;
+		}
+	};
+
+	void AddReferencedKeys(const TArray<FWorldProperty>& Conditions, TArray<EWorldKey>& OutKeys)
+	{
+		for (const FWorldProperty& Condition : Conditions)
+		{
+			OutKeys.AddUnique(Condition.Key);
+		}
+	}
+}
+
+UPlannerAssetBenchmarkCommandlet::UPlannerAssetBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UPlannerAssetBenchmarkCommandlet::Main(const FString& Params)
+{
+	int32 NumSamples = 16;
+	FParse::Value(*Params, TEXT("samples="), NumSamples);
+	NumSamples = FMath::Max(NumSamples, 1);
+	int32 Seed = 1234;
+	FParse::Value(*Params, TEXT("seed="), Seed);
+	float MaxMs = 0.f;
+	FParse::Value(*Params, TEXT("maxms="), MaxMs);
+	FString JsonPath = TEXT("GOAPAssetBenchmark");
+	FParse::Value(*Params, TEXT("json="), JsonPath);
+	//Turn parts of the compiled domain off to compare expanded nodes against the full search
+	const bool bNoSlice = FParse::Param(*Params, TEXT("noslice"));
+	const bool bNoLandmarks = FParse::Param(*Params, TEXT("nolandmarks"));
+	const bool bNoMutexes = FParse::Param(*Params, TEXT("nomutexes"));
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.SearchAllAssets(true);
+	TArray<FAssetData> AssetList;
+	AssetRegistry.GetAssetsByClass(UPlannerAsset::StaticClass()->GetFName(), AssetList, true);
+
+	TArray<FAssetBenchmarkReport> Reports;
+	TArray<FPlanStepInfo> Plan;
+	for (const FAssetData& AssetData : AssetList)
+	{
+		UPlannerAsset* Asset = Cast<UPlannerAsset>(AssetData.GetAsset());
+		if (!Asset)
+		{
+			UE_LOG(LogPlannerBenchmark, Warning, TEXT("Could not load %s"), *AssetData.ObjectPath.ToString());
+			continue;
+		}
+
+		FAssetBenchmarkReport& Report = Reports[Reports.AddDefaulted()];
+		Report.AssetPath = AssetData.ObjectPath.ToString();
+
+		//Actions are mirrored into synthetic ones so VerifyContext doesn't need a controller
+		TArray<UGOAPAction_Synthetic*> Actions;
+		TArray<EWorldKey> ReferencedKeys;
+		FAStarPlanner Planner;
+		Planner.MaxDepth = Asset->MaxPlanSize;
+		Planner.bUseSlices = !bNoSlice;
+		Planner.bUseLandmarks = !bNoLandmarks;
+		Planner.bUseMutexes = !bNoMutexes;
+		for (const UGOAPAction* Template : Asset->Actions)
+		{
+			if (!Template)
+			{
+				continue;
+			}
+			UGOAPAction_Synthetic* Action = NewObject<UGOAPAction_Synthetic>(GetTransientPackage());
+			Action->Setup(Template->GetPreconditions(), Template->GetEffects(), Template->Cost(), Template->GetActionName());
+			Action->AddToRoot();
+			Actions.Add(Action);
+			Planner.AddAction(Action);
+
+			AddReferencedKeys(Template->GetPreconditions(), ReferencedKeys);
+			for (const FAISymEffect& Effect : Template->GetEffects())
+			{
+				ReferencedKeys.AddUnique(Effect.Key);
+			}
+		}
+		TArray<UGOAPGoal*> Goals;
+		for (UGOAPGoal* Goal : Asset->Goals)
+		{
+			if (Goal)
+			{
+				Goals.Add(Goal);
+				AddReferencedKeys(Goal->GetGoalCondition(), ReferencedKeys);
+			}
+		}
+		Report.NumActions = Actions.Num();
+		Report.NumGoals = Goals.Num();
+
+		//Compiled against the mirrored actions so null entries in the asset don't shift the indices
+		FCompiledPlannerDomain Domain;
+		Domain.Compile(TArray<UGOAPAction*>(Actions), Goals);
+		Report.NumDeadActions = Domain.DeadActions.CountSetBits();
+		for (const FGoalDomainSlice& Slice : Domain.GoalSlices)
+		{
+			Report.NumUnreachableGoals += Slice.bReachable ? 0 : 1;
+			Report.MeanRelevantActions += Slice.NumRelevantActions;
+		}
+		Report.MeanRelevantActions /= FMath::Max(Goals.Num(), 1);
+		Report.NumMutexes = Domain.Mutexes.Num();
+
+		//Blackboard backed keys have no blackboard here, leave them at 0
+		FWorldState DefaultState;
+		for (const FWSKeyConfig& KeyConfig : Asset->WSKeyDefaults)
+		{
+			if (KeyConfig.Type == EWSValueType::Absolute && KeyConfig.KeyLHS != EWorldKey::SYMBOL_MAX)
+			{
+				DefaultState.SetProp(KeyConfig.KeyLHS, KeyConfig.Value);
+			}
+		}
+
+		FRandomStream Stream(Seed);
+		for (int32 Sample = 0; Sample < NumSamples; ++Sample)
+		{
+			FWorldState Start = DefaultState;
+			if (Sample > 0)
+			{
+				for (EWorldKey Key : ReferencedKeys)
+				{
+					if (Key != EWorldKey::SYMBOL_MAX)
+					{
+						Start.SetProp(Key, (uint8)Stream.RandRange(0, FWorldState::GetMaxValue(Key)));
+					}
+				}
+			}
+
+			for (int32 GoalIdx = 0; GoalIdx < Goals.Num(); ++GoalIdx)
+			{
+				Plan.Reset();
+				const uint64 StartCycles = FPlatformTime::Cycles64();
+				const bool bFound = Planner.Search(Goals[GoalIdx]->GetGoalCondition(), Start, Plan, &Domain, GoalIdx);
+				const double Ms = FPlatformTime::GetSecondsPerCycle64() * double(FPlatformTime::Cycles64() - StartCycles) * 1000.0;
+
+				++Report.NumSearches;
+				Report.NumFailed += bFound ? 0 : 1;
+				Report.TotalMs += Ms;
+				Report.WorstMs = FMath::Max(Report.WorstMs, Ms);
+				Report.TotalNodesExpanded += Planner.LastSearchStats.NodesExpanded;
+				Report.TotalMutexPrunes += Planner.LastSearchStats.MutexPrunes;
+				Report.WorstNodesExpanded = FMath::Max(Report.WorstNodesExpanded, Planner.LastSearchStats.NodesExpanded);
+				if (bFound)
+				{
+					Report.DeepestPlan = FMath::Max(Report.DeepestPlan, Plan.Num());
+				}
+			}
+		}
+
+		for (UGOAPAction_Synthetic* Action : Actions)
+		{
+			Action->RemoveFromRoot();
+		}
+
+		UE_LOG(LogPlannerBenchmark, Display, TEXT("%s: %d searches, %.3f ms mean, %.3f ms worst, %d nodes worst, %d failed, deepest plan %d"),
+			*Report.AssetPath, Report.NumSearches, Report.NumSearches > 0 ? Report.TotalMs / Report.NumSearches : 0.0,
+			Report.WorstMs, Report.WorstNodesExpanded, Report.NumFailed, Report.DeepestPlan);
+	}
+
+	int32 NumOverBudget = 0;
+	TArray<TSharedPtr<FJsonValue>> AssetsJson;
+	for (const FAssetBenchmarkReport& Report : Reports)
+	{
+		AssetsJson.Add(MakeShared<FJsonValueObject>(Report.ToJson()));
+		if (MaxMs > 0.f && Report.WorstMs > MaxMs)
+		{
+			UE_LOG(LogPlannerBenchmark, Error, TEXT("%s worst search %.3f ms is over the %.3f ms budget"), *Report.AssetPath, Report.WorstMs, MaxMs);
+			++NumOverBudget;
+		}
+	}
+
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetNumberField(TEXT("samples"), NumSamples);
+	Root->SetNumberField(TEXT("seed"), Seed);
+	Root->SetArrayField(TEXT("assets"), AssetsJson);
+	const FString WrittenPath = FPlannerBenchmark::WriteResults(JsonPath, Root);
+	UE_LOG(LogPlannerBenchmark, Display, TEXT("Benchmarked %d planner assets, report written to %s"), Reports.Num(), *WrittenPath);
+
+	return NumOverBudget == 0 ? 0 : 1;
+}
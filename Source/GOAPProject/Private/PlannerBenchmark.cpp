@@ -0,0 +1,1030 @@
+#include "../Public/PlannerBenchmark.h"
+#include "../Public/PlannerComponent.h"
+#include "../Public/GOAPPlannerSubsystem.h"
+#include "../Public/ShooterPlannerSchema.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "UObject/Package.h"
+
+DEFINE_LOG_CATEGORY(LogPlannerBenchmark);
+
+namespace
+{
+	FString SerializeCondensed(const TSharedRef<FJsonObject>& Root)
+	{
+		FString Out;
+		TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Out);
+		FJsonSerializer::Serialize(Root, Writer);
+		return Out;
+	}
+
+	double Percentile(const TArray<double>& Sorted, double Fraction)
+	{
+		if (Sorted.Num() == 0)
+		{
+			return 0.0;
+		}
+		int32 Idx = FMath::Clamp(FMath::CeilToInt(Fraction * Sorted.Num()) - 1, 0, Sorted.Num() - 1);
+		return Sorted[Idx];
+	}
+}
+
+void UGOAPAction_Synthetic::Setup(const TArray<FWorldProperty>& InPreconditions, const TArray<FAISymEffect>& InEffects, int InCost, const FString& InName)
+{
+	Preconditions = InPreconditions;
+	Effects = InEffects;
+	EdgeCost = InCost;
+	ActionName = InName.IsEmpty() ? GetName() : InName;
+}
+
+TSharedRef<FJsonObject> FPlannerBenchmarkResult::ToJsonObject() const
+{
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	TSharedRef<FJsonObject> Domain = MakeShared<FJsonObject>();
+	Domain->SetNumberField(TEXT("keys"), Params.NumKeys);
+	Domain->SetNumberField(TEXT("actions"), Params.NumActions);
+	Domain->SetNumberField(TEXT("branching"), Params.BranchingFactor);
+	Domain->SetNumberField(TEXT("depth"), Params.SolutionDepth);
+	Domain->SetNumberField(TEXT("seed"), Params.Seed);
+	Root->SetObjectField(TEXT("domain"), Domain);
+
+	Root->SetNumberField(TEXT("searches"), Params.NumSearches);
+	Root->SetNumberField(TEXT("solved"), NumSolved);
+	Root->SetNumberField(TEXT("nodes_expanded"), (double)TotalNodesExpanded);
+	Root->SetNumberField(TEXT("nodes_expanded_per_sec"), NodesExpandedPerSecond);
+	Root->SetNumberField(TEXT("nodes_allocated_per_search"), NodesAllocatedPerSearch);
+	Root->SetNumberField(TEXT("peak_bytes"), (double)PeakBytes);
+	Root->SetNumberField(TEXT("mean_ms"), MeanMs);
+	Root->SetNumberField(TEXT("p50_ms"), P50Ms);
+	Root->SetNumberField(TEXT("p99_ms"), P99Ms);
+	return Root;
+}
+
+FString FPlannerBenchmarkResult::ToJson() const
+{
+	return SerializeCondensed(ToJsonObject());
+}
+
+FString FPlannerBenchmark::WriteResults(const FString& Name, const TSharedRef<FJsonObject>& Root)
+{
+	const FString OutPath = FPaths::GetExtension(Name).IsEmpty() ? FPaths::ProfilingDir() / (Name + TEXT(".json")) : Name;
+	if (!FFileHelper::SaveStringToFile(SerializeCondensed(Root), *OutPath))
+	{
+		UE_LOG(LogPlannerBenchmark, Warning, TEXT("Could not write benchmark results to %s"), *OutPath);
+	}
+	return OutPath;
+}
+
+void FPlannerBenchmark::GenerateDomain(const FSyntheticDomainParams& Params, UObject* Outer, TArray<UGOAPAction*>& OutActions, TArray<FWorldProperty>& OutGoal, FWorldState& OutStart)
+{
+	FRandomStream Stream(Params.Seed);
+
+	const int32 NumKeys = FMath::Clamp(Params.NumKeys, 1, (int32)EWorldKey::SYMBOL_MAX);
+	const int32 Depth = FMath::Clamp(Params.SolutionDepth, 1, (int32)FWorldState::GetMaxValue(EWorldKey::kAtLocation));
+	const int32 Branching = FMath::Clamp(Params.BranchingFactor, 1, FMath::Max(Params.NumActions, 1));
+
+	//kAtLocation is the only byte wide key, so it's the counter the plan has to advance
+	TArray<EWorldKey> BoolKeys;
+	for (int32 Key = 0; Key < NumKeys; ++Key)
+	{
+		if ((EWorldKey)Key != EWorldKey::kAtLocation)
+		{
+			BoolKeys.Add((EWorldKey)Key);
+		}
+	}
+
+	OutStart = FWorldState();
+	for (EWorldKey Key : BoolKeys)
+	{
+		OutStart.SetProp(Key, Stream.RandRange(0, 1));
+	}
+
+	OutGoal.Reset();
+	FWorldProperty GoalCondition(EWorldKey::kAtLocation, (uint8)Depth);
+	GoalCondition.bIsNotSolvable = false;
+	OutGoal.Add(GoalCondition);
+
+	auto RandomBoolCondition = [&](bool bSatisfiedAtStart)
+	{
+		EWorldKey Key = BoolKeys[Stream.RandRange(0, BoolKeys.Num() - 1)];
+		uint8 Value = OutStart.GetProp(Key);
+		FWorldProperty Condition(Key, (uint8)(bSatisfiedAtStart ? Value : 1 - Value));
+		Condition.bIsNotSolvable = false;
+		return Condition;
+	};
+
+	OutActions.Reset();
+	for (int32 Idx = 0; Idx < FMath::Max(Params.NumActions, Branching); ++Idx)
+	{
+		TArray<FWorldProperty> Preconditions;
+		TArray<FAISymEffect> Effects;
+		int Cost = 1;
+		if (Idx < Branching)
+		{
+			//Advancing actions. The first one always works so the domain is solvable
+			FAISymEffect Effect(EWorldKey::kAtLocation, (uint8)(1 + (Idx % 3)));
+			Effect.Op = ESymbolOp::Inc;
+			Effects.Add(Effect);
+			//Bigger increments cost more per step so the cheapest plan is SolutionDepth long
+			Cost = 1 + (Idx % 3) * 2 + (Idx / 3);
+			if (Idx > 0 && BoolKeys.Num() != 0)
+			{
+				Preconditions.Add(RandomBoolCondition(Stream.FRand() < 0.5f));
+			}
+		}
+		else if (BoolKeys.Num() != 0)
+		{
+			//Distractors
+			EWorldKey Key = BoolKeys[Stream.RandRange(0, BoolKeys.Num() - 1)];
+			Effects.Add(FAISymEffect(Key, (uint8)Stream.RandRange(0, 1)));
+			Preconditions.Add(RandomBoolCondition(Stream.FRand() < 0.5f));
+			Cost = Stream.RandRange(1, 5);
+		}
+		UGOAPAction_Synthetic* Action = NewObject<UGOAPAction_Synthetic>(Outer);
+		Action->Setup(Preconditions, Effects, Cost);
+		OutActions.Add(Action);
+	}
+}
+
+FPlannerBenchmarkResult FPlannerBenchmark::Run(const FSyntheticDomainParams& Params)
+{
+	check(IsInGameThread());
+
+	FPlannerBenchmarkResult Result;
+	Result.Params = Params;
+
+	TArray<UGOAPAction*> Actions;
+	TArray<FWorldProperty> Goal;
+	FWorldState Start;
+	GenerateDomain(Params, GetTransientPackage(), Actions, Goal, Start);
+
+	FAStarPlanner Planner;
+	Planner.MaxDepth = FMath::Max(Params.SolutionDepth, 1) * 2;
+	Planner.bMeasureMemory = true;
+	for (UGOAPAction* Action : Actions)
+	{
+		Action->AddToRoot();
+		Planner.AddAction(Action);
+	}
+
+	TArray<double> Latencies;
+	Latencies.Reserve(Params.NumSearches);
+	int64 TotalNodesAllocated = 0;
+	double TotalSeconds = 0.0;
+	TArray<FPlanStepInfo> Plan;
+	for (int32 Idx = 0; Idx < Params.NumSearches; ++Idx)
+	{
+		Plan.Reset();
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		const bool bFound = Planner.Search(Goal, Start, Plan);
+		const uint64 EndCycles = FPlatformTime::Cycles64();
+
+		const double Seconds = FPlatformTime::GetSecondsPerCycle64() * double(EndCycles - StartCycles);
+		TotalSeconds += Seconds;
+		Latencies.Add(Seconds * 1000.0);
+		//Measuring walks the node pool after the clock stopped, so it doesn't show in the latencies
+		TotalNodesAllocated += Planner.LastSearchStats.NodesAllocated;
+		Result.PeakBytes = FMath::Max(Result.PeakBytes, Planner.LastSearchStats.PeakBytes);
+		Result.TotalNodesExpanded += Planner.LastSearchStats.NodesExpanded;
+		Result.NumSolved += bFound ? 1 : 0;
+	}
+
+	for (UGOAPAction* Action : Actions)
+	{
+		Action->RemoveFromRoot();
+	}
+
+	if (Params.NumSearches > 0)
+	{
+		Latencies.Sort();
+		Result.MeanMs = (TotalSeconds * 1000.0) / Params.NumSearches;
+		Result.P50Ms = Percentile(Latencies, 0.5);
+		Result.P99Ms = Percentile(Latencies, 0.99);
+		Result.NodesAllocatedPerSearch = double(TotalNodesAllocated) / Params.NumSearches;
+	}
+	Result.NodesExpandedPerSecond = (TotalSeconds > 0.0) ? Result.TotalNodesExpanded / TotalSeconds : 0.0;
+	return Result;
+}
+
+TSharedRef<FJsonObject> FAgentBatchBenchmarkResult::ToJsonObject() const
+{
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetNumberField(TEXT("agents"), NumAgents);
+	Root->SetNumberField(TEXT("frames"), NumFrames);
+	Root->SetNumberField(TEXT("goals_per_agent"), GoalsPerAgent);
+	Root->SetNumberField(TEXT("write_rate"), WriteRate);
+	Root->SetNumberField(TEXT("mean_ms"), MeanMs);
+	Root->SetNumberField(TEXT("p99_ms"), P99Ms);
+	Root->SetNumberField(TEXT("single_thread_mean_ms"), SingleThreadMeanMs);
+	Root->SetNumberField(TEXT("replans_per_frame"), ReplansPerFrame);
+	return Root;
+}
+
+FAgentBatchBenchmarkResult FPlannerBenchmark::RunAgentBatch(int32 NumAgents, int32 NumFrames, int32 Seed)
+{
+	FAgentBatchBenchmarkResult Result;
+	Result.NumAgents = NumAgents;
+	Result.NumFrames = NumFrames;
+	Result.GoalsPerAgent = 6;
+	Result.WriteRate = 0.25f;
+
+	FRandomStream Stream(Seed);
+	FPlannerAgentBatch Batch;
+	for (int32 AgentIdx = 0; AgentIdx < NumAgents; ++AgentIdx)
+	{
+		Batch.Add();
+		TArray<FBatchedGoal> Goals;
+		for (int32 GoalIdx = 0; GoalIdx < Result.GoalsPerAgent; ++GoalIdx)
+		{
+			FBatchedGoal& Goal = Goals[Goals.AddDefaulted()];
+			for (int32 CondIdx = Stream.RandRange(1, 3); CondIdx > 0; --CondIdx)
+			{
+				FWorldProperty Condition((EWorldKey)Stream.RandRange(0, (int32)EWorldKey::SYMBOL_MAX - 1), (uint8)1);
+				Goal.Preconditions.Add(Condition);
+			}
+		}
+		Batch.SetGoals(AgentIdx, Goals);
+		Batch.SetFlag(AgentIdx, EPlannerAgentFlags::Running | EPlannerAgentFlags::HasPlan | EPlannerAgentFlags::HasCurrentAction, true);
+		Batch.AddExpected(AgentIdx, false, EWorldKey::kAtLocation, (uint8)Stream.RandRange(0, 15));
+	}
+
+	//Same writes for both runs
+	struct FWrite
+	{
+		int32 AgentIdx;
+		EWorldKey Key;
+		uint8 Value;
+	};
+	TArray<TArray<FWrite>> Frames;
+	Frames.SetNum(NumFrames);
+	for (TArray<FWrite>& Writes : Frames)
+	{
+		for (int32 AgentIdx = 0; AgentIdx < NumAgents; ++AgentIdx)
+		{
+			if (Stream.FRand() < Result.WriteRate)
+			{
+				const EWorldKey Key = (EWorldKey)Stream.RandRange(0, (int32)EWorldKey::SYMBOL_MAX - 1);
+				Writes.Add({ AgentIdx, Key, (uint8)Stream.RandRange(0, FMath::Min<int32>(FWorldState::GetMaxValue(Key), 15)) });
+			}
+		}
+	}
+
+	auto RunFrames = [&](bool bSingleThread, TArray<double>& OutLatencies, int64& OutReplans)
+	{
+		for (const TArray<FWrite>& Writes : Frames)
+		{
+			for (const FWrite& Write : Writes)
+			{
+				Batch.WorldStates[Write.AgentIdx].SetProp(Write.Key, Write.Value);
+				Batch.MarkDirty(Write.AgentIdx, Write.Key);
+			}
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			Batch.RunPasses(bSingleThread);
+			const uint64 EndCycles = FPlatformTime::Cycles64();
+			OutLatencies.Add(FPlatformTime::GetSecondsPerCycle64() * double(EndCycles - StartCycles) * 1000.0);
+
+			//Stand in for the game thread pass of the subsystem
+			for (int32 AgentIdx = 0; AgentIdx < NumAgents; ++AgentIdx)
+			{
+				if (Batch.HasFlag(AgentIdx, EPlannerAgentFlags::ReplanNeeded))
+				{
+					++OutReplans;
+				}
+				Batch.SetFlag(AgentIdx, EPlannerAgentFlags::ReplanNeeded | EPlannerAgentFlags::GoalsChanged, false);
+			}
+		}
+	};
+
+	TArray<double> Latencies;
+	int64 Replans = 0;
+	RunFrames(false, Latencies, Replans);
+	TArray<double> SingleThreadLatencies;
+	int64 SingleThreadReplans = 0;
+	RunFrames(true, SingleThreadLatencies, SingleThreadReplans);
+
+	if (NumFrames > 0)
+	{
+		double Total = 0.0;
+		for (double Ms : Latencies)
+		{
+			Total += Ms;
+		}
+		Result.MeanMs = Total / NumFrames;
+		Total = 0.0;
+		for (double Ms : SingleThreadLatencies)
+		{
+			Total += Ms;
+		}
+		Result.SingleThreadMeanMs = Total / NumFrames;
+		Latencies.Sort();
+		Result.P99Ms = Percentile(Latencies, 0.99);
+		Result.ReplansPerFrame = double(Replans) / NumFrames;
+	}
+	return Result;
+}
+
+TSharedRef<FJsonObject> FSquadBenchmarkResult::ToJsonObject() const
+{
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetNumberField(TEXT("agents"), NumAgents);
+	Root->SetNumberField(TEXT("squad_size"), SquadSize);
+	Root->SetNumberField(TEXT("frames"), NumFrames);
+	Root->SetNumberField(TEXT("shared_ms"), SharedMs);
+	Root->SetNumberField(TEXT("per_agent_ms"), PerAgentMs);
+	Root->SetNumberField(TEXT("shared_write_ms"), SharedWriteMs);
+	Root->SetNumberField(TEXT("per_agent_write_ms"), PerAgentWriteMs);
+	Root->SetNumberField(TEXT("shared_writes"), (double)SharedWrites);
+	Root->SetNumberField(TEXT("per_agent_writes"), (double)PerAgentWrites);
+	Root->SetNumberField(TEXT("shared_replans_per_frame"), SharedReplansPerFrame);
+	Root->SetNumberField(TEXT("per_agent_replans_per_frame"), PerAgentReplansPerFrame);
+	Root->SetNumberField(TEXT("shared_bytes"), (double)SharedBytes);
+	Root->SetNumberField(TEXT("per_agent_bytes"), (double)PerAgentBytes);
+	return Root;
+}
+
+FSquadBenchmarkResult FPlannerBenchmark::RunSquadBatch(int32 NumAgents, int32 SquadSize, int32 NumFrames, int32 Seed)
+{
+	FSquadBenchmarkResult Result;
+	Result.NumAgents = NumAgents;
+	Result.SquadSize = FMath::Max(SquadSize, 1);
+	Result.NumFrames = NumFrames;
+
+	const EWorldKey SharedKeys[] = { EWorldKey::kTargetDead, EWorldKey::kTargetSuppressed, EWorldKey::kDisturbanceHandled };
+	uint32 SharedMask = 0;
+	for (EWorldKey Key : SharedKeys)
+	{
+		SharedMask |= 1u << (uint32)Key;
+	}
+	const int32 NumSquads = FMath::DivideAndRoundUp(NumAgents, Result.SquadSize);
+
+	//One fact per squad per frame, a quarter of the squads learn something
+	struct FSquadWrite
+	{
+		int32 SquadIdx;
+		EWorldKey Key;
+		uint8 Value;
+	};
+	FRandomStream Stream(Seed);
+	TArray<TArray<FSquadWrite>> Frames;
+	Frames.SetNum(NumFrames);
+	for (TArray<FSquadWrite>& Writes : Frames)
+	{
+		for (int32 SquadIdx = 0; SquadIdx < NumSquads; ++SquadIdx)
+		{
+			if (Stream.FRand() < 0.25f)
+			{
+				Writes.Add({ SquadIdx, SharedKeys[Stream.RandRange(0, 2)], (uint8)Stream.RandRange(0, 1) });
+			}
+		}
+	}
+
+	auto Setup = [&](FPlannerAgentBatch& Batch, bool bShared)
+	{
+		for (int32 SquadIdx = 0; bShared && SquadIdx < NumSquads; ++SquadIdx)
+		{
+			Batch.CreateSquad(SharedMask, FWorldState());
+		}
+		for (int32 AgentIdx = 0; AgentIdx < NumAgents; ++AgentIdx)
+		{
+			Batch.Add();
+			Batch.SetFlag(AgentIdx, EPlannerAgentFlags::Running | EPlannerAgentFlags::HasPlan, true);
+			if (bShared)
+			{
+				Batch.JoinSquad(AgentIdx, AgentIdx / Result.SquadSize);
+			}
+		}
+	};
+
+	auto RunFrames = [&](FPlannerAgentBatch& Batch, bool bShared, double& OutMs, double& OutWriteMs, int64& OutWrites, int64& OutReplans)
+	{
+		double TotalMs = 0.0;
+		double WriteMs = 0.0;
+		for (const TArray<FSquadWrite>& Writes : Frames)
+		{
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			for (const FSquadWrite& Write : Writes)
+			{
+				if (bShared)
+				{
+					Batch.SetSquadProp(Write.SquadIdx, Write.Key, Write.Value);
+					++OutWrites;
+					continue;
+				}
+				//What every member's own SetWSProp would do
+				const int32 End = FMath::Min((Write.SquadIdx + 1) * Result.SquadSize, NumAgents);
+				for (int32 AgentIdx = Write.SquadIdx * Result.SquadSize; AgentIdx < End; ++AgentIdx)
+				{
+					if (Batch.WorldStates[AgentIdx].GetProp(Write.Key) != Write.Value)
+					{
+						Batch.WorldStates[AgentIdx].SetProp(Write.Key, Write.Value);
+						Batch.MarkDirty(AgentIdx, Write.Key);
+					}
+					++OutWrites;
+				}
+			}
+			const uint64 WriteCycles = FPlatformTime::Cycles64();
+			Batch.RunPasses();
+			const uint64 EndCycles = FPlatformTime::Cycles64();
+
+			WriteMs += FPlatformTime::GetSecondsPerCycle64() * double(WriteCycles - StartCycles) * 1000.0;
+			TotalMs += FPlatformTime::GetSecondsPerCycle64() * double(EndCycles - StartCycles) * 1000.0;
+			for (int32 AgentIdx = 0; AgentIdx < NumAgents; ++AgentIdx)
+			{
+				if (Batch.HasFlag(AgentIdx, EPlannerAgentFlags::ReplanNeeded))
+				{
+					++OutReplans;
+				}
+				Batch.SetFlag(AgentIdx, EPlannerAgentFlags::ReplanNeeded | EPlannerAgentFlags::GoalsChanged, false);
+			}
+		}
+		OutMs = (NumFrames > 0) ? TotalMs / NumFrames : 0.0;
+		OutWriteMs = (NumFrames > 0) ? WriteMs / NumFrames : 0.0;
+	};
+
+	int64 Replans = 0;
+	{
+		FPlannerAgentBatch Batch;
+		Setup(Batch, true);
+		Result.SharedBytes = (int64)Batch.GetAllocatedSize();
+		RunFrames(Batch, true, Result.SharedMs, Result.SharedWriteMs, Result.SharedWrites, Replans);
+		Result.SharedReplansPerFrame = (NumFrames > 0) ? double(Replans) / NumFrames : 0.0;
+	}
+	Replans = 0;
+	{
+		FPlannerAgentBatch Batch;
+		Setup(Batch, false);
+		Result.PerAgentBytes = (int64)Batch.GetAllocatedSize();
+		RunFrames(Batch, false, Result.PerAgentMs, Result.PerAgentWriteMs, Result.PerAgentWrites, Replans);
+		Result.PerAgentReplansPerFrame = (NumFrames > 0) ? double(Replans) / NumFrames : 0.0;
+	}
+	return Result;
+}
+
+TSharedRef<FJsonObject> FSquadReplanBenchmarkResult::ToJsonObject() const
+{
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetNumberField(TEXT("squad_size"), SquadSize);
+	Root->SetNumberField(TEXT("events"), NumEvents);
+	Root->SetNumberField(TEXT("divergence_rate"), DivergenceRate);
+	Root->SetNumberField(TEXT("shared_ms"), SharedMs);
+	Root->SetNumberField(TEXT("per_agent_ms"), PerAgentMs);
+	Root->SetNumberField(TEXT("shared_searches"), (double)SharedSearches);
+	Root->SetNumberField(TEXT("per_agent_searches"), (double)PerAgentSearches);
+	Root->SetNumberField(TEXT("cost_mismatches"), NumCostMismatches);
+	return Root;
+}
+
+FSquadReplanBenchmarkResult FPlannerBenchmark::RunSquadReplans(int32 SquadSize, int32 NumEvents, int32 Seed)
+{
+	check(IsInGameThread());
+
+	FSquadReplanBenchmarkResult Result;
+	Result.SquadSize = FMath::Max(SquadSize, 1);
+	Result.NumEvents = NumEvents;
+	Result.DivergenceRate = 0.1f;
+
+	TArray<UGOAPAction*> Actions;
+	GenerateShooterActions(GetTransientPackage(), Actions);
+	FAStarPlanner Planner;
+	for (UGOAPAction* Action : Actions)
+	{
+		Action->AddToRoot();
+		Planner.AddAction(Action);
+	}
+
+	const FWorldProperty Goals[] =
+	{
+		FWorldProperty(EWorldKey::kTargetDead, (uint8)1),
+		FWorldProperty(EWorldKey::kDisturbanceHandled, (uint8)1),
+		FWorldProperty(EWorldKey::kInDanger, (uint8)0),
+	};
+	//Searches use the goal's slice like UPlannerComponent's, which also decides the keys a shared plan is compared on
+	TArray<TArray<FWorldProperty>> GoalConditions;
+	for (const FWorldProperty& Goal : Goals)
+	{
+		TArray<FWorldProperty>& Condition = GoalConditions[GoalConditions.AddDefaulted()];
+		Condition.Add(Goal);
+		Condition[0].bIsNotSolvable = false;
+	}
+	FCompiledPlannerDomain Domain;
+	Domain.Compile(Actions, GoalConditions);
+	const EWorldKey StartKeys[] = { EWorldKey::kIdle, EWorldKey::kTargetDead, EWorldKey::kDisturbanceHandled, EWorldKey::kUsingObject, EWorldKey::kTargetSuppressed, EWorldKey::kInDanger };
+
+	auto PlanCost = [](const TArray<FPlanStepInfo>& Plan)
+	{
+		int32 Cost = 0;
+		for (const FPlanStepInfo& Step : Plan)
+		{
+			Cost += Step.Action->Cost();
+		}
+		return Cost;
+	};
+
+	FRandomStream Stream(Seed);
+	double SharedSeconds = 0.0;
+	double PerAgentSeconds = 0.0;
+	TArray<FWorldState> MemberStarts;
+	TArray<int32> MemberCosts;
+	TArray<FPlanStepInfo> Plan;
+	for (int32 EventIdx = 0; EventIdx < NumEvents; ++EventIdx)
+	{
+		FWorldState SquadStart;
+		for (EWorldKey Key : StartKeys)
+		{
+			SquadStart.SetProp(Key, (uint8)Stream.RandRange(0, 1));
+		}
+		MemberStarts.Reset();
+		for (int32 MemberIdx = 0; MemberIdx < Result.SquadSize; ++MemberIdx)
+		{
+			FWorldState& Start = MemberStarts[MemberStarts.Add(SquadStart)];
+			for (EWorldKey Key : StartKeys)
+			{
+				if (Stream.FRand() < Result.DivergenceRate)
+				{
+					Start.SetProp(Key, (uint8)(1 - Start.GetProp(Key)));
+				}
+			}
+		}
+		const int32 GoalIdx = EventIdx % GoalConditions.Num();
+		const TArray<FWorldProperty>& Goal = GoalConditions[GoalIdx];
+
+		//Every member searches
+		MemberCosts.Reset();
+		uint64 StartCycles = FPlatformTime::Cycles64();
+		for (const FWorldState& Start : MemberStarts)
+		{
+			Plan.Reset();
+			const bool bFound = Planner.Search(Goal, Start, Plan, &Domain, GoalIdx);
+			MemberCosts.Add(bFound ? PlanCost(Plan) : INDEX_NONE);
+			++Result.PerAgentSearches;
+		}
+		uint64 EndCycles = FPlatformTime::Cycles64();
+		PerAgentSeconds += FPlatformTime::GetSecondsPerCycle64() * double(EndCycles - StartCycles);
+
+		//Members look in the squad context first, like UPlannerComponent::ProcessReplanRequest
+		FSquadPlanContext Context;
+		StartCycles = FPlatformTime::Cycles64();
+		for (int32 MemberIdx = 0; MemberIdx < MemberStarts.Num(); ++MemberIdx)
+		{
+			const FWorldState& Start = MemberStarts[MemberIdx];
+			Planner.PrepareSearch(Start, &Domain, GoalIdx);
+			if (const FSquadPlanContext::FSolvedPlan* Shared = Context.FindPlan(nullptr, GoalIdx, Start, Planner))
+			{
+				int32 Cost = 0;
+				for (int32 ActionIdx : Shared->ActionIndices)
+				{
+					Cost += Actions[ActionIdx]->Cost();
+				}
+				Result.NumCostMismatches += (Cost != MemberCosts[MemberIdx]) ? 1 : 0;
+				continue;
+			}
+			Plan.Reset();
+			++Result.SharedSearches;
+			if (Planner.Search(Goal, Start, Plan, &Domain, GoalIdx))
+			{
+				Context.AddPlan(nullptr, GoalIdx, Start, Planner, Plan);
+			}
+		}
+		EndCycles = FPlatformTime::Cycles64();
+		SharedSeconds += FPlatformTime::GetSecondsPerCycle64() * double(EndCycles - StartCycles);
+	}
+
+	for (UGOAPAction* Action : Actions)
+	{
+		Action->RemoveFromRoot();
+	}
+
+	if (NumEvents > 0)
+	{
+		Result.SharedMs = (SharedSeconds * 1000.0) / NumEvents;
+		Result.PerAgentMs = (PerAgentSeconds * 1000.0) / NumEvents;
+	}
+	return Result;
+}
+
+void FPlannerBenchmark::GenerateShooterActions(UObject* Outer, TArray<UGOAPAction*>& OutActions)
+{
+	OutActions.Reset();
+	for (int32 ActionIdx = 0; ActionIdx < FShooterPlannerSchema::NumActions; ++ActionIdx)
+	{
+		const FStaticActionDef Def = FShooterPlannerSchema::GetAction(ActionIdx);
+		TArray<FWorldProperty> Preconditions;
+		for (int32 Idx = 0; Idx < Def.NumPreconditions; ++Idx)
+		{
+			FWorldProperty Condition(Def.Preconditions[Idx].Key, Def.Preconditions[Idx].Value);
+			Condition.Comparator = Def.Preconditions[Idx].Comparator;
+			Condition.bIsNotSolvable = Def.Preconditions[Idx].bIsNotSolvable;
+			Preconditions.Add(Condition);
+		}
+		TArray<FAISymEffect> Effects;
+		for (int32 Idx = 0; Idx < Def.NumEffects; ++Idx)
+		{
+			FAISymEffect Effect(Def.Effects[Idx].Key, Def.Effects[Idx].Value);
+			Effect.Op = Def.Effects[Idx].Op;
+			Effects.Add(Effect);
+		}
+		UGOAPAction_Synthetic* Action = NewObject<UGOAPAction_Synthetic>(Outer);
+		Action->Setup(Preconditions, Effects, Def.Cost, FShooterPlannerSchema::GetActionName(ActionIdx));
+		OutActions.Add(Action);
+	}
+}
+
+TSharedRef<FJsonObject> FStaticPlannerBenchmarkResult::ToJsonObject() const
+{
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetNumberField(TEXT("searches"), NumSearches);
+	Root->SetNumberField(TEXT("solved"), NumSolved);
+	Root->SetNumberField(TEXT("mismatches"), NumMismatches);
+	Root->SetNumberField(TEXT("static_mean_ms"), StaticMeanMs);
+	Root->SetNumberField(TEXT("runtime_mean_ms"), RuntimeMeanMs);
+	return Root;
+}
+
+FStaticPlannerBenchmarkResult FPlannerBenchmark::RunStaticShooter(int32 NumSearches, int32 Seed)
+{
+	check(IsInGameThread());
+
+	FStaticPlannerBenchmarkResult Result;
+	Result.NumSearches = NumSearches;
+
+	TArray<UGOAPAction*> Actions;
+	GenerateShooterActions(GetTransientPackage(), Actions);
+
+	FAStarPlanner RuntimePlanner;
+	TStaticPlanner<FShooterPlannerSchema> StaticPlanner;
+	RuntimePlanner.MaxDepth = StaticPlanner.MaxDepth;
+	for (int32 ActionIdx = 0; ActionIdx < Actions.Num(); ++ActionIdx)
+	{
+		Actions[ActionIdx]->AddToRoot();
+		RuntimePlanner.AddAction(Actions[ActionIdx]);
+		StaticPlanner.BindAction(ActionIdx, Actions[ActionIdx]);
+	}
+
+	const FWorldProperty Goals[] =
+	{
+		FWorldProperty(EWorldKey::kTargetDead, (uint8)1),
+		FWorldProperty(EWorldKey::kDisturbanceHandled, (uint8)1),
+		FWorldProperty(EWorldKey::kInDanger, (uint8)0),
+		FWorldProperty(EWorldKey::kIdle, (uint8)1),
+	};
+	const EWorldKey StartKeys[] = { EWorldKey::kIdle, EWorldKey::kTargetDead, EWorldKey::kDisturbanceHandled, EWorldKey::kUsingObject, EWorldKey::kTargetSuppressed, EWorldKey::kInDanger };
+
+	auto PlanCost = [](const TArray<FPlanStepInfo>& Plan)
+	{
+		int32 Cost = 0;
+		for (const FPlanStepInfo& Step : Plan)
+		{
+			Cost += Step.Action->Cost();
+		}
+		return Cost;
+	};
+
+	FRandomStream Stream(Seed);
+	double StaticSeconds = 0.0;
+	double RuntimeSeconds = 0.0;
+	TArray<FPlanStepInfo> StaticPlan;
+	TArray<FPlanStepInfo> RuntimePlan;
+	for (int32 SearchIdx = 0; SearchIdx < NumSearches; ++SearchIdx)
+	{
+		FWorldState Start;
+		for (EWorldKey Key : StartKeys)
+		{
+			Start.SetProp(Key, (uint8)Stream.RandRange(0, 1));
+		}
+		TArray<FWorldProperty> Goal;
+		Goal.Add(Goals[SearchIdx % int32(sizeof(Goals) / sizeof(Goals[0]))]);
+		Goal[0].bIsNotSolvable = false;
+
+		StaticPlan.Reset();
+		RuntimePlan.Reset();
+		uint64 StartCycles = FPlatformTime::Cycles64();
+		const bool bStaticFound = StaticPlanner.Search(Goal, Start, StaticPlan);
+		uint64 EndCycles = FPlatformTime::Cycles64();
+		StaticSeconds += FPlatformTime::GetSecondsPerCycle64() * double(EndCycles - StartCycles);
+
+		StartCycles = FPlatformTime::Cycles64();
+		const bool bRuntimeFound = RuntimePlanner.Search(Goal, Start, RuntimePlan);
+		EndCycles = FPlatformTime::Cycles64();
+		RuntimeSeconds += FPlatformTime::GetSecondsPerCycle64() * double(EndCycles - StartCycles);
+
+		Result.NumSolved += bStaticFound ? 1 : 0;
+		if (bStaticFound != bRuntimeFound || (bStaticFound && PlanCost(StaticPlan) != PlanCost(RuntimePlan)))
+		{
+			++Result.NumMismatches;
+		}
+	}
+
+	for (UGOAPAction* Action : Actions)
+	{
+		Action->RemoveFromRoot();
+	}
+
+	if (NumSearches > 0)
+	{
+		Result.StaticMeanMs = (StaticSeconds * 1000.0) / NumSearches;
+		Result.RuntimeMeanMs = (RuntimeSeconds * 1000.0) / NumSearches;
+	}
+	return Result;
+}
+
+TSharedRef<FJsonObject> FLandmarkBenchmarkResult::ToJsonObject() const
+{
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetStringField(TEXT("domain"), DomainName);
+	Root->SetNumberField(TEXT("searches"), NumSearches);
+	Root->SetNumberField(TEXT("solved"), NumSolved);
+	Root->SetNumberField(TEXT("cost_mismatches"), NumCostMismatches);
+	Root->SetNumberField(TEXT("nodes_expanded_with"), (double)NodesExpandedWith);
+	Root->SetNumberField(TEXT("nodes_expanded_without"), (double)NodesExpandedWithout);
+	Root->SetNumberField(TEXT("mean_ms_with"), MeanMsWith);
+	Root->SetNumberField(TEXT("mean_ms_without"), MeanMsWithout);
+	return Root;
+}
+
+FLandmarkBenchmarkResult FPlannerBenchmark::RunLandmarks(bool bShooter, int32 NumSearches, int32 Seed)
+{
+	check(IsInGameThread());
+
+	FLandmarkBenchmarkResult Result;
+	Result.DomainName = bShooter ? TEXT("shooter") : TEXT("synthetic");
+	Result.NumSearches = NumSearches;
+
+	auto PlanCost = [](const TArray<FPlanStepInfo>& Plan)
+	{
+		int32 Cost = 0;
+		for (const FPlanStepInfo& Step : Plan)
+		{
+			Cost += Step.Action->Cost();
+		}
+		return Cost;
+	};
+
+	double SecondsWith = 0.0;
+	double SecondsWithout = 0.0;
+	TArray<FPlanStepInfo> PlanWith;
+	TArray<FPlanStepInfo> PlanWithout;
+	//Both planners search the same domain from the same start, only bUseLandmarks differs
+	auto Compare = [&](FAStarPlanner& With, FAStarPlanner& Without, const FCompiledPlannerDomain& Domain, int32 GoalIdx,
+		const TArray<FWorldProperty>& Goal, const FWorldState& Start)
+	{
+		PlanWith.Reset();
+		PlanWithout.Reset();
+		uint64 StartCycles = FPlatformTime::Cycles64();
+		const bool bFoundWith = With.Search(Goal, Start, PlanWith, &Domain, GoalIdx);
+		uint64 EndCycles = FPlatformTime::Cycles64();
+		SecondsWith += FPlatformTime::GetSecondsPerCycle64() * double(EndCycles - StartCycles);
+
+		StartCycles = FPlatformTime::Cycles64();
+		const bool bFoundWithout = Without.Search(Goal, Start, PlanWithout, &Domain, GoalIdx);
+		EndCycles = FPlatformTime::Cycles64();
+		SecondsWithout += FPlatformTime::GetSecondsPerCycle64() * double(EndCycles - StartCycles);
+
+		Result.NumSolved += bFoundWith ? 1 : 0;
+		Result.NodesExpandedWith += With.LastSearchStats.NodesExpanded;
+		Result.NodesExpandedWithout += Without.LastSearchStats.NodesExpanded;
+		if (bFoundWith != bFoundWithout || (bFoundWith && PlanCost(PlanWith) != PlanCost(PlanWithout)))
+		{
+			++Result.NumCostMismatches;
+		}
+	};
+	auto MakePlanners = [](const TArray<UGOAPAction*>& Actions, int32 MaxDepth, FAStarPlanner& With, FAStarPlanner& Without)
+	{
+		With.MaxDepth = MaxDepth;
+		Without.MaxDepth = MaxDepth;
+		Without.bUseLandmarks = false;
+		for (UGOAPAction* Action : Actions)
+		{
+			With.AddAction(Action);
+			Without.AddAction(Action);
+		}
+	};
+
+	if (bShooter)
+	{
+		TArray<UGOAPAction*> Actions;
+		GenerateShooterActions(GetTransientPackage(), Actions);
+		for (UGOAPAction* Action : Actions)
+		{
+			Action->AddToRoot();
+		}
+		FAStarPlanner With;
+		FAStarPlanner Without;
+		//TStaticPlanner's default, like RunStaticShooter
+		MakePlanners(Actions, 5, With, Without);
+
+		//The shooter goals, and one that needs two of them
+		TArray<TArray<FWorldProperty>> GoalConditions;
+		const FWorldProperty Goals[] =
+		{
+			FWorldProperty(EWorldKey::kTargetDead, (uint8)1),
+			FWorldProperty(EWorldKey::kDisturbanceHandled, (uint8)1),
+			FWorldProperty(EWorldKey::kInDanger, (uint8)0),
+			FWorldProperty(EWorldKey::kIdle, (uint8)1),
+		};
+		for (const FWorldProperty& Goal : Goals)
+		{
+			GoalConditions[GoalConditions.AddDefaulted()].Add(Goal);
+		}
+		TArray<FWorldProperty>& Combined = GoalConditions[GoalConditions.AddDefaulted()];
+		Combined.Add(Goals[0]);
+		Combined.Add(Goals[1]);
+		for (TArray<FWorldProperty>& Condition : GoalConditions)
+		{
+			for (FWorldProperty& Property : Condition)
+			{
+				Property.bIsNotSolvable = false;
+			}
+		}
+		FCompiledPlannerDomain Domain;
+		Domain.Compile(Actions, GoalConditions);
+
+		const EWorldKey StartKeys[] = { EWorldKey::kIdle, EWorldKey::kTargetDead, EWorldKey::kDisturbanceHandled, EWorldKey::kUsingObject, EWorldKey::kTargetSuppressed, EWorldKey::kInDanger };
+		FRandomStream Stream(Seed);
+		for (int32 SearchIdx = 0; SearchIdx < NumSearches; ++SearchIdx)
+		{
+			FWorldState Start;
+			for (EWorldKey Key : StartKeys)
+			{
+				Start.SetProp(Key, (uint8)Stream.RandRange(0, 1));
+			}
+			const int32 GoalIdx = SearchIdx % GoalConditions.Num();
+			Compare(With, Without, Domain, GoalIdx, GoalConditions[GoalIdx], Start);
+		}
+
+		for (UGOAPAction* Action : Actions)
+		{
+			Action->RemoveFromRoot();
+		}
+	}
+	else
+	{
+		for (int32 SearchIdx = 0; SearchIdx < NumSearches; ++SearchIdx)
+		{
+			FSyntheticDomainParams Params;
+			Params.SolutionDepth = 2 + SearchIdx % 5;
+			Params.Seed = Seed + SearchIdx;
+
+			TArray<UGOAPAction*> Actions;
+			TArray<FWorldProperty> Goal;
+			FWorldState Start;
+			GenerateDomain(Params, GetTransientPackage(), Actions, Goal, Start);
+			FAStarPlanner With;
+			FAStarPlanner Without;
+			MakePlanners(Actions, Params.SolutionDepth * 2, With, Without);
+
+			TArray<TArray<FWorldProperty>> GoalConditions;
+			GoalConditions.Add(Goal);
+			FCompiledPlannerDomain Domain;
+			Domain.Compile(Actions, GoalConditions);
+			Compare(With, Without, Domain, 0, Goal, Start);
+		}
+	}
+
+	if (NumSearches > 0)
+	{
+		Result.MeanMsWith = (SecondsWith * 1000.0) / NumSearches;
+		Result.MeanMsWithout = (SecondsWithout * 1000.0) / NumSearches;
+	}
+	return Result;
+}
+
+//GOAP.Benchmark [Keys] [Actions] [Branching] [Depth] [Searches] [Seed]
+static FAutoConsoleCommand BenchmarkCommand(
+	TEXT("GOAP.Benchmark"),
+	TEXT("Runs FAStarPlanner on a synthetic domain and writes the results to Saved/Profiling/GOAPBenchmark.json. Args: Keys Actions Branching Depth Searches Seed"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		FSyntheticDomainParams Params;
+		int32* Fields[] = { &Params.NumKeys, &Params.NumActions, &Params.BranchingFactor, &Params.SolutionDepth, &Params.NumSearches, &Params.Seed };
+		for (int32 Idx = 0; Idx < Args.Num() && Idx < int32(sizeof(Fields) / sizeof(Fields[0])); ++Idx)
+		{
+			*Fields[Idx] = FCString::Atoi(*Args[Idx]);
+		}
+
+		const FPlannerBenchmarkResult Result = FPlannerBenchmark::Run(Params);
+		UE_LOG(LogPlannerBenchmark, Log, TEXT("%s"), *Result.ToJson());
+		FPlannerBenchmark::WriteResults(TEXT("GOAPBenchmark"), Result.ToJsonObject());
+	})
+);
+
+//GOAP.Benchmark.Agents [Frames] [Seed]
+static FAutoConsoleCommand AgentBatchBenchmarkCommand(
+	TEXT("GOAP.Benchmark.Agents"),
+	TEXT("Times the planner subsystem's per frame agent passes for 100, 500 and 2000 agents and writes the results to Saved/Profiling/GOAPAgentBatch.json. Args: Frames Seed"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumFrames = (Args.Num() > 0) ? FCString::Atoi(*Args[0]) : 300;
+		const int32 Seed = (Args.Num() > 1) ? FCString::Atoi(*Args[1]) : 1234;
+
+		const int32 AgentCounts[] = { 100, 500, 2000 };
+		TArray<TSharedPtr<FJsonValue>> Runs;
+		for (int32 NumAgents : AgentCounts)
+		{
+			const FAgentBatchBenchmarkResult Result = FPlannerBenchmark::RunAgentBatch(NumAgents, NumFrames, Seed);
+			UE_LOG(LogPlannerBenchmark, Log, TEXT("%d agents: %.4f ms mean, %.4f ms p99, %.4f ms single threaded"), NumAgents, Result.MeanMs, Result.P99Ms, Result.SingleThreadMeanMs);
+			Runs.Add(MakeShared<FJsonValueObject>(Result.ToJsonObject()));
+		}
+
+		TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+		Root->SetArrayField(TEXT("runs"), Runs);
+		FPlannerBenchmark::WriteResults(TEXT("GOAPAgentBatch"), Root);
+	})
+);
+
+//GOAP.Benchmark.Squads [SquadSize] [Frames] [Seed]
+static FAutoConsoleCommand SquadBenchmarkCommand(
+	TEXT("GOAP.Benchmark.Squads"),
+	TEXT("Compares shared squad world state writes with per agent writes for 100, 500 and 2000 agents and writes the results to Saved/Profiling/GOAPSquadBatch.json. Args: SquadSize Frames Seed"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 SquadSize = (Args.Num() > 0) ? FCString::Atoi(*Args[0]) : 8;
+		const int32 NumFrames = (Args.Num() > 1) ? FCString::Atoi(*Args[1]) : 300;
+		const int32 Seed = (Args.Num() > 2) ? FCString::Atoi(*Args[2]) : 1234;
+
+		const int32 AgentCounts[] = { 100, 500, 2000 };
+		TArray<TSharedPtr<FJsonValue>> Runs;
+		for (int32 NumAgents : AgentCounts)
+		{
+			const FSquadBenchmarkResult Result = FPlannerBenchmark::RunSquadBatch(NumAgents, SquadSize, NumFrames, Seed);
+			UE_LOG(LogPlannerBenchmark, Log, TEXT("%d agents: shared %.4f ms (%lld bytes), per agent %.4f ms (%lld bytes)"),
+				NumAgents, Result.SharedMs, Result.SharedBytes, Result.PerAgentMs, Result.PerAgentBytes);
+			Runs.Add(MakeShared<FJsonValueObject>(Result.ToJsonObject()));
+		}
+
+		TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+		Root->SetArrayField(TEXT("runs"), Runs);
+		FPlannerBenchmark::WriteResults(TEXT("GOAPSquadBatch"), Root);
+	})
+);
+
+//GOAP.Benchmark.SquadReplans [Events] [Seed]
+static FAutoConsoleCommand SquadReplanBenchmarkCommand(
+	TEXT("GOAP.Benchmark.SquadReplans"),
+	TEXT("Times a squad replanning on one event with and without shared plans for squads of 1 to 32 and writes the results to Saved/Profiling/GOAPSquadReplans.json. Args: Events Seed"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumEvents = (Args.Num() > 0) ? FCString::Atoi(*Args[0]) : 500;
+		const int32 Seed = (Args.Num() > 1) ? FCString::Atoi(*Args[1]) : 1234;
+
+		const int32 SquadSizes[] = { 1, 2, 4, 8, 16, 32 };
+		TArray<TSharedPtr<FJsonValue>> Runs;
+		for (int32 SquadSize : SquadSizes)
+		{
+			const FSquadReplanBenchmarkResult Result = FPlannerBenchmark::RunSquadReplans(SquadSize, NumEvents, Seed);
+			UE_LOG(LogPlannerBenchmark, Log, TEXT("Squad of %d: shared %.4f ms (%.2f searches), per agent %.4f ms (%.2f searches) per event"),
+				SquadSize, Result.SharedMs, double(Result.SharedSearches) / FMath::Max(NumEvents, 1), Result.PerAgentMs, double(Result.PerAgentSearches) / FMath::Max(NumEvents, 1));
+			Runs.Add(MakeShared<FJsonValueObject>(Result.ToJsonObject()));
+		}
+
+		TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+		Root->SetArrayField(TEXT("runs"), Runs);
+		FPlannerBenchmark::WriteResults(TEXT("GOAPSquadReplans"), Root);
+	})
+);
+
+//GOAP.Benchmark.Landmarks [Searches] [Seed]
+static FAutoConsoleCommand LandmarkBenchmarkCommand(
+	TEXT("GOAP.Benchmark.Landmarks"),
+	TEXT("Runs FAStarPlanner with and without the landmark heuristic on synthetic and shooter searches and writes the results to Saved/Profiling/GOAPLandmarks.json. Args: Searches Seed"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumSearches = (Args.Num() > 0) ? FCString::Atoi(*Args[0]) : 200;
+		const int32 Seed = (Args.Num() > 1) ? FCString::Atoi(*Args[1]) : 1234;
+
+		TArray<TSharedPtr<FJsonValue>> Runs;
+		const bool Domains[] = { false, true };
+		for (bool bShooter : Domains)
+		{
+			const FLandmarkBenchmarkResult Result = FPlannerBenchmark::RunLandmarks(bShooter, NumSearches, Seed);
+			UE_LOG(LogPlannerBenchmark, Log, TEXT("%s: %lld nodes expanded with landmarks, %lld without, %.4f ms against %.4f ms, %d cost mismatches"),
+				*Result.DomainName, Result.NodesExpandedWith, Result.NodesExpandedWithout, Result.MeanMsWith, Result.MeanMsWithout, Result.NumCostMismatches);
+			Runs.Add(MakeShared<FJsonValueObject>(Result.ToJsonObject()));
+		}
+
+		TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+		Root->SetArrayField(TEXT("runs"), Runs);
+		FPlannerBenchmark::WriteResults(TEXT("GOAPLandmarks"), Root);
+	})
+);
+
+//GOAP.Benchmark.Static [Searches] [Seed]
+static FAutoConsoleCommand StaticBenchmarkCommand(
+	TEXT("GOAP.Benchmark.Static"),
+	TEXT("Runs TStaticPlanner<FShooterPlannerSchema> and FAStarPlanner on the same searches and writes the results to Saved/Profiling/GOAPStaticPlanner.json. Args: Searches Seed"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumSearches = (Args.Num() > 0) ? FCString::Atoi(*Args[0]) : 1000;
+		const int32 Seed = (Args.Num() > 1) ? FCString::Atoi(*Args[1]) : 1234;
+
+		const FStaticPlannerBenchmarkResult Result = FPlannerBenchmark::RunStaticShooter(NumSearches, Seed);
+		UE_LOG(LogPlannerBenchmark, Log, TEXT("static %.4f ms, runtime %.4f ms, %d mismatches"), Result.StaticMeanMs, Result.RuntimeMeanMs, Result.NumMismatches);
+
+		FPlannerBenchmark::WriteResults(TEXT("GOAPStaticPlanner"), Result.ToJsonObject());
+	})
+);
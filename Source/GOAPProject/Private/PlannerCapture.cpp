@@ -0,0 +1,220 @@
+#include "../Public/PlannerCapture.h"
+#include "../Public/PlannerComponent.h"
+#include "../Public/GOAPAction.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+#include "Serialization/Archive.h"
+
+DEFINE_LOG_CATEGORY(LogPlannerCapture);
+
+namespace
+{
+	//'GOAP'
+	const uint32 CaptureMagic = 0x50414F47;
+	//2: plan steps
+	//3: compiled domain, goal index, search options and plan cost
+	const uint32 CaptureVersion = 3;
+
+	TAutoConsoleVariable<int32> CVarPlannerCapture(
+		TEXT("GOAP.Capture"),
+		0,
+		TEXT("Record every FAStarPlanner::Search call to Saved/Profiling/GOAPCapture-*.bin for offline replay"),
+		ECVF_Default);
+
+	FArchive* CaptureWriter = nullptr;
+
+	void SerializeHeader(FArchive& Ar, uint32& Magic, uint32& Version, uint32& LayoutBits, uint32& NumKeys)
+	{
+		Ar << Magic;
+		Ar << Version;
+		Ar << LayoutBits;
+		Ar << NumKeys;
+	}
+}
+
+FArchive& operator<<(FArchive& Ar, FWorldProperty& Property)
+{
+	Ar << Property.Key;
+	Ar << Property.Comparator;
+	Ar << Property.KeyRHS;
+	Ar << Property.Value;
+	Ar << Property.bIsNotSolvable;
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FAISymEffect& Effect)
+{
+	Ar << Effect.Key;
+	Ar << Effect.Op;
+	Ar << Effect.KeyRHS;
+	Ar << Effect.Value;
+	Ar << Effect.bExpected;
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FCapturedAction& Action)
+{
+	Ar << Action.Name;
+	Ar << Action.Preconditions;
+	Ar << Action.Effects;
+	Ar << Action.Cost;
+	Ar << Action.bContextValid;
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FPlannerCaptureRecord& Record)
+{
+	Ar << Record.GoalCondition;
+	Ar << Record.InitialState;
+	Ar << Record.MaxDepth;
+	Ar << Record.Actions;
+	Ar << Record.DomainPath;
+	Ar << Record.GoalIdx;
+	Ar << Record.bUseSlices;
+	Ar << Record.bUseLandmarks;
+	Ar << Record.bUseMutexes;
+	Ar << Record.bFound;
+	Ar << Record.PlanLength;
+	Ar << Record.PlanCost;
+	Ar << Record.SearchMs;
+	Ar << Record.PlanActions;
+	return Ar;
+}
+
+bool FPlannerCapture::IsCapturing()
+{
+	return CVarPlannerCapture.GetValueOnGameThread() != 0;
+}
+
+FString FPlannerCapture::GetActionId(const UGOAPAction& Action)
+{
+	const FString ActionName = Action.GetActionName();
+	return ActionName.IsEmpty() ? Action.GetName() : ActionName;
+}
+
+void FPlannerCapture::Record(const FAStarPlanner& Planner, const FCompiledPlannerDomain* Domain, int32 GoalIdx, const TArray<FWorldProperty>& GoalCondition,
+	const FWorldState& InitialState, const TMap<const UGOAPAction*, bool>& ContextResults, bool bFound, const TArray<FPlanStepInfo>& Plan, double SearchMs)
+{
+	check(IsInGameThread());
+
+	if (!CaptureWriter)
+	{
+		const FString Path = FPaths::ProfilingDir() / FString::Printf(TEXT("GOAPCapture-%s.bin"), *FDateTime::Now().ToString());
+		CaptureWriter = IFileManager::Get().CreateFileWriter(*Path);
+		if (!CaptureWriter)
+		{
+			UE_LOG(LogPlannerCapture, Error, TEXT("Could not open %s, disabling capture"), *Path);
+			CVarPlannerCapture->Set(0);
+			return;
+		}
+		uint32 Magic = CaptureMagic;
+		uint32 Version = CaptureVersion;
+		uint32 LayoutBits = FWorldStateLayout::TotalBits;
+		uint32 NumKeys = (uint32)EWorldKey::SYMBOL_MAX;
+		SerializeHeader(*CaptureWriter, Magic, Version, LayoutBits, NumKeys);
+		UE_LOG(LogPlannerCapture, Log, TEXT("Capturing planner searches to %s"), *Path);
+	}
+
+	FPlannerCaptureRecord NewRecord;
+	NewRecord.GoalCondition = GoalCondition;
+	NewRecord.InitialState = InitialState;
+	NewRecord.MaxDepth = Planner.MaxDepth;
+	const TArray<TWeakObjectPtr<UGOAPAction>>& PlannerActions = Planner.GetActions();
+	//Same check as the search, a domain compiled for other actions isn't used
+	if (Domain && Domain->NumActions == PlannerActions.Num())
+	{
+		NewRecord.DomainPath = Domain->SourcePath;
+		NewRecord.GoalIdx = GoalIdx;
+	}
+	NewRecord.bUseSlices = Planner.bUseSlices;
+	NewRecord.bUseLandmarks = Planner.bUseLandmarks;
+	NewRecord.bUseMutexes = Planner.bUseMutexes;
+	NewRecord.bFound = bFound;
+	NewRecord.PlanLength = Plan.Num();
+	NewRecord.SearchMs = SearchMs;
+
+	TMap<const UGOAPAction*, int32> ActionCosts;
+	for (int32 ActionIdx = 0; ActionIdx < PlannerActions.Num(); ++ActionIdx)
+	{
+		const UGOAPAction* Action = PlannerActions[ActionIdx].Get();
+		FCapturedAction& Captured = NewRecord.Actions[NewRecord.Actions.AddDefaulted()];
+		if (!Action)
+		{
+			Captured.bContextValid = false;
+			continue;
+		}
+		//The id, so replayed plans can be compared step by step with PlanActions
+		Captured.Name = GetActionId(*Action);
+		Captured.Preconditions = Action->GetPreconditions();
+		Captured.Effects = Action->GetEffects();
+		//The snapshot the search used, dynamic costs included
+		Captured.Cost = Planner.GetCachedCost(ActionIdx);
+		const bool* bContextValid = ContextResults.Find(Action);
+		Captured.bContextValid = bContextValid ? *bContextValid : true;
+		ActionCosts.Add(Action, Captured.Cost);
+	}
+	for (const FPlanStepInfo& Step : Plan)
+	{
+		NewRecord.PlanActions.Add(Step.Action ? GetActionId(*Step.Action) : FString());
+		const int32* Cost = ActionCosts.Find(Step.Action);
+		NewRecord.PlanCost += Cost ? *Cost : 0;
+	}
+
+	*CaptureWriter << NewRecord;
+}
+
+void FPlannerCapture::Flush()
+{
+	if (CaptureWriter)
+	{
+		CaptureWriter->Close();
+		delete CaptureWriter;
+		CaptureWriter = nullptr;
+	}
+}
+
+bool FPlannerCapture::LoadFile(const FString& Path, TArray<FPlannerCaptureRecord>& OutRecords)
+{
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Path));
+	if (!Reader)
+	{
+		UE_LOG(LogPlannerCapture, Error, TEXT("Could not open %s"), *Path);
+		return false;
+	}
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	uint32 LayoutBits = 0;
+	uint32 NumKeys = 0;
+	SerializeHeader(*Reader, Magic, Version, LayoutBits, NumKeys);
+	if (Magic != CaptureMagic || Version != CaptureVersion)
+	{
+		UE_LOG(LogPlannerCapture, Error, TEXT("%s is not a planner capture (or is an old version)"), *Path);
+		return false;
+	}
+	if (LayoutBits != FWorldStateLayout::TotalBits || NumKeys != (uint32)EWorldKey::SYMBOL_MAX)
+	{
+		UE_LOG(LogPlannerCapture, Error, TEXT("%s was captured with a different world state layout"), *Path);
+		return false;
+	}
+
+	while (!Reader->AtEnd() && !Reader->IsError())
+	{
+		FPlannerCaptureRecord& Record = OutRecords[OutRecords.AddDefaulted()];
+		*Reader << Record;
+	}
+	if (Reader->IsError())
+	{
+		UE_LOG(LogPlannerCapture, Warning, TEXT("%s is truncated, dropping the last record"), *Path);
+		OutRecords.Pop();
+	}
+	return true;
+}
+
+static FAutoConsoleCommand CaptureFlushCommand(
+	TEXT("GOAP.Capture.Flush"),
+	TEXT("Closes the current planner capture file"),
+	FConsoleCommandDelegate::CreateStatic(&FPlannerCapture::Flush)
+);
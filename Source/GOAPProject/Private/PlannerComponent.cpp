@@ -1,11 +1,23 @@
 #include "../Public/PlannerComponent.h"
 #include "../Public/PlannerAsset.h"
 #include "../Public/GOAPAction.h"
+#include "../Public/GOAPCostProvider.h"
+#include "../Public/GOAPInsistenceSubsystem.h"
+#include "../Public/GOAPPlannerSubsystem.h"
+#include "../Public/GOAPDecorator.h"
+#include "Perception/AIPerceptionComponent.h"
 #include "../Public/GOAPGoal.h"
 #include "../Public/StateNode.h"
 #include "../Public/PlannerService.h"
+#include "../Public/GOAPStats.h"
+#include "../Public/PlannerCapture.h"
+#include "../Public/ShooterPlannerSchema.h"
 #include "AIController.h"
 #include "BehaviorTree/BlackboardComponent.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Bool.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Enum.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Float.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Int.h"
 
 
 void FPlanStepInfo::SetAction(UGOAPAction* NewAction)
@@ -13,130 +25,235 @@ void FPlanStepInfo::SetAction(UGOAPAction* NewAction)
 	Action = NewAction;
 }
 
-void FPlanStepInfo::SetResolvedWS(const FWorldState& WS)
+void FPlanStepInfo::SetResolvedWS(const FWorldState& WS, const FWorldState& PlanStartWS)
 {
-	ResolvedWS = WS;
+	ResolvedDelta.Build(Action, WS, PlanStartWS);
+}
+
+void FResolvedWSDelta::Build(const UGOAPAction* Action, const FWorldState& ResolvedWS, const FWorldState& PlanStartWS)
+{
+	KeyMask = 0;
+	if (!Action)
+	{
+		return;
+	}
+	auto AddKey = [&](EWorldKey Key)
+	{
+		const uint8 Value = ResolvedWS.GetProp(Key);
+		if (Value != PlanStartWS.GetProp(Key))
+		{
+			KeyMask |= 1u << (uint32)Key;
+			Values.SetProp(Key, Value);
+		}
+	};
+	for (const FAISymEffect& Effect : Action->GetEffects())
+	{
+		if (Effect.KeyRHS != EWorldKey::SYMBOL_MAX)
+		{
+			AddKey(Effect.Key);
+			AddKey(Effect.KeyRHS);
+		}
+	}
+}
+
+bool FResolvedWSDelta::Find(EWorldKey Key, uint8& OutValue) const
+{
+	if ((KeyMask & (1u << (uint32)Key)) == 0)
+	{
+		return false;
+	}
+	OutValue = Values.GetProp(Key);
+	return true;
 }
 
 //FAStarPlanner 
 //Should move this into the same file as StateNode
-bool FAStarPlanner::Search(const TArray<FWorldProperty>& GoalCondition, const FWorldState& InitialState, TArray<FPlanStepInfo>& Plan)
+bool FAStarPlanner::Search(const TArray<FWorldProperty>& GoalCondition, const FWorldState& InitialState, TArray<FPlanStepInfo>& Plan, const FCompiledPlannerDomain* Domain, int32 GoalIdx)
 {
-	//Fringe is a priority queue in textbook A*
-	//Use TArray's heap functionality to mimic a priority queue
-
-	FPriorityQueue Fringe;
+	SCOPE_CYCLE_COUNTER(STAT_GOAP_Search);
+	CSV_SCOPED_TIMING_STAT(GOAP, Search);
 
-	//To save time, ALL nodes are added to a single set, and keep track of whether they're closed
-	//This does mean that we're using additional space, but it's easier and faster, I think
-	TSet<NodePtr, FStateNode::SetKeyFuncs> NodePool;
+	if (!FPlannerCapture::IsCapturing())
+	{
+		return SearchInternal(GoalCondition, InitialState, Plan, Domain, GoalIdx);
+	}
 
-	NodePtr CurrentNode = MakeShared<FStateNode>(InitialState, GoalCondition);
+	TMap<const UGOAPAction*, bool> ContextResults;
+	ObservedContextResults = &ContextResults;
+	//The capture needs every context result the search uses, so the tables are refreshed again
+	bSearchPrepared = false;
+	const double StartTime = FPlatformTime::Seconds();
+	//Actions outside the slice are recorded as valid, they are never candidates for this goal so the replay finds the same plan
+	const bool bFound = SearchInternal(GoalCondition, InitialState, Plan, Domain, GoalIdx);
+	const double SearchMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	ObservedContextResults = nullptr;
+
+	FPlannerCapture::Record(*this, Domain, GoalIdx, GoalCondition, InitialState, ContextResults, bFound, Plan, SearchMs);
+	return bFound;
+}
 
-	Fringe.Push(CurrentNode);
-	NodePool.Add(CurrentNode);
-	//TODO: empty the fringe before exiting
-	while (Fringe.Num() != 0)
+namespace
+{
+	/** Successor policy for FAStarPlanner
+	  * Candidate edges come from the EdgeTable, filtered by the actions the search may use, and are
+	  * charged the per-search cost snapshot. Children the search's mutexes rule out are dropped.
+	  */
+	struct FIndexedSuccessors
 	{
-
-		//pop the lowest cost node from p-queue
-		Fringe.Pop(CurrentNode);
-		if (!CurrentNode.IsValid())
+		const TMultiMap<EWorldKey, int32>& EdgeTable;
+		const TArray<TWeakObjectPtr<UGOAPAction>>& ActionList;
+		const TBitArray<>& SearchActions;
+		const TArray<int32>& CostTable;
+		const FRegressionAnalysis* Analysis;
+		int32 NumMutexPrunes = 0;
+		int32 NumAllocated = 0;
+		TArray<int32> CandidateEdges;
+
+		FIndexedSuccessors(const TMultiMap<EWorldKey, int32>& InEdgeTable, const TArray<TWeakObjectPtr<UGOAPAction>>& InActionList,
+			const TBitArray<>& InSearchActions, const TArray<int32>& InCostTable, const FRegressionAnalysis* InAnalysis)
+			: EdgeTable(InEdgeTable), ActionList(InActionList), SearchActions(InSearchActions), CostTable(InCostTable), Analysis(InAnalysis)
 		{
-			break;
 		}
-		CurrentNode->MarkClosed();
-		//This is a regressive search
-		//a goal node g is any node s.t. all values of the node's state match that of the initial state
-		if (CurrentNode->IsGoal())
+
+		template<typename EmitType>
+		FORCEINLINE void Generate(FStateNode& Node, EmitType&& Emit)
 		{
-			break;
+			//Generate candidate edges (actions)
+			CandidateEdges.Reset();
+			Node.GetNeighboringEdges(EdgeTable, CandidateEdges);
+
+			//Available actions not yet visited for this node
+			TBitArray<> OpenActions = SearchActions;
+			for (int32 ActionIdx : CandidateEdges)
+			{
+				//context preconditions were verified once for the whole search
+				//skip action if it has already been visited for this node
+				if (!OpenActions[ActionIdx])
+				{
+					continue;
+				}
+				//mark edge as visited for current node
+				OpenActions[ActionIdx] = false;
+
+				UGOAPAction* Action = ActionList[ActionIdx].Get();
+				if (!Action)
+				{
+					UE_LOG(LogAction, Error, TEXT("Bad Action access in planner!!"));
+					UE_LOG(LogAction, Error, TEXT("You probably dumped the ActionSet somewhere, again"));
+					continue;
+				}
+
+				//Create the Child node 
+				TSharedPtr<FStateNode> ChildNode = MakeShared<FStateNode>(Node);
+				++NumAllocated;
+				if (!ChildNode->ChainBackward(*Action, CostTable[ActionIdx]))
+				{
+					continue;
+				}
+				if (Analysis && Analysis->IsMutex(ChildNode->CurrentState.Get(), ChildNode->ExactKeys))
+				{
+					++NumMutexPrunes;
+					continue;
+				}
+				Emit(ChildNode);
+			}
 		}
+	};
+
+	/** Heuristic policy for the landmarks the start state is missing, see FRegressionAnalysis::GetLandmarkCost
+	  * The unsatisfied keys the node's own heuristic counts are landmarks too, so the node is charged
+	  * the larger of the two rather than their sum.
+	  */
+	struct FLandmarkHeuristic
+	{
+		const FRegressionAnalysis& Analysis;
+		const TArray<int32>& CostTable;
 
-		if (CurrentNode->GetDepth() > MaxDepth)
+		FLandmarkHeuristic(const FRegressionAnalysis& InAnalysis, const TArray<int32>& InCostTable) : Analysis(InAnalysis), CostTable(InCostTable) {}
+
+		FORCEINLINE int32 operator()(const FStateNode& Node) const
 		{
-			//Do not want to accidentally generate partial plan
-			//if last node in fringe went over MaxDepth
-			CurrentNode = nullptr;
-			continue;
+			return FMath::Max(0, Analysis.GetLandmarkCost(Node.CurrentState.Get(), Node.ExactKeys, Node.UnsatisfiedKeys, CostTable) - Node.Heuristic);
 		}
+	};
+}
 
-		//Generate candidate edges (actions)
-		TArray<TWeakObjectPtr<UGOAPAction>> CandidateEdges;
-		CurrentNode->GetNeighboringEdges(EdgeTable, CandidateEdges);
+void FAStarPlanner::PrepareSearch(const FWorldState& InitialState, const FCompiledPlannerDomain* Domain, int32 GoalIdx)
+{
+	LastSearchStats = FPlannerSearchStats();
+	PreparedDomain = Domain;
+	PreparedGoalIdx = GoalIdx;
+	if (Domain && !ensureMsgf(Domain->NumActions == ActionList.Num(), TEXT("Planner domain was compiled for a different action list")))
+	{
+		Domain = nullptr;
+	}
+	SearchDomain = Domain;
+	const TBitArray<>* Slice = (Domain && bUseSlices) ? Domain->GetActionSlice(GoalIdx) : nullptr;
+	RefreshActionTables(InitialState, Slice);
 
-		TSet<UGOAPAction*> VisitedActions;
-		for (auto ActionHandle : CandidateEdges)
+	SearchActions = ContextAvailable;
+	if (Slice)
+	{
+		for (int32 ActionIdx = 0; ActionIdx < SearchActions.Num(); ++ActionIdx)
 		{
+			SearchActions[ActionIdx] = SearchActions[ActionIdx] && (*Slice)[ActionIdx];
+		}
+	}
+	//Without a slice any key can turn up in a precondition
+	SearchKeys = Slice ? Domain->GoalSlices[GoalIdx].RelevantKeys : (1u << (uint32)EWorldKey::SYMBOL_MAX) - 1;
+	bSearchPrepared = true;
+}
 
+bool FAStarPlanner::SearchInternal(const TArray<FWorldProperty>& GoalCondition, const FWorldState& InitialState, TArray<FPlanStepInfo>& Plan, const FCompiledPlannerDomain* Domain, int32 GoalIdx)
+{
+	//The tables are kept if the caller prepared this search, PrepareSearch also started LastSearchStats
+	if (!bSearchPrepared || PreparedDomain != Domain || PreparedGoalIdx != GoalIdx || !(CachedTablesWS == InitialState))
+	{
+		PrepareSearch(InitialState, Domain, GoalIdx);
+	}
+	bSearchPrepared = false;
+	Domain = SearchDomain;
 
-			if (!ActionHandle.IsValid())
-			{
-				UE_LOG(LogAction, Error, TEXT("Bad Action access in planner!!"));
-				UE_LOG(LogAction, Error, TEXT("You probably dumped the ActionSet somewhere, again"));
-				continue;
-			}
+	const FRegressionAnalysis* NodeAnalysis = nullptr;
+	if (Domain && (bUseLandmarks || bUseMutexes))
+	{
+		const int32 AnalysisIdx = FMath::Max(GoalIdx, (int32)INDEX_NONE) + 1;
+		if (GoalAnalyses.Num() <= AnalysisIdx)
+		{
+			GoalAnalyses.SetNum(AnalysisIdx + 1);
+		}
+		FRegressionAnalysis& Analysis = GoalAnalyses[AnalysisIdx];
+		Analysis.Build(*Domain, InitialState, SearchActions, bUseLandmarks, bUseMutexes);
+		NodeAnalysis = &Analysis;
+	}
 
-			//Can move this stuff into GenerateNeighbors
-			UGOAPAction* Action = ActionHandle.Get();
-			//verify context preconditions
-			//skip action if it has already been visited for this node
-			if (!Action->VerifyContext() || VisitedActions.Contains(Action))
-			{
-				continue;
-			}
+	NodePtr StartNode = MakeShared<FStateNode>(InitialState, GoalCondition);
+	if (NodeAnalysis && NodeAnalysis->IsMutex(StartNode->CurrentState.Get(), StartNode->ExactKeys))
+	{
+		//The goal itself asks for facts that can't hold together
+		LastSearchStats.MutexPrunes = 1;
+		PublishSearchStats();
+		return false;
+	}
 
-			//mark edge as visited for current node
-			VisitedActions.Add(Action);
+	FIndexedSuccessors Successors(EdgeTable, ActionList, SearchActions, CostTable, NodeAnalysis);
+	const FDepthLimitedGoal Termination(MaxDepth);
+	const NodePtr GoalNode = (NodeAnalysis && NodeAnalysis->FactLandmarks.Num() > 0)
+		? TRegressiveSearch<>::Run(StartNode, Successors, FLandmarkHeuristic(*NodeAnalysis, CostTable), Termination, LastSearchStats, bMeasureMemory)
+		: TRegressiveSearch<>::Run(StartNode, Successors, FNoExtraHeuristic(), Termination, LastSearchStats, bMeasureMemory);
+	LastSearchStats.MutexPrunes = Successors.NumMutexPrunes;
+	LastSearchStats.NodesAllocated = 1 + Successors.NumAllocated;
 
-			//Create the Child node 
-			NodePtr ChildNode = MakeShared<FStateNode>(*CurrentNode);
-			if (!ChildNode.IsValid())
-			{
-				continue;
-			}
-			if (!ChildNode->ChainBackward(*Action))
-			{
-				continue;
-			}
-			//check if node exists already
-			const NodePtr* FindNode = NodePool.Find(ChildNode);
-			if (FindNode != nullptr && FindNode->IsValid())
-			{
-				NodePtr ExistingNode = *FindNode;
-				if (ChildNode->GetForwardCost() < ExistingNode->GetForwardCost())
-				{
-					ExistingNode->ReParent(*ChildNode);
-					if (ExistingNode->IsClosed())
-					{
-						ExistingNode->MarkOpened();
-						Fringe.Push(ExistingNode);
-					}
-					else
-					{
-						Fringe.ReSort();
-					}
-				}
-			}
-			else
-			{
-				ChildNode->MarkOpened(); //just in case we haven't
-				Fringe.Push(ChildNode);
-				NodePool.Add(ChildNode);
-			}
-		}
-		//If we run out of nodes, we don't want to still be referencing a valid node
-		CurrentNode.Reset();
-	}
+	PublishSearchStats();
 
-	if (CurrentNode.IsValid())
+	if (GoalNode.IsValid())
 	{
-		const FStateNode* Node = CurrentNode.Get();
+		const FStateNode* Node = GoalNode.Get();
 		while (Node && Node->ParentNode.IsValid())
 		{
 			FPlanStepInfo NewStep;
 			NewStep.SetAction(Node->ParentEdge.Get());
-			NewStep.SetResolvedWS(Node->ParentNode.Pin()->CurrentState.Get()); //whew
+			NewStep.SetResolvedWS(Node->ParentNode.Pin()->CurrentState.Get(), InitialState); //whew
 			Plan.Add(NewStep);
 			Node = Node->ParentNode.Pin().Get();
 		}
@@ -145,26 +262,244 @@ bool FAStarPlanner::Search(const TArray<FWorldProperty>& GoalCondition, const FW
 	return false;
 }
 
+void FAStarPlanner::PublishSearchStats() const
+{
+	INC_DWORD_STAT_BY(STAT_GOAP_NodesExpanded, LastSearchStats.NodesExpanded);
+	INC_DWORD_STAT_BY(STAT_GOAP_NodesGenerated, LastSearchStats.NodesGenerated);
+	INC_DWORD_STAT_BY(STAT_GOAP_DuplicateHits, LastSearchStats.DuplicateHits);
+	INC_DWORD_STAT_BY(STAT_GOAP_Reparents, LastSearchStats.Reparents);
+	INC_DWORD_STAT_BY(STAT_GOAP_MutexPrunes, LastSearchStats.MutexPrunes);
+
+	CSV_CUSTOM_STAT(GOAP, NodesExpanded, LastSearchStats.NodesExpanded, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(GOAP, NodesGenerated, LastSearchStats.NodesGenerated, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(GOAP, DuplicateHits, LastSearchStats.DuplicateHits, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(GOAP, Reparents, LastSearchStats.Reparents, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(GOAP, MutexPrunes, LastSearchStats.MutexPrunes, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(GOAP, FringePeak, LastSearchStats.FringePeak, ECsvCustomStatOp::Max);
+
+}
+
 void FAStarPlanner::AddAction(UGOAPAction* Action)
 {
+	bSearchPrepared = false;
+	if (ActionList.Contains(Action))
+	{
+		return;
+	}
+	const int32 ActionIdx = ActionList.Add(Action);
+	ContextAvailable.Add(false);
+	ContextCached.Add(false);
+	CostTable.Add(Action->Cost());
+	CostCached.Add(false);
+
+	static_assert((uint32)EWorldKey::SYMBOL_MAX <= 32, "ContextKeyMasks needs a bit per EWorldKey");
+	uint32 KeyMask = 0;
+	for (EWorldKey Key : Action->GetContextInvalidationKeys())
+	{
+		if (Key != EWorldKey::SYMBOL_MAX)
+		{
+			KeyMask |= 1u << (uint32)Key;
+		}
+	}
+	ContextKeyMasks.Add(KeyMask);
+
+	//Without a provider the cost is EdgeCost and never changes
+	uint32 CostKeyMask = 0;
+	if (const UGOAPCostProvider* Provider = Action->GetCostProvider())
+	{
+		for (EWorldKey Key : Provider->GetDependencyKeys())
+		{
+			if (Key != EWorldKey::SYMBOL_MAX)
+			{
+				CostKeyMask |= 1u << (uint32)Key;
+			}
+		}
+	}
+	CostKeyMasks.Add(CostKeyMask);
+
 	for (const auto& Effect : Action->GetEffects())
 	{
-		EdgeTable.AddUnique(Effect.Key, Action);
+		EdgeTable.AddUnique(Effect.Key, ActionIdx);
 	}
 }
 
 void FAStarPlanner::RemoveAction(UGOAPAction* Action)
 {
-	//Nothing for now
+	bSearchPrepared = false;
+	const int32 ActionIdx = ActionList.IndexOfByKey(Action);
+	if (ActionIdx == INDEX_NONE)
+	{
+		return;
+	}
+	ActionList[ActionIdx] = nullptr;
+	ContextAvailable[ActionIdx] = false;
+	ContextCached[ActionIdx] = false;
+	CostCached[ActionIdx] = false;
 	for (const auto& Effect : Action->GetEffects())
 	{
-		EdgeTable.RemoveSingle(Effect.Key, Action);
+		EdgeTable.RemoveSingle(Effect.Key, ActionIdx);
 	}
 }
 
 void FAStarPlanner::ClearEdgeTable()
 {
+	bSearchPrepared = false;
 	EdgeTable.Empty();
+	ActionList.Empty();
+	ContextAvailable.Empty();
+	ContextCached.Empty();
+	ContextKeyMasks.Empty();
+	CostTable.Empty();
+	CostCached.Empty();
+	CostKeyMasks.Empty();
+}
+
+void FAStarPlanner::InvalidateContext(const UGOAPAction* Action)
+{
+	bSearchPrepared = false;
+	const int32 ActionIdx = ActionList.IndexOfByKey(Action);
+	if (ActionIdx != INDEX_NONE)
+	{
+		ContextCached[ActionIdx] = false;
+	}
+}
+
+void FAStarPlanner::InvalidateAllContexts()
+{
+	bSearchPrepared = false;
+	ContextCached.Init(false, ContextCached.Num());
+}
+
+void FAStarPlanner::InvalidateCosts()
+{
+	bSearchPrepared = false;
+	CostCached.Init(false, CostCached.Num());
+}
+
+void FAStarPlanner::RefreshActionTables(const FWorldState& InitialState, const TBitArray<>* Slice)
+{
+	uint32 ChangedKeys = 0;
+	for (uint32 Key = 0; Key < (uint32)EWorldKey::SYMBOL_MAX; ++Key)
+	{
+		if (InitialState.GetProp((EWorldKey)Key) != CachedTablesWS.GetProp((EWorldKey)Key))
+		{
+			ChangedKeys |= 1u << Key;
+		}
+	}
+	CachedTablesWS = InitialState;
+
+	for (int32 ActionIdx = 0; ActionIdx < ActionList.Num(); ++ActionIdx)
+	{
+		UGOAPAction* Action = ActionList[ActionIdx].Get();
+		if (!Action)
+		{
+			ContextAvailable[ActionIdx] = false;
+			continue;
+		}
+		if (Slice && !(*Slice)[ActionIdx])
+		{
+			//CachedTablesWS moves on without this action, so drop whatever the change would have invalidated
+			if ((ContextKeyMasks[ActionIdx] & ChangedKeys) != 0)
+			{
+				ContextCached[ActionIdx] = false;
+			}
+			if ((CostKeyMasks[ActionIdx] & ChangedKeys) != 0)
+			{
+				CostCached[ActionIdx] = false;
+			}
+			continue;
+		}
+		LastSearchStats.CacheLookups += 2;
+		if (!ContextCached[ActionIdx] || (ContextKeyMasks[ActionIdx] & ChangedKeys) != 0)
+		{
+			ContextAvailable[ActionIdx] = Action->VerifyContext();
+			ContextCached[ActionIdx] = Action->CachesContext();
+		}
+		else
+		{
+			++LastSearchStats.CacheHits;
+		}
+		if (!CostCached[ActionIdx] || (CostKeyMasks[ActionIdx] & ChangedKeys) != 0)
+		{
+			const UGOAPCostProvider* Provider = Action->GetCostProvider();
+			CostTable[ActionIdx] = Action->SnapshotCost(InitialState);
+			CostCached[ActionIdx] = !Provider || !Provider->ShouldAlwaysRefresh();
+		}
+		else
+		{
+			++LastSearchStats.CacheHits;
+		}
+		if (ObservedContextResults)
+		{
+			ObservedContextResults->Add(Action, ContextAvailable[ActionIdx]);
+		}
+	}
+}
+
+void FGoalPriorityQueue::Update(UGOAPGoal& Goal)
+{
+	Sorted.RemoveSingle(&Goal);
+	const float Insistence = Goal.GetInsistence();
+	if (!Goal.IsValid() || Insistence <= 0.f)
+	{
+		return;
+	}
+	//Goals with equal insistence keep the order they were added in
+	int32 InsertIdx = 0;
+	while (InsertIdx < Sorted.Num() && Sorted[InsertIdx]->GetInsistence() >= Insistence)
+	{
+		++InsertIdx;
+	}
+	Sorted.Insert(&Goal, InsertIdx);
+}
+
+void FPlannerDebugStats::AddSearch(float Ms, const FPlannerSearchStats& Stats)
+{
+	SearchMs[NextSample] = Ms;
+	NextSample = (NextSample + 1) % LatencyWindow;
+	NumSamples = FMath::Min(NumSamples + 1, LatencyWindow);
+
+	LastNodesExpanded = Stats.NodesExpanded;
+	NodeLookups += Stats.NodesGenerated;
+	DuplicateHits += Stats.DuplicateHits;
+	CacheLookups += Stats.CacheLookups;
+	CacheHits += Stats.CacheHits;
+}
+
+void FPlannerDebugStats::AddCacheLookup(bool bHit)
+{
+	++CacheLookups;
+	CacheHits += bHit ? 1 : 0;
+}
+
+float FPlannerDebugStats::GetMeanSearchMs() const
+{
+	float Sum = 0.f;
+	for (int32 Idx = 0; Idx < NumSamples; ++Idx)
+	{
+		Sum += SearchMs[Idx];
+	}
+	return (NumSamples > 0) ? Sum / NumSamples : 0.f;
+}
+
+float FPlannerDebugStats::GetMaxSearchMs() const
+{
+	float Max = 0.f;
+	for (int32 Idx = 0; Idx < NumSamples; ++Idx)
+	{
+		Max = FMath::Max(Max, SearchMs[Idx]);
+	}
+	return Max;
+}
+
+float FPlannerDebugStats::GetDuplicateRate() const
+{
+	return (NodeLookups > 0) ? float(DuplicateHits) / float(NodeLookups) : 0.f;
+}
+
+float FPlannerDebugStats::GetCacheHitRate() const
+{
+	return (CacheLookups > 0) ? float(CacheHits) / float(CacheLookups) : 0.f;
 }
 
 //UPlannerComponent
@@ -174,8 +509,17 @@ void UPlannerComponent::StartPlanner(UPlannerAsset& PlannerAsset)
 	{
 		return;
 	}
+	if (AgentIndex == INDEX_NONE)
+	{
+		PlannerSubsystem = UGOAPPlannerSubsystem::Get(this);
+		if (!PlannerSubsystem)
+		{
+			UE_LOG(LogAction, Error, TEXT("%s has no planner subsystem, it isn't in a world"), *GetNameSafe(AIOwner));
+			return;
+		}
+		AgentIndex = PlannerSubsystem->RegisterAgent(*this);
+	}
 
-	
 	UBlackboardComponent* BBComp = AIOwner->GetBlackboardComponent();
 	if (BBComp && IsValid(PlannerAsset.BlackboardData))
 	{
@@ -186,13 +530,17 @@ void UPlannerComponent::StartPlanner(UPlannerAsset& PlannerAsset)
 	{
 		if (KeyConfig.Type == EWSValueType::BBKey)
 		{
-			WorldState.SetProp(KeyConfig.KeyLHS, BBComp->GetKeyID(KeyConfig.BBKeyName));
+			GetMutableWorldState().SetProp(KeyConfig.KeyLHS, BBComp->GetKeyID(KeyConfig.BBKeyName));
 		}
-		else
+		//Reported by UPlannerAsset::ValidateWorldStateValues when the domain compiles
+		else if (FWorldStateLayout::IsValidValue(KeyConfig.KeyLHS, KeyConfig.Value))
 		{
-			WorldState.SetProp(KeyConfig.KeyLHS, KeyConfig.Value);
+			GetMutableWorldState().SetProp(KeyConfig.KeyLHS, KeyConfig.Value);
 		}
 	}
+	InitBlackboardBindings(PlannerAsset);
+	//Decorators and insistence read the published state, they shouldn't see an empty one until the subsystem ticks
+	PlannerSubsystem->GetAgents().Snapshots[AgentIndex]->Publish(GetWorldState());
 	ActionSet.Reserve(PlannerAsset.Actions.Num());
 	//TODO: this is a hot mess
 	for (auto* Action : PlannerAsset.Actions)
@@ -203,6 +551,15 @@ void UPlannerComponent::StartPlanner(UPlannerAsset& PlannerAsset)
 		ActionSet.Emplace(Copy);
 		AStarPlanner.AddAction(Copy);
 	}
+	int32 MaxMacroSteps = 1;
+	for (auto* Action : ActionSet)
+	{
+		if (UGOAPAction_Macro* Macro = Cast<UGOAPAction_Macro>(Action))
+		{
+			Macro->ResolveSteps(ActionSet);
+			MaxMacroSteps = FMath::Max(MaxMacroSteps, Macro->GetSteps().Num());
+		}
+	}
 	for (auto* Goal : PlannerAsset.Goals)
 	{
 		UGOAPGoal* Copy = DuplicateObject<UGOAPGoal>(Goal, this);
@@ -211,189 +568,526 @@ void UPlannerComponent::StartPlanner(UPlannerAsset& PlannerAsset)
 		{
 			Subtask->SetOwner(AIOwner, this);
 		}
-		Copy->OnWSUpdated(WorldState);
+		Copy->OnWSUpdated(GetWorldState());
 		Goals.Emplace(Copy);
+		GoalQueue.Update(*Copy);
+	}
+	PlannerSubsystem->SetAgentGoals(AgentIndex, Goals);
+	RegisterObservers();
+	for (auto& ServiceClass : PlannerAsset.Services)
+	{
+		Services.Add(NewObject<UPlannerService>(this, ServiceClass));
+	}
+	CurrentGoal = nullptr;
+	Asset = &PlannerAsset;
+	//Compiled once per asset, ActionSet and Goals are in asset order so the slices index them directly
+	PlannerAsset.GetCompiledDomain();
+	AStarPlanner.MaxDepth = PlannerAsset.MaxPlanSize;
+	InitNativePlanner(PlannerAsset);
+	//Search can return MaxDepth + 1 steps (each of which can be a macro), goals queue their
+	//subtasks in front and a latent abort keeps the old step at the head
+	int32 MaxSubtasks = 0;
+	for (auto* Goal : Goals)
+	{
+		MaxSubtasks = FMath::Max(MaxSubtasks, Goal->GetSubTasks().Num());
+	}
+	int32 BufferSize = (PlannerAsset.MaxPlanSize + 1) * MaxMacroSteps + MaxSubtasks + 1;
+	PlanInstance.Init(BufferSize);
+	if (UGOAPInsistenceSubsystem* InsistenceSubsystem = UGOAPInsistenceSubsystem::Get(this))
+	{
+		InsistenceSubsystem->RegisterPlanner(*this);
+	}
+	bRunning = true;
+	SetAgentFlag(EPlannerAgentFlags::Running, true);
+}
+
+void UPlannerComponent::StopPlanner()
+{
+	if (AgentIndex == INDEX_NONE)
+	{
+		return;
+	}
+	PlannerSubsystem->GetAgents().ClearExpected(AgentIndex, true, true);
+
+	bRunning = false;
+	SetAgentFlag(EPlannerAgentFlags::Running, false);
+	if (UGOAPInsistenceSubsystem* InsistenceSubsystem = UGOAPInsistenceSubsystem::Get(this))
+	{
+		InsistenceSubsystem->UnregisterPlanner(*this);
+	}
+	if (PlanInstance.HasCurrentAction() && ActionStatus == EActionStatus::Active)
+	{
+		EActionResult Result = PlanInstance.GetCurrent()->AbortAction();
+		if (Result == EActionResult::Running)
+		{
+			ActionStatus = EActionStatus::Aborting;
+		}
+	}
+	CurrentGoal = nullptr;
+
+	PlanInstance.Clear(false);
+	SyncPlanFlags();
+}
+
+void UPlannerComponent::RunAllActions()
+{
+	RequestExecutionUpdate();
+
+}
+
+bool UPlannerComponent::IsRunningPlan() const
+{
+	return bPlanInProgress;
+}
+
+void UPlannerComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_GOAP_ServiceTick);
+		CSV_SCOPED_TIMING_STAT(GOAP, ServiceTick);
+		for (int32 Index = 0; Index != Services.Num(); ++Index)
+		{
+			Services[Index]->TickService(*this, DeltaTime);
+		}
+	}
+
+	//Goal validation, plan updates and replans are done for every agent at once by UGOAPPlannerSubsystem
+}
+
+float UPlannerComponent::GetTagCooldownEndTime(FGameplayTag Tag)
+{
+	return CooldownTagsMap.FindRef(Tag);
+}
+
+void UPlannerComponent::AddTagCooldownDuration(FGameplayTag CooldownTag, float Duration, bool bAddToExistingDuration)
+{
+	//Source: BehaviorTreeComponent.cpp
+	//Want to find a way to ditch this and just use the already existing behavior from the BT
+	if (CooldownTag.IsValid())
+	{
+		float* CurrentEndTime = CooldownTagsMap.Find(CooldownTag);
+
+		// If we are supposed to add to an existing duration, do that, otherwise we set a new value.
+		if (bAddToExistingDuration && (CurrentEndTime != nullptr))
+		{
+			*CurrentEndTime += Duration;
+		}
+		else
+		{
+			CooldownTagsMap.Add(CooldownTag, (GetWorld()->GetTimeSeconds() + Duration));
+		}
+		InvalidateTagDecorators(CooldownTag);
+
+		if (UGOAPCooldownSubsystem* CooldownSubsystem = UGOAPCooldownSubsystem::Get(this))
+		{
+			FCooldownTimerHandle& Handle = CooldownTimers.FindOrAdd(CooldownTag);
+			CooldownSubsystem->Cancel(Handle);
+			Handle = CooldownSubsystem->Schedule(*this, CooldownTag, CooldownTagsMap.FindChecked(CooldownTag));
+		}
+	}
+}
+
+void UPlannerComponent::OnCooldownExpired(const FGameplayTag& Tag)
+{
+	CooldownTimers.Remove(Tag);
+	InvalidateTagDecorators(Tag);
+	if (bRunning)
+	{
+		ScheduleReplan(EReplanCause::CooldownExpired);
+	}
+}
+
+void UPlannerComponent::CancelCooldownTimers()
+{
+	if (UGOAPCooldownSubsystem* CooldownSubsystem = UGOAPCooldownSubsystem::Get(this))
+	{
+		for (auto& Timer : CooldownTimers)
+		{
+			CooldownSubsystem->Cancel(Timer.Value);
+		}
+	}
+	CooldownTimers.Reset();
+}
+
+void UPlannerComponent::RegisterObservers()
+{
+	UnregisterObservers();
+
+	UBlackboardComponent* BBComp = GetBlackboardComponent();
+	for (UGOAPGoal* Goal : Goals)
+	{
+		for (UGOAPDecorator* Decorator : Goal->GetDecorators())
+		{
+			if (!Decorator)
+			{
+				continue;
+			}
+			Decorator->SetOwner(*this);
+			FDecoratorInvalidation Invalidation;
+			if (!Decorator->DescribeInvalidation(Invalidation))
+			{
+				continue;
+			}
+			for (const FName& KeyName : Invalidation.BBKeys)
+			{
+				const FBlackboard::FKey KeyID = BBComp ? BBComp->GetKeyID(KeyName) : FBlackboard::InvalidKey;
+				if (KeyID == FBlackboard::InvalidKey)
+				{
+					continue;
+				}
+				if (!BBKeyDecorators.Contains(KeyID))
+				{
+					BBComp->RegisterObserver(KeyID, this, FOnBlackboardChangeNotification::CreateUObject(this, &UPlannerComponent::OnDecoratorBBKeyChanged));
+				}
+				BBKeyDecorators.Add(KeyID, Decorator);
+			}
+			for (const FGameplayTag& Tag : Invalidation.Tags)
+			{
+				TagDecorators.Add(Tag, Decorator);
+			}
+			if (Invalidation.bPerception)
+			{
+				PerceptionDecorators.Add(Decorator);
+			}
+		}
+	}
+
+	UAIPerceptionComponent* PerceptionComp = AIOwner ? AIOwner->GetPerceptionComponent() : nullptr;
+	if (PerceptionComp && PerceptionDecorators.Num() != 0)
+	{
+		PerceptionComp->OnTargetPerceptionUpdated.AddUniqueDynamic(this, &UPlannerComponent::OnDecoratorPerceptionUpdated);
+	}
+
+	for (int32 BindingIdx = 0; BindingIdx < BindingKeyIDs.Num(); ++BindingIdx)
+	{
+		const FBlackboard::FKey KeyID = BindingKeyIDs[BindingIdx];
+		//Several bindings can read the same key, one observer flags all of them
+		if (KeyID != FBlackboard::InvalidKey && BindingKeyIDs.Find(KeyID) == BindingIdx)
+		{
+			BBComp->RegisterObserver(KeyID, this, FOnBlackboardChangeNotification::CreateUObject(this, &UPlannerComponent::OnBoundBBKeyChanged));
+		}
+	}
+}
+
+void UPlannerComponent::UnregisterObservers()
+{
+	if (UBlackboardComponent* BBComp = GetBlackboardComponent())
+	{
+		BBComp->UnregisterObserversFrom(this);
+	}
+	UAIPerceptionComponent* PerceptionComp = AIOwner ? AIOwner->GetPerceptionComponent() : nullptr;
+	if (PerceptionComp)
+	{
+		PerceptionComp->OnTargetPerceptionUpdated.RemoveDynamic(this, &UPlannerComponent::OnDecoratorPerceptionUpdated);
+	}
+	BBKeyDecorators.Reset();
+	TagDecorators.Reset();
+	PerceptionDecorators.Reset();
+}
+
+void UPlannerComponent::InitBlackboardBindings(const UPlannerAsset& PlannerAsset)
+{
+	BindingKeyIDs.Reset();
+	UBlackboardComponent* BBComp = GetBlackboardComponent();
+	for (const FWSBlackboardBinding& Binding : PlannerAsset.BlackboardBindings)
+	{
+		FBlackboard::FKey KeyID = BBComp ? BBComp->GetKeyID(Binding.BBKeyName) : FBlackboard::InvalidKey;
+		if (KeyID != FBlackboard::InvalidKey && Binding.Mode == EBBBindingMode::CopyValue)
+		{
+			const TSubclassOf<UBlackboardKeyType> KeyType = BBComp->GetKeyType(KeyID);
+			if (KeyType != UBlackboardKeyType_Bool::StaticClass() && KeyType != UBlackboardKeyType_Int::StaticClass()
+				&& KeyType != UBlackboardKeyType_Float::StaticClass() && KeyType != UBlackboardKeyType_Enum::StaticClass())
+			{
+				KeyID = FBlackboard::InvalidKey;
+			}
+		}
+		if (KeyID == FBlackboard::InvalidKey || Binding.WSKey == EWorldKey::SYMBOL_MAX)
+		{
+			UE_LOG(LogAction, Warning, TEXT("%s: blackboard binding %s can't be used with %s's blackboard, skipping it"),
+				*GetNameSafe(&PlannerAsset), *Binding.BBKeyName.ToString(), *GetNameSafe(AIOwner));
+			BindingKeyIDs.Add(FBlackboard::InvalidKey);
+			continue;
+		}
+		BindingKeyIDs.Add(KeyID);
+		GetMutableWorldState().SetProp(Binding.WSKey, EvaluateBinding(*BBComp, Binding, KeyID));
+	}
+	DirtyBindings.Init(false, BindingKeyIDs.Num());
+	bBindingSyncPending = false;
+}
+
+uint8 UPlannerComponent::EvaluateBinding(const UBlackboardComponent& Blackboard, const FWSBlackboardBinding& Binding, FBlackboard::FKey KeyID) const
+{
+	const TSubclassOf<UBlackboardKeyType> KeyType = Blackboard.GetKeyType(KeyID);
+	int32 Value = 0;
+	if (Binding.Mode == EBBBindingMode::IsSet)
+	{
+		//Same test as the behavior tree's blackboard decorator, so every key type has a meaning for "set"
+		const bool bIsSet = KeyType.GetDefaultObject()->WrappedTestBasicOperation(Blackboard, Blackboard.GetKeyRawData(KeyID), EBasicKeyOperation::Set);
+		Value = bIsSet ? Binding.SetValue : Binding.UnsetValue;
+	}
+	else if (KeyType == UBlackboardKeyType_Bool::StaticClass())
+	{
+		Value = Blackboard.GetValue<UBlackboardKeyType_Bool>(KeyID) ? 1 : 0;
 	}
-	for (auto& ServiceClass : PlannerAsset.Services)
+	else if (KeyType == UBlackboardKeyType_Int::StaticClass())
 	{
-		Services.Add(NewObject<UPlannerService>(this, ServiceClass));
+		Value = Blackboard.GetValue<UBlackboardKeyType_Int>(KeyID);
 	}
-	CurrentGoal = nullptr;
-	Asset = &PlannerAsset;
-	AStarPlanner.MaxDepth = PlannerAsset.MaxPlanSize;
-	int BufferSize = PlannerAsset.MaxPlanSize + 1;
-	PlanInstance.Init(BufferSize);
-	bRunning = true;
+	else if (KeyType == UBlackboardKeyType_Float::StaticClass())
+	{
+		Value = FMath::RoundToInt(Blackboard.GetValue<UBlackboardKeyType_Float>(KeyID));
+	}
+	else if (KeyType == UBlackboardKeyType_Enum::StaticClass())
+	{
+		Value = Blackboard.GetValue<UBlackboardKeyType_Enum>(KeyID);
+	}
+	return (uint8)FMath::Clamp<int32>(Value, 0, FWorldStateLayout::ValueMask((uint32)Binding.WSKey));
 }
 
-void UPlannerComponent::StopPlanner()
+void UPlannerComponent::SyncBlackboardBindings()
 {
-	ExpectedEffects.Reset();
-	GoalExpectedEffects.Reset();
-
-	bRunning = false;
-	if (PlanInstance.HasCurrentAction() && ActionStatus == EActionStatus::Active)
+	bBindingSyncPending = false;
+	const UBlackboardComponent* BBComp = GetBlackboardComponent();
+	if (AgentIndex != INDEX_NONE && Asset && BBComp)
 	{
-		EActionResult Result = PlanInstance.GetCurrent()->AbortAction();
-		if (Result == EActionResult::Running)
+		for (TConstSetBitIterator<> It(DirtyBindings); It; ++It)
 		{
-			ActionStatus = EActionStatus::Aborting;
+			const int32 BindingIdx = It.GetIndex();
+			const FWSBlackboardBinding& Binding = Asset->BlackboardBindings[BindingIdx];
+			//Goes through the expected effect checks like any other write
+			SetWSProp(Binding.WSKey, EvaluateBinding(*BBComp, Binding, BindingKeyIDs[BindingIdx]));
 		}
 	}
-	CurrentGoal = nullptr;
-
-	PlanInstance.Clear(false);
+	DirtyBindings.Init(false, DirtyBindings.Num());
 }
 
-void UPlannerComponent::RunAllActions()
+EBlackboardNotificationResult UPlannerComponent::OnBoundBBKeyChanged(const UBlackboardComponent& Blackboard, FBlackboard::FKey ChangedKeyID)
 {
-	RequestExecutionUpdate();
-
+	for (int32 BindingIdx = 0; BindingIdx < BindingKeyIDs.Num(); ++BindingIdx)
+	{
+		if (BindingKeyIDs[BindingIdx] == ChangedKeyID)
+		{
+			DirtyBindings[BindingIdx] = true;
+		}
+	}
+	//Any number of changes this frame are read once, with the values they ended up with
+	if (!bBindingSyncPending && PlannerSubsystem)
+	{
+		bBindingSyncPending = true;
+		PlannerSubsystem->RequestBindingSync(*this);
+	}
+	return EBlackboardNotificationResult::ContinueObserving;
 }
 
-bool UPlannerComponent::IsRunningPlan() const
+EBlackboardNotificationResult UPlannerComponent::OnDecoratorBBKeyChanged(const UBlackboardComponent& Blackboard, FBlackboard::FKey ChangedKeyID)
 {
-	return bPlanInProgress;
+	for (auto It = BBKeyDecorators.CreateKeyIterator(ChangedKeyID); It; ++It)
+	{
+		It.Value()->Invalidate();
+	}
+	return EBlackboardNotificationResult::ContinueObserving;
 }
 
-void UPlannerComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+void UPlannerComponent::OnDecoratorPerceptionUpdated(AActor* Actor, FAIStimulus Stimulus)
 {
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-
-	for (int32 Index = 0; Index != Services.Num(); ++Index)
+	for (UGOAPDecorator* Decorator : PerceptionDecorators)
 	{
-		Services[Index]->TickService(*this, DeltaTime);
+		Decorator->Invalidate();
 	}
+}
 
-	if (bWorldStateUpdated)
+void UPlannerComponent::InvalidateTagDecorators(const FGameplayTag& Tag)
+{
+	for (auto It = TagDecorators.CreateKeyIterator(Tag); It; ++It)
 	{
-		bWorldStateUpdated = false;
-
-		//Should change this to a MC delegate
-		for (auto* Goal : Goals)
-		{
-			Goal->OnWSUpdated(WorldState);
-		}
+		It.Value()->Invalidate();
 	}
-
-	if (!bRunning)
+}
+void UPlannerComponent::SetWSProp(const EWorldKey& Key, const uint8& Value)
+{
+	if (AgentIndex == INDEX_NONE)
 	{
 		return;
 	}
-
-	if (bPlanUpdateNeeded)
+	//Rejected rather than truncated, a 2 on a boolean key would otherwise become a 0
+	if (!ensureMsgf(FWorldStateLayout::IsValidValue(Key, Value), TEXT("%s: value %d doesn't fit world state key %d"), *GetNameSafe(AIOwner), Value, (int32)Key))
+	{
+		return;
+	}
+	FWorldState& WorldState = GetMutableWorldState();
+	if (WorldState.GetProp(Key) != Value)
 	{
-		UpdatePlanExecution();
+		WorldState.SetProp(Key, Value);
+		PlannerSubsystem->GetAgents().WriteSharedKey(AgentIndex, Key);
+		//Checked against the expected effects by the subsystem's next batch,
+		//anything unexpected causes a replan
+		PlannerSubsystem->GetAgents().MarkDirty(AgentIndex, Key);
 	}
+}
 
-	//Do any replans last
-	if (bReplanNeeded || !PlanInstance.IsRunningPlan())
+void UPlannerComponent::PostWSProp(EWorldKey Key, uint8 Value)
+{
+	//The subsystem outlives its agents, writes for a planner that stopped in the meantime are dropped when applied
+	if (UGOAPPlannerSubsystem* Subsystem = PlannerSubsystem)
 	{
-		ProcessReplanRequest();
+		Subsystem->PostWSProp(this, Key, Value);
 	}
 }
 
-float UPlannerComponent::GetTagCooldownEndTime(FGameplayTag Tag)
+void UPlannerComponent::JoinSquad(int32 SquadId)
 {
-	return CooldownTagsMap.FindRef(Tag);
+	if (AgentIndex != INDEX_NONE)
+	{
+		PlannerSubsystem->GetAgents().JoinSquad(AgentIndex, SquadId);
+	}
 }
 
-void UPlannerComponent::AddTagCooldownDuration(FGameplayTag CooldownTag, float Duration, bool bAddToExistingDuration)
+void UPlannerComponent::LeaveSquad()
 {
-	//Source: BehaviorTreeComponent.cpp
-	//Want to find a way to ditch this and just use the already existing behavior from the BT
-	if (CooldownTag.IsValid())
+	if (AgentIndex != INDEX_NONE)
 	{
-		float* CurrentEndTime = CooldownTagsMap.Find(CooldownTag);
+		PlannerSubsystem->GetAgents().LeaveSquad(AgentIndex);
+	}
+}
 
-		// If we are supposed to add to an existing duration, do that, otherwise we set a new value.
-		if (bAddToExistingDuration && (CurrentEndTime != nullptr))
-		{
-			*CurrentEndTime += Duration;
-		}
-		else
-		{
-			CooldownTagsMap.Add(CooldownTag, (GetWorld()->GetTimeSeconds() + Duration));
-		}
+void UPlannerComponent::SetSquadWSProp(EWorldKey Key, uint8 Value)
+{
+	if (AgentIndex == INDEX_NONE)
+	{
+		return;
+	}
+	FPlannerAgentBatch& Agents = PlannerSubsystem->GetAgents();
+	if (Agents.IsSharedKey(AgentIndex, Key))
+	{
+		//We pick it up with everyone else on the next batch, unless we overrode it ourselves
+		Agents.SetSquadProp(Agents.SquadIndices[AgentIndex], Key, Value);
+	}
+	else
+	{
+		SetWSProp(Key, Value);
 	}
 }
-void UPlannerComponent::SetWSProp(const EWorldKey& Key, const uint8& Value)
+
+void UPlannerComponent::OverrideWSProp(EWorldKey Key, uint8 Value)
 {
-	uint8 Prev = WorldState.GetProp(Key);
-	if (Prev != Value)
+	//SetWSProp reports bad values, they shouldn't leave the key cut off from the squad
+	if (AgentIndex != INDEX_NONE && FWorldStateLayout::IsValidValue(Key, Value))
 	{
-		WorldState.SetProp(Key, Value);
-		ScheduleWSUpdate();
+		PlannerSubsystem->GetAgents().OverrideSquadKey(AgentIndex, Key);
+	}
+	SetWSProp(Key, Value);
+}
 
-		bool bShouldIgnore = false;
-		//Check for expected effects from current action, if any
-		if (PlanInstance.IsRunningPlan() && PlanInstance.HasCurrentAction())
-		{
-			
-			//Action Expected effects
-			uint8* Effect = ExpectedEffects.Find(Key);
-			if (Effect && (*Effect == Value))
-			{
-				bShouldIgnore = true;
-			}
-			
-			//Goal Expected effects
-			Effect = GoalExpectedEffects.Find(Key);
-			if (Effect && (*Effect == Value))
-			{
-				bShouldIgnore = true;
-			}
-		}
-		//Unhandled WS change causes replan
-		if (!bShouldIgnore)
-		{
-			ScheduleReplan();
-		}
+void UPlannerComponent::RevertToSquadWSProp(EWorldKey Key)
+{
+	if (AgentIndex != INDEX_NONE)
+	{
+		PlannerSubsystem->GetAgents().RevertSquadKey(AgentIndex, Key);
 	}
 }
 
 void UPlannerComponent::ScheduleWSUpdate()
 {
-	bWorldStateUpdated = true;
+	SetAgentFlag(EPlannerAgentFlags::GoalsDirty, true);
 }
 
 void UPlannerComponent::RequestExecutionUpdate()
 {
-	bPlanUpdateNeeded = true;
+	SetAgentFlag(EPlannerAgentFlags::PlanUpdateNeeded, true);
+}
+
+const FWorldState& UPlannerComponent::GetWorldState() const
+{
+	static const FWorldState EmptyWS;
+	return (AgentIndex != INDEX_NONE) ? PlannerSubsystem->GetAgents().WorldStates[AgentIndex] : EmptyWS;
+}
+
+FWorldStateSnapshot UPlannerComponent::GetWorldStateSnapshot() const
+{
+	check(IsInGameThread());
+	return (AgentIndex != INDEX_NONE) ? PlannerSubsystem->GetAgents().Snapshots[AgentIndex]->Read() : FWorldStateSnapshot();
+}
+
+uint32 UPlannerComponent::GetWorldStateVersion() const
+{
+	check(IsInGameThread());
+	return (AgentIndex != INDEX_NONE) ? PlannerSubsystem->GetAgents().Snapshots[AgentIndex]->GetVersion() : 0;
+}
+
+TSharedPtr<const FWorldStateSnapshotStore, ESPMode::ThreadSafe> UPlannerComponent::GetWorldStateStore() const
+{
+	check(IsInGameThread());
+	if (AgentIndex == INDEX_NONE)
+	{
+		return nullptr;
+	}
+	return PlannerSubsystem->GetAgents().Snapshots[AgentIndex];
+}
+
+FWorldState& UPlannerComponent::GetMutableWorldState()
+{
+	check(AgentIndex != INDEX_NONE);
+	return PlannerSubsystem->GetAgents().WorldStates[AgentIndex];
+}
+
+void UPlannerComponent::SetAgentFlag(uint8 Flag, bool bSet)
+{
+	if (AgentIndex != INDEX_NONE)
+	{
+		PlannerSubsystem->GetAgents().SetFlag(AgentIndex, Flag, bSet);
+	}
+}
+
+void UPlannerComponent::SyncPlanFlags()
+{
+	SetAgentFlag(EPlannerAgentFlags::HasPlan, PlanInstance.IsRunningPlan());
+	SetAgentFlag(EPlannerAgentFlags::HasCurrentAction, PlanInstance.IsRunningPlan() && PlanInstance.HasCurrentAction());
 }
 
 void UPlannerComponent::UpdatePlanExecution()
 {
-	bPlanUpdateNeeded = false;
+	SCOPE_CYCLE_COUNTER(STAT_GOAP_UpdatePlanExecution);
+	CSV_SCOPED_TIMING_STAT(GOAP, UpdatePlanExecution);
+	SetAgentFlag(EPlannerAgentFlags::PlanUpdateNeeded, false);
+
+	//The head is still finishing a latent abort, OnTaskFinished advances past it
+	if (ActionStatus == EActionStatus::Aborting)
+	{
+		return;
+	}
 
 	UGOAPAction* NextAction = PlanInstance.GetCurrent();
 
 	if (!PlanInstance.HasReachedEnd() && NextAction != nullptr)
 	{
-		ExpectedEffects.Reset();
+		FPlannerAgentBatch& Agents = PlannerSubsystem->GetAgents();
+		Agents.ClearExpected(AgentIndex, true, false);
 
-		if (!NextAction->ValidatePlannerPreconditions(WorldState))
+		if (!NextAction->ValidatePlannerPreconditions(GetWorldState()))
 		{
 			CurrentGoal = nullptr;
 			AbortPlan();
-			ScheduleReplan();
+			ScheduleReplan(EReplanCause::PreconditionsFailed);
 			return;
 		}
 
 		{
-			FWorldState PredictedState = FWorldState(WorldState); //need to save computed values in case later effects reference them
+			FWorldState PredictedState = FWorldState(GetWorldState()); //need to save computed values in case later effects reference them
 			for (auto& Effect : NextAction->GetEffects())
 			{
 				PredictedState.ApplyEffect(Effect);
 				if (Effect.bExpected)
 				{
-					ExpectedEffects.Add(Effect.Key, Effect.Value);
+					Agents.AddExpected(AgentIndex, false, Effect.Key, Effect.Value);
 				}
 			}
 		}
 
 		NextAction->StartAction();
 		ActionStatus = EActionStatus::Active;
+		SyncPlanFlags();
 	}
 	else
 	{
@@ -405,13 +1099,13 @@ void UPlannerComponent::UpdatePlanExecution()
 			if (!Effect.bExpected)
 			{
 				//There are no "Resolved" effects for goals
-				WorldState.ApplyEffect(Effect);
+				PlannerSubsystem->GetAgents().ApplyEffect(AgentIndex, Effect);
 			}
 		}
 		CurrentGoal->OnPlanFinished();
 		CurrentGoal = nullptr;
 		AbortPlan();
-		ScheduleReplan();
+		ScheduleReplan(EReplanCause::PlanFinished);
 	}
 }
 
@@ -435,18 +1129,17 @@ void UPlannerComponent::OnTaskFinished(UGOAPAction* Action, EPlannerTaskFinished
 					ResolvedEffect.Key = Effect.Key;
 					ResolvedEffect.Value = PlanInstance.GetResolvedWSValue(Effect.Key);
 					UE_LOG(LogTemp, Warning, TEXT("%d"), ResolvedEffect.Value);
-					WorldState.ApplyEffect(ResolvedEffect);
+					PlannerSubsystem->GetAgents().ApplyEffect(AgentIndex, ResolvedEffect);
 				}
-				WorldState.ApplyEffect(Effect);
+				//Shared keys go to the squad, the rest of the squad sees our result too
+				PlannerSubsystem->GetAgents().ApplyEffect(AgentIndex, Effect);
 			}
 		}
 		//Still have to notify goals about new WS, but don't cause a replan
-		for (auto& Goal : Goals)
-		{
-			Goal->OnWSUpdated(WorldState);
-		}
+		ScheduleWSUpdate();
 		//Update the pointer and flag for the next tick
 		PlanInstance.Advance();
+		SyncPlanFlags();
 		RequestExecutionUpdate();
 	}
 	else if (Result == EPlannerTaskFinishedResult::Aborted)
@@ -454,6 +1147,7 @@ void UPlannerComponent::OnTaskFinished(UGOAPAction* Action, EPlannerTaskFinished
 		//We finished a latent abort, so we don't want to apply effects
 		//However, we might have started a new plan
 		PlanInstance.Advance();
+		SyncPlanFlags();
 		RequestExecutionUpdate();
 	}
 	else
@@ -462,47 +1156,82 @@ void UPlannerComponent::OnTaskFinished(UGOAPAction* Action, EPlannerTaskFinished
 		CurrentGoal->OnPlanFinished();
 		CurrentGoal = nullptr;
 		AbortPlan();
-		ScheduleReplan();
+		ScheduleReplan(EReplanCause::ActionFailed);
 	}
 }
 
-void UPlannerComponent::ScheduleReplan()
+void UPlannerComponent::ScheduleReplan(EReplanCause Cause)
 {
-	bReplanNeeded = true;
+	if (AgentIndex != INDEX_NONE)
+	{
+		FPlannerAgentBatch& Agents = PlannerSubsystem->GetAgents();
+		Agents.SetFlag(AgentIndex, EPlannerAgentFlags::ReplanNeeded, true);
+		Agents.ReplanCauses[AgentIndex] = Cause;
+	}
 }
 
-void UPlannerComponent::ProcessReplanRequest()
+void UPlannerComponent::OnGoalPriorityChanged(UGOAPGoal& Goal)
 {
-	bReplanNeeded = false;
-	auto InsistencePred = [](const UGOAPGoal& lhs, const UGOAPGoal& rhs) { 
-		return lhs.GetInsistence() > rhs.GetInsistence(); 
-	};
-	TArray<UGOAPGoal*> ActiveGoals;
-	ActiveGoals.Heapify(InsistencePred);
-	for (auto* Goal : Goals)
-	{
+	GoalQueue.Update(Goal);
+}
 
-		if (Goal->IsValid() && Goal->ValidateContextPreconditions(WorldState) && (Goal->GetInsistence() > 0.f))
-		{
-			ActiveGoals.HeapPush(Goal, InsistencePred);
-		}
-	}
+void UPlannerComponent::InvalidateActionContext(UGOAPAction* Action)
+{
+	AStarPlanner.InvalidateContext(Action);
+}
 
-	if (ActiveGoals.Num() == 0)
+void UPlannerComponent::ProcessReplanRequest(FSquadPlanContext* Squad)
+{
+	SCOPE_CYCLE_COUNTER(STAT_GOAP_ProcessReplan);
+	CSV_SCOPED_TIMING_STAT(GOAP, ProcessReplanRequest);
+	INC_DWORD_STAT(STAT_GOAP_Replans);
+	CSV_CUSTOM_STAT(GOAP, Replans, 1, ECsvCustomStatOp::Accumulate);
+
+	//No request means we got here because nothing is running
+	FPlannerAgentBatch& Agents = PlannerSubsystem->GetAgents();
+	const EReplanCause Cause = Agents.HasFlag(AgentIndex, EPlannerAgentFlags::ReplanNeeded) ? Agents.ReplanCauses[AgentIndex] : EReplanCause::NoPlan;
+	DebugStats.ReplanCount += 1;
+	DebugStats.ReplanCauses[(int32)Cause] += 1;
+	DebugStats.LastReplanTime = GetWorld()->GetTimeSeconds();
+
+	Agents.SetFlag(AgentIndex, EPlannerAgentFlags::ReplanNeeded, false);
+	const FWorldState& WorldState = GetWorldState();
+	const FWorldStateSnapshot Snapshot = GetWorldStateSnapshot();
+
+	//Our current goal doesn't count against its own squad limit while we choose again
+	if (Squad && CurrentGoal)
 	{
-		UE_LOG(LogAction, Warning, TEXT("No active goal"));
+		Squad->Assign(Asset, GetCurrentGoalIndex(), -1);
 	}
 
-	while(ActiveGoals.Num() != 0)
+	//GoalQueue only holds valid goals with some insistence, highest first
+	//Decorators are the expensive part so they're only run until a goal can be planned for
+	bool bAnyActiveGoal = false;
+	for (int32 GoalIdx = 0; GoalIdx < GoalQueue.Sorted.Num(); ++GoalIdx)
 	{
-		
-		UGOAPGoal* Top;
-		ActiveGoals.HeapPop(Top, InsistencePred);
+		UGOAPGoal* Top = GoalQueue.Sorted[GoalIdx];
+		const int32 AssetGoalIdx = Goals.IndexOfByKey(Top);
+		if (Squad && !Squad->HasRoom(Asset, AssetGoalIdx, Top->GetMaxSquadAssignees()))
+		{
+			continue;
+		}
+		{
+			SCOPE_CYCLE_COUNTER(STAT_GOAP_GoalValidation);
+			if (!Top->ValidateContextPreconditions(Snapshot))
+			{
+				continue;
+			}
+		}
+		bAnyActiveGoal = true;
 		//Prefer not to interrupt the current plan if possible
 		//May want to add a list of changes that would force a replan even if the current goal
 		//is still the same
 		if (Top == CurrentGoal)
 		{
+			if (Squad)
+			{
+				Squad->Assign(Asset, AssetGoalIdx, 1);
+			}
 			return;
 		}
 		//Search here
@@ -520,7 +1249,60 @@ void UPlannerComponent::ProcessReplanRequest()
 			}
 		}
 
-		bool bPlanFound = AStarPlanner.Search(Top->GetGoalCondition(), SearchStartWS, NewPlan);
+		bool bPlanFound = false;
+		const bool bNativeSearch = NativePlanner.IsValid() && NativePlanner->CanPlan(Top->GetGoalCondition());
+		const FCompiledPlannerDomain& Domain = Asset->GetCompiledDomain();
+		//Only FAStarPlanner searches can tell whether another member's plan is the one they'd find
+		const FSquadPlanContext::FSolvedPlan* SharedPlan = nullptr;
+		const bool bSharePlans = Squad && !bNativeSearch;
+		if (bSharePlans)
+		{
+			AStarPlanner.PrepareSearch(SearchStartWS, &Domain, AssetGoalIdx);
+			SharedPlan = Squad->FindPlan(Asset, AssetGoalIdx, SearchStartWS, AStarPlanner);
+			DebugStats.AddCacheLookup(SharedPlan != nullptr);
+		}
+		if (SharedPlan)
+		{
+			INC_DWORD_STAT(STAT_GOAP_SquadSharedPlans);
+			CSV_CUSTOM_STAT(GOAP, SquadSharedPlans, 1, ECsvCustomStatOp::Accumulate);
+			const TArray<TWeakObjectPtr<UGOAPAction>>& PlannerActions = AStarPlanner.GetActions();
+			for (int32 StepIdx = 0; StepIdx < SharedPlan->ActionIndices.Num(); ++StepIdx)
+			{
+				FPlanStepInfo& Step = NewPlan[NewPlan.AddDefaulted()];
+				Step.SetAction(PlannerActions[SharedPlan->ActionIndices[StepIdx]].Get());
+				Step.ResolvedDelta = SharedPlan->ResolvedDeltas[StepIdx];
+			}
+			bPlanFound = true;
+		}
+		else
+		{
+			if (Squad)
+			{
+				INC_DWORD_STAT(STAT_GOAP_SquadSearches);
+				CSV_CUSTOM_STAT(GOAP, SquadSearches, 1, ECsvCustomStatOp::Accumulate);
+			}
+			const double SearchStart = FPlatformTime::Seconds();
+			const FPlannerSearchStats* SearchStats = nullptr;
+			if (bNativeSearch)
+			{
+				bPlanFound = NativePlanner->Search(Top->GetGoalCondition(), SearchStartWS, NewPlan);
+				SearchStats = &NativePlanner->LastSearchStats;
+			}
+			else
+			{
+				bPlanFound = AStarPlanner.Search(Top->GetGoalCondition(), SearchStartWS, NewPlan, &Domain, AssetGoalIdx);
+				SearchStats = &AStarPlanner.LastSearchStats;
+			}
+			DebugStats.AddSearch((FPlatformTime::Seconds() - SearchStart) * 1000.0, *SearchStats);
+			if (PlannerSubsystem)
+			{
+				PlannerSubsystem->AddSearchStats(*SearchStats);
+			}
+			if (bSharePlans && bPlanFound)
+			{
+				Squad->AddPlan(Asset, AssetGoalIdx, SearchStartWS, AStarPlanner, NewPlan);
+			}
+		}
 		//could not satisfy goal so go to next highest
 
 		if (!bPlanFound)
@@ -529,14 +1311,26 @@ void UPlannerComponent::ProcessReplanRequest()
 		}
 		
 		CurrentGoal = Top;
-		StartNewPlan(Top->GetSubTasks(), NewPlan); 
+		if (Squad)
+		{
+			Squad->Assign(Asset, AssetGoalIdx, 1);
+		}
+		StartNewPlan(Top->GetSubTasks(), NewPlan, SearchStartWS);
 		return;
 	}
 	
-	if (ActiveGoals.Num() != 0)
+	if (!bAnyActiveGoal)
+	{
+		UE_LOG(LogAction, Warning, TEXT("No active goal"));
+	}
+	else
 	{
 		UE_LOG(LogAction, Warning, TEXT("Could not find plans for any active goals"));
 	}
+	if (Squad && CurrentGoal)
+	{
+		Squad->Assign(Asset, GetCurrentGoalIndex(), 1);
+	}
 	//I dont quite remember but I think this is supposed to be if 
 	//no valid goal was found
 	if (PlanInstance.IsRunningPlan() && PlanInstance.HasCurrentAction())
@@ -545,18 +1339,117 @@ void UPlannerComponent::ProcessReplanRequest()
 	}
 }
 
+//FSquadPlanContext
+bool FSquadPlanContext::FSolvedPlan::Matches(const UPlannerAsset* InAsset, int32 InGoalIdx, const FWorldState& StartWS, const FAStarPlanner& Planner) const
+{
+	if (Asset != InAsset || GoalIdx != InGoalIdx || Planner.GetSearchKeys() != SearchKeys)
+	{
+		return false;
+	}
+	uint32 Keys = SearchKeys;
+	while (Keys != 0)
+	{
+		const uint32 KeyIdx = FPlatformMath::CountTrailingZeros(Keys);
+		Keys &= Keys - 1;
+		if (StartWS.GetProp((EWorldKey)KeyIdx) != SearchStartWS.GetProp((EWorldKey)KeyIdx))
+		{
+			return false;
+		}
+	}
+	//Context and cost providers read things the world state doesn't have, so those are compared as well
+	if (!(Planner.GetSearchActions() == SearchActions))
+	{
+		return false;
+	}
+	for (TConstSetBitIterator<> It(SearchActions); It; ++It)
+	{
+		if (Planner.GetCachedCost(It.GetIndex()) != Costs[It.GetIndex()])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+const FSquadPlanContext::FSolvedPlan* FSquadPlanContext::FindPlan(const UPlannerAsset* Asset, int32 GoalIdx, const FWorldState& StartWS, const FAStarPlanner& Planner) const
+{
+	return Plans.FindByPredicate([&](const FSolvedPlan& Solved) { return Solved.Matches(Asset, GoalIdx, StartWS, Planner); });
+}
+
+void FSquadPlanContext::AddPlan(const UPlannerAsset* Asset, int32 GoalIdx, const FWorldState& StartWS, const FAStarPlanner& Planner, const TArray<FPlanStepInfo>& Plan)
+{
+	FSolvedPlan& Solved = Plans[Plans.AddDefaulted()];
+	Solved.Asset = Asset;
+	Solved.GoalIdx = GoalIdx;
+	Solved.SearchStartWS = StartWS;
+	Solved.SearchKeys = Planner.GetSearchKeys();
+	Solved.SearchActions = Planner.GetSearchActions();
+	Solved.Costs.SetNumZeroed(Solved.SearchActions.Num());
+	for (TConstSetBitIterator<> It(Solved.SearchActions); It; ++It)
+	{
+		Solved.Costs[It.GetIndex()] = Planner.GetCachedCost(It.GetIndex());
+	}
+	for (const FPlanStepInfo& Step : Plan)
+	{
+		Solved.ActionIndices.Add(Planner.GetActions().IndexOfByKey(Step.Action));
+		Solved.ResolvedDeltas.Add(Step.ResolvedDelta);
+	}
+}
+
+void UPlannerComponent::InitNativePlanner(const UPlannerAsset& PlannerAsset)
+{
+	NativePlanner.Reset();
+	if (PlannerAsset.GetSearchType() != EPlannerSearchType::NativeShooter)
+	{
+		return;
+	}
+	TArray<FText> Errors;
+	if (!PlannerAsset.ValidateSearchType(Errors))
+	{
+		for (const FText& Error : Errors)
+		{
+			UE_LOG(LogAction, Error, TEXT("%s: %s"), *PlannerAsset.GetName(), *Error.ToString());
+		}
+		UE_LOG(LogAction, Error, TEXT("%s doesn't match FShooterPlannerSchema, %s plans with FAStarPlanner"), *PlannerAsset.GetName(), *GetNameSafe(AIOwner));
+		return;
+	}
+
+	NativePlanner = MakeShared<TStaticPlanner<FShooterPlannerSchema>>();
+	NativePlanner->MaxDepth = AStarPlanner.MaxDepth;
+	for (UGOAPAction* Action : ActionSet)
+	{
+		const int32 SchemaIdx = Action ? TStaticPlanner<FShooterPlannerSchema>::FindAction(Action->GetActionName()) : INDEX_NONE;
+		if (SchemaIdx != INDEX_NONE)
+		{
+			NativePlanner->BindAction(SchemaIdx, Action);
+		}
+	}
+}
+
 void UPlannerComponent::Cleanup()
 {
 
 	StopPlanner();
+	UnregisterObservers();
+	BindingKeyIDs.Reset();
+	DirtyBindings.Empty();
+	bBindingSyncPending = false;
+	CancelCooldownTimers();
 	Services.Reset();
 	Goals.Reset();
+	GoalQueue.Reset();
 	ActionSet.Reset();
+	NativePlanner.Reset();
 
+	if (AgentIndex != INDEX_NONE)
+	{
+		PlannerSubsystem->UnregisterAgent(AgentIndex);
+		AgentIndex = INDEX_NONE;
+	}
 }
 void UPlannerComponent::SetWSPropInternal(const EWorldKey& Key, const uint8& Value)
 {
-	WorldState.SetProp(Key, Value);
+	GetMutableWorldState().SetProp(Key, Value);
 }
 
 uint8 UPlannerComponent::GetResolvedValue(const EWorldKey& Key)
@@ -564,12 +1457,27 @@ uint8 UPlannerComponent::GetResolvedValue(const EWorldKey& Key)
 	return PlanInstance.GetResolvedWSValue(Key);
 }
 
+FString UPlannerComponent::DescribeWSValue(EWorldKey Key, uint8 Value) const
+{
+	if (Asset && BlackboardComp)
+	{
+		for (const FWSKeyConfig& KeyConfig : Asset->WSKeyDefaults)
+		{
+			if (KeyConfig.KeyLHS == Key && KeyConfig.Type == EWSValueType::BBKey)
+			{
+				return FString::Printf(TEXT("%s (%d)"), *BlackboardComp->GetKeyName(Value).ToString(), Value);
+			}
+		}
+	}
+	return FString::FromInt(Value);
+}
+
 FName UPlannerComponent::GetKeyName(uint8 KeyID)
 {
 	return BlackboardComp->GetKeyName(KeyID);
 }
 
-void UPlannerComponent::StartNewPlan(TArray<UGOAPAction*> Subtasks, TArray<FPlanStepInfo>& Plan)
+void UPlannerComponent::StartNewPlan(TArray<UGOAPAction*> Subtasks, TArray<FPlanStepInfo>& Plan, const FWorldState& PlanStartWS)
 {
 	if (PlanInstance.IsRunningPlan())
 	{
@@ -581,7 +1489,7 @@ void UPlannerComponent::StartNewPlan(TArray<UGOAPAction*> Subtasks, TArray<FPlan
 	{
 		if (Effect.bExpected)
 		{
-			GoalExpectedEffects.Add(Effect.Key, Effect.Value);
+			PlannerSubsystem->GetAgents().AddExpected(AgentIndex, true, Effect.Key, Effect.Value);
 		}
 	}
 	for (auto* Action : Subtasks)
@@ -590,7 +1498,28 @@ void UPlannerComponent::StartNewPlan(TArray<UGOAPAction*> Subtasks, TArray<FPlan
 		SubtaskStep.SetAction(Action);
 		PlanInstance.AddStep(SubtaskStep);
 	}
-	PlanInstance.StartNewPlan(Plan);
+	if (Plan.ContainsByPredicate([](const FPlanStepInfo& Step) { return Step.Action && Step.Action->IsA<UGOAPAction_Macro>(); }))
+	{
+		//Macro steps don't read resolved values (see UGOAPAction_Macro::Combine) so they start with an empty delta
+		TArray<FPlanStepInfo> Expanded;
+		for (FPlanStepInfo& Step : Plan)
+		{
+			UGOAPAction_Macro* Macro = Cast<UGOAPAction_Macro>(Step.Action);
+			if (!Macro)
+			{
+				Expanded.Add(Step);
+				continue;
+			}
+			for (UGOAPAction* MacroStep : Macro->GetSteps())
+			{
+				FPlanStepInfo& ExpandedStep = Expanded[Expanded.AddDefaulted()];
+				ExpandedStep.SetAction(MacroStep);
+			}
+		}
+		Plan = MoveTemp(Expanded);
+	}
+	PlanInstance.StartNewPlan(Plan, PlanStartWS);
+	SyncPlanFlags();
 	//pretty sure we want to do this on the same frame
 	UpdatePlanExecution();
 }
@@ -598,8 +1527,7 @@ void UPlannerComponent::StartNewPlan(TArray<UGOAPAction*> Subtasks, TArray<FPlan
 void UPlannerComponent::AbortPlan()
 {
 	//Reset expected effects from both action and goal
-	ExpectedEffects.Reset();
-	GoalExpectedEffects.Reset();
+	PlannerSubsystem->GetAgents().ClearExpected(AgentIndex, true, true);
 
 	bool bLeaveCurrent = false;
 	if (PlanInstance.HasCurrentAction() && ActionStatus == EActionStatus::Active)
@@ -618,6 +1546,7 @@ void UPlannerComponent::AbortPlan()
 	}
 	
 	PlanInstance.Clear(bLeaveCurrent);
+	SyncPlanFlags();
 }
 
 FString UPlannerComponent::GetDebugInfoString() const
@@ -627,13 +1556,14 @@ FString UPlannerComponent::GetDebugInfoString() const
 
 	DebugInfo += FString(TEXT("World State:\n"));
 	UEnum* Enum = FindObject<UEnum>(ANY_PACKAGE, TEXT("EWorldKey"), true);
+	const FWorldState& WorldState = GetWorldState();
 	if (Enum != nullptr)
 	{
 		for (uint32 idx = 0; idx < WorldState.Num(); ++idx)
 		{
 
 			FString KeyName = Enum->GetNameStringByValue(idx);
-			DebugInfo += FString::Printf(TEXT("    %s: %d\n"), *KeyName, WorldState.GetProp((EWorldKey)idx));
+			DebugInfo += FString::Printf(TEXT("    %s: %s\n"), *KeyName, *DescribeWSValue((EWorldKey)idx, WorldState.GetProp((EWorldKey)idx)));
 		}
 	}
 	for (auto* Goal : Goals)
@@ -652,17 +1582,18 @@ FString UPlannerComponent::GetDebugInfoString() const
 	}
 
 	DebugInfo += FString::Printf(TEXT("PLAN\n"));
-	for (auto& PlanStep : PlanInstance.Buffer)
+	for (int32 Offset = 0; Offset < PlanInstance.Num(); ++Offset)
 	{
-		UGOAPAction* Action = PlanStep.Action;
+		UGOAPAction* Action = PlanInstance.GetStep(Offset).Action;
 		FString ActionName = Action ? Action->GetActionName() : FString(TEXT("None"));
 		DebugInfo += FString::Printf(TEXT("Action: %s\n"), *ActionName);
 	}
 	return DebugInfo;
 }
 
-void FPlanInstance::StartNewPlan(TArray<FPlanStepInfo>& Plan)
+void FPlanInstance::StartNewPlan(TArray<FPlanStepInfo>& Plan, const FWorldState& PlanStartWS)
 {
+	StartWS = PlanStartWS;
 	for (FPlanStepInfo& PlanStep : Plan)
 	{
 		AddStep(PlanStep);
@@ -672,59 +1603,80 @@ void FPlanInstance::StartNewPlan(TArray<FPlanStepInfo>& Plan)
 
 void FPlanInstance::AddStep(const FPlanStepInfo& PlanStep)
 {
-	Buffer.Add(PlanStep);
+	//StartPlanner sizes the ring for the longest plan the asset can produce: the subtasks, MaxPlanSize + 1 fully
+	//expanded macros and a kept latent-abort step. Squad plans are only shared between agents on the same asset.
+	//So a full ring is a bug, growing it would hide that and allocate mid plan
+	if (Count >= Buffer.Num())
+	{
+		UE_LOG(LogAction, Fatal, TEXT("Plan buffer overflow (%d steps), the sizing in UPlannerComponent::StartPlanner is missing a case"), Buffer.Num());
+		return;
+	}
+	Buffer[(HeadIdx + Count) % Buffer.Num()] = PlanStep;
+	++Count;
 }
 
 bool FPlanInstance::HasCurrentAction() const
 {
-	return HeadIdx < Buffer.Num();
+	return Count > 0;
 }
 
 UGOAPAction* FPlanInstance::GetCurrent()
 {
-	return (HeadIdx < Buffer.Num()) ? Buffer[HeadIdx].Action : nullptr;
+	return (Count > 0) ? Buffer[HeadIdx].Action : nullptr;
 }
 
 uint8 FPlanInstance::GetResolvedWSValue(EWorldKey Key)
 {
-	return (HeadIdx < Buffer.Num()) ? Buffer[HeadIdx].ResolvedWS.GetProp(Key) : 0;
+	if (Count == 0)
+	{
+		return 0;
+	}
+	uint8 Value;
+	return Buffer[HeadIdx].ResolvedDelta.Find(Key, Value) ? Value : StartWS.GetProp(Key);
 }
+
 bool FPlanInstance::Advance()
 {
-	//Buffer[HeadIdx] = nullptr; //clear previous action
-	
-	HeadIdx += 1;
+	if (Count > 0)
+	{
+		//clear previous action so the slot doesn't keep it alive
+		Buffer[HeadIdx] = FPlanStepInfo();
+		HeadIdx = (HeadIdx + 1) % Buffer.Num();
+		--Count;
+	}
 
 	//return whether we've reached the end of the buffer
-	if (HeadIdx >= Buffer.Num())
+	if (Count == 0)
 	{
 		bInProgress = false;
 	}
-	return HeadIdx >= Buffer.Num();
+	return Count == 0;
 }
 
 bool FPlanInstance::HasReachedEnd() const
 {
-	return HeadIdx >= Buffer.Num();
+	return Count == 0;
 }
 
 void FPlanInstance::Init(int32 BufferSize)
 {
-	//nothing
+	Buffer.Reset();
+	Buffer.SetNum(FMath::Max(BufferSize, 1));
+	HeadIdx = 0;
+	Count = 0;
+	bInProgress = false;
 }
 
 void FPlanInstance::Clear(bool bLeaveCurrent = false)
 {
-	if (bLeaveCurrent)
+	const int32 Kept = (bLeaveCurrent && Count > 0) ? 1 : 0;
+	for (int32 Offset = Kept; Offset < Count; ++Offset)
 	{
-		FPlanStepInfo Current = Buffer[HeadIdx];
-		Buffer.Reset();
-		HeadIdx = 0;
-		Buffer[HeadIdx] = Current;
+		Buffer[(HeadIdx + Offset) % Buffer.Num()] = FPlanStepInfo();
 	}
-	else
+	Count = Kept;
+	if (Kept == 0)
 	{
-		Buffer.Reset();
 		HeadIdx = 0;
 	}
 	bInProgress = false;
@@ -0,0 +1,484 @@
+#include "../Public/PlannerDomain.h"
+#include "../Public/GOAPAction.h"
+#include "../Public/GOAPGoal.h"
+#include "HAL/ThreadSafeCounter.h"
+
+namespace
+{
+	static_assert((uint32)EWorldKey::SYMBOL_MAX <= 32, "Domain key masks need a bit per EWorldKey");
+
+	uint32 KeyBit(EWorldKey Key)
+	{
+		return (Key < EWorldKey::SYMBOL_MAX) ? (1u << (uint32)Key) : 0;
+	}
+
+	//Only constant Sets can be ruled out, anything that reads another key or counts could land anywhere
+	bool CanProduce(const FAISymEffect& Effect, const FWorldProperty& Condition)
+	{
+		if (Effect.Key != Condition.Key)
+		{
+			return false;
+		}
+		if (Effect.Op != ESymbolOp::Set || !Effect.IsRHSAbsolute() || !Condition.IsRHSAbsolute())
+		{
+			return true;
+		}
+		return Condition.Evaluate(Effect.Value, Condition.Value);
+	}
+
+	bool CanSet(const FAISymEffect& Effect, EWorldKey Key, uint8 Value)
+	{
+		return Effect.Key == Key && (Effect.Op != ESymbolOp::Set || !Effect.IsRHSAbsolute() || Effect.Value == Value);
+	}
+
+	//True if Key can't hold Value right after Action
+	bool RulesOut(const UGOAPAction& Action, EWorldKey Key, uint8 Value)
+	{
+		bool bWritesKey = false;
+		for (const FAISymEffect& Effect : Action.GetEffects())
+		{
+			if (Effect.Key == Key)
+			{
+				if (CanSet(Effect, Key, Value))
+				{
+					return false;
+				}
+				bWritesKey = true;
+			}
+		}
+		if (bWritesKey)
+		{
+			return true;
+		}
+		//Untouched keys keep whatever the preconditions required of them
+		for (const FWorldProperty& Precondition : Action.GetPreconditions())
+		{
+			if (Precondition.Key == Key && Precondition.IsRHSAbsolute() && !Precondition.Evaluate(Value, Precondition.Value))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool IsExactCondition(const FWorldProperty& Condition)
+	{
+		return Condition.Comparator == ESymbolTest::Eq && Condition.IsRHSAbsolute() && Condition.Key < EWorldKey::SYMBOL_MAX;
+	}
+}
+
+void FCompiledPlannerDomain::Compile(const TArray<UGOAPAction*>& Actions, const TArray<UGOAPGoal*>& Goals)
+{
+	//A missing goal compiles like one without conditions, unreachable with an empty slice
+	TArray<TArray<FWorldProperty>> GoalConditions;
+	GoalConditions.Reserve(Goals.Num());
+	for (const UGOAPGoal* Goal : Goals)
+	{
+		GoalConditions.Add(Goal ? Goal->GetGoalCondition() : TArray<FWorldProperty>());
+	}
+	Compile(Actions, GoalConditions);
+}
+
+void FCompiledPlannerDomain::Compile(const TArray<UGOAPAction*>& Actions, const TArray<TArray<FWorldProperty>>& GoalConditions)
+{
+	Reset();
+
+	//Keys each action needs satisfied before it and the keys it writes
+	TArray<uint32> ReadKeys;
+	TArray<uint32> WriteKeys;
+	ReadKeys.AddZeroed(Actions.Num());
+	WriteKeys.AddZeroed(Actions.Num());
+	for (int32 ActionIdx = 0; ActionIdx < Actions.Num(); ++ActionIdx)
+	{
+		const UGOAPAction* Action = Actions[ActionIdx];
+		if (!Action)
+		{
+			continue;
+		}
+		for (const FWorldProperty& Precondition : Action->GetPreconditions())
+		{
+			ReadKeys[ActionIdx] |= KeyBit(Precondition.Key) | KeyBit(Precondition.KeyRHS);
+		}
+		for (const FAISymEffect& Effect : Action->GetEffects())
+		{
+			WriteKeys[ActionIdx] |= KeyBit(Effect.Key);
+			//Variable effects make the search assert a value for KeyRHS
+			ReadKeys[ActionIdx] |= KeyBit(Effect.KeyRHS);
+		}
+		ChangeableKeys |= WriteKeys[ActionIdx];
+	}
+
+	DeadActions.Init(true, Actions.Num());
+	GoalSlices.SetNum(GoalConditions.Num());
+	for (int32 GoalIdx = 0; GoalIdx < GoalConditions.Num(); ++GoalIdx)
+	{
+		FGoalDomainSlice& Slice = GoalSlices[GoalIdx];
+		Slice.RelevantActions.Init(false, Actions.Num());
+		for (const FWorldProperty& Condition : GoalConditions[GoalIdx])
+		{
+			Slice.RelevantKeys |= KeyBit(Condition.Key) | KeyBit(Condition.KeyRHS);
+		}
+
+		//Backward closure, at most one pass per action
+		bool bChanged = true;
+		while (bChanged)
+		{
+			bChanged = false;
+			for (int32 ActionIdx = 0; ActionIdx < Actions.Num(); ++ActionIdx)
+			{
+				if (Slice.RelevantActions[ActionIdx] || (WriteKeys[ActionIdx] & Slice.RelevantKeys) == 0)
+				{
+					continue;
+				}
+				Slice.RelevantActions[ActionIdx] = true;
+				++Slice.NumRelevantActions;
+				Slice.RelevantKeys |= ReadKeys[ActionIdx];
+				Slice.ChangeableKeys |= WriteKeys[ActionIdx];
+				DeadActions[ActionIdx] = false;
+				bChanged = true;
+			}
+		}
+
+		Slice.bReachable = false;
+		for (const FWorldProperty& Condition : GoalConditions[GoalIdx])
+		{
+			for (TConstSetBitIterator<> It(Slice.RelevantActions); It && !Slice.bReachable; ++It)
+			{
+				for (const FAISymEffect& Effect : Actions[It.GetIndex()]->GetEffects())
+				{
+					if (CanProduce(Effect, Condition))
+					{
+						Slice.bReachable = true;
+						break;
+					}
+				}
+			}
+		}
+	}
+	for (int32 ActionIdx = 0; ActionIdx < Actions.Num(); ++ActionIdx)
+	{
+		//Null entries aren't worth a warning
+		if (!Actions[ActionIdx])
+		{
+			DeadActions[ActionIdx] = false;
+		}
+	}
+
+	CompileFacts(Actions, GoalConditions);
+	CompileMutexes(Actions);
+	NumActions = Actions.Num();
+	static FThreadSafeCounter NextSerial;
+	Serial = (uint32)NextSerial.Increment();
+	bCompiled = true;
+}
+
+void FCompiledPlannerDomain::Reset()
+{
+	GoalSlices.Reset();
+	DeadActions.Empty();
+	ChangeableKeys = 0;
+	NumActions = 0;
+	Facts.Reset();
+	FactIds.Reset();
+	ActionPreFacts.Reset();
+	FactAchievers.Reset();
+	ActionEffectFacts.Reset();
+	Mutexes.Reset();
+	bCompiled = false;
+	SourcePath.Reset();
+}
+
+int32 FCompiledPlannerDomain::AddFact(EWorldKey Key, uint8 Value)
+{
+	const int32 Existing = FindFact(Key, Value);
+	if (Existing != INDEX_NONE || Facts.Num() >= MaxFacts)
+	{
+		return Existing;
+	}
+	FDomainFact& Fact = Facts[Facts.AddDefaulted()];
+	Fact.Key = Key;
+	Fact.Value = Value;
+	FactIds.Add(((uint16)Key << 8) | Value, Facts.Num() - 1);
+	return Facts.Num() - 1;
+}
+
+void FCompiledPlannerDomain::CompileFacts(const TArray<UGOAPAction*>& Actions, const TArray<TArray<FWorldProperty>>& GoalConditions)
+{
+	for (const TArray<FWorldProperty>& GoalCondition : GoalConditions)
+	{
+		for (const FWorldProperty& Condition : GoalCondition)
+		{
+			if (IsExactCondition(Condition))
+			{
+				AddFact(Condition.Key, Condition.Value);
+			}
+		}
+	}
+	ActionPreFacts.AddZeroed(Actions.Num());
+	for (int32 ActionIdx = 0; ActionIdx < Actions.Num(); ++ActionIdx)
+	{
+		const UGOAPAction* Action = Actions[ActionIdx];
+		if (!Action)
+		{
+			continue;
+		}
+		for (const FWorldProperty& Precondition : Action->GetPreconditions())
+		{
+			const int32 FactIdx = IsExactCondition(Precondition) ? AddFact(Precondition.Key, Precondition.Value) : INDEX_NONE;
+			if (FactIdx != INDEX_NONE)
+			{
+				ActionPreFacts[ActionIdx] |= 1ull << FactIdx;
+			}
+		}
+		for (const FAISymEffect& Effect : Action->GetEffects())
+		{
+			if (Effect.Op == ESymbolOp::Set && Effect.IsRHSAbsolute() && Effect.Key < EWorldKey::SYMBOL_MAX)
+			{
+				AddFact(Effect.Key, Effect.Value);
+			}
+		}
+	}
+	if (Facts.Num() >= MaxFacts)
+	{
+		UE_LOG(LogAction, Log, TEXT("Planner domain has more than %d facts, landmarks and mutexes only cover the first %d"), MaxFacts, MaxFacts);
+	}
+
+	FactAchievers.SetNum(Facts.Num());
+	ActionEffectFacts.AddZeroed(Actions.Num());
+	for (int32 FactIdx = 0; FactIdx < Facts.Num(); ++FactIdx)
+	{
+		for (int32 ActionIdx = 0; ActionIdx < Actions.Num(); ++ActionIdx)
+		{
+			if (!Actions[ActionIdx])
+			{
+				continue;
+			}
+			for (const FAISymEffect& Effect : Actions[ActionIdx]->GetEffects())
+			{
+				if (CanSet(Effect, Facts[FactIdx].Key, Facts[FactIdx].Value))
+				{
+					FactAchievers[FactIdx].Add(ActionIdx);
+					ActionEffectFacts[ActionIdx] |= 1ull << FactIdx;
+					break;
+				}
+			}
+		}
+	}
+}
+
+void FCompiledPlannerDomain::CompileMutexes(const TArray<UGOAPAction*>& Actions)
+{
+	for (int32 FactA = 0; FactA < Facts.Num(); ++FactA)
+	{
+		for (int32 FactB = FactA + 1; FactB < Facts.Num(); ++FactB)
+		{
+			const FDomainFact& A = Facts[FactA];
+			const FDomainFact& B = Facts[FactB];
+			if (A.Key == B.Key)
+			{
+				//Two values of one key are exclusive by construction
+				continue;
+			}
+			bool bMutex = true;
+			for (int32 ActionIdx : FactAchievers[FactA])
+			{
+				if (!RulesOut(*Actions[ActionIdx], B.Key, B.Value))
+				{
+					bMutex = false;
+					break;
+				}
+			}
+			for (int32 ActionIdx : FactAchievers[FactB])
+			{
+				if (!bMutex || !RulesOut(*Actions[ActionIdx], A.Key, A.Value))
+				{
+					bMutex = false;
+					break;
+				}
+			}
+			if (bMutex)
+			{
+				FFactMutex& Mutex = Mutexes[Mutexes.AddDefaulted()];
+				Mutex.FactA = FactA;
+				Mutex.FactB = FactB;
+			}
+		}
+	}
+}
+
+void FCompiledPlannerDomain::LogDiagnostics(const UObject& Owner, const TArray<UGOAPAction*>& Actions, const TArray<UGOAPGoal*>& Goals) const
+{
+	for (TConstSetBitIterator<> It(DeadActions); It; ++It)
+	{
+		UE_LOG(LogAction, Warning, TEXT("%s: %s can't help any goal, no goal's search will ever use it"), *Owner.GetName(), *Actions[It.GetIndex()]->GetActionName());
+	}
+	for (int32 GoalIdx = 0; GoalIdx < GoalSlices.Num(); ++GoalIdx)
+	{
+		if (!GoalSlices[GoalIdx].bReachable && Goals[GoalIdx])
+		{
+			UE_LOG(LogAction, Warning, TEXT("%s: no action can produce any condition of goal %d (%s), it can only be met by the world already matching it"),
+				*Owner.GetName(), GoalIdx, *Goals[GoalIdx]->GetName());
+		}
+	}
+}
+
+void FRegressionAnalysis::Build(const FCompiledPlannerDomain& InDomain, const FWorldState& StartState, const TBitArray<>& InAvailableActions, bool bLandmarks, bool bMutexes)
+{
+	const TArray<FDomainFact>& Facts = InDomain.Facts;
+	uint64 NewStartFacts = 0;
+	for (int32 FactIdx = 0; FactIdx < Facts.Num(); ++FactIdx)
+	{
+		if (StartState.GetProp(Facts[FactIdx].Key) == Facts[FactIdx].Value)
+		{
+			NewStartFacts |= 1ull << FactIdx;
+		}
+	}
+	//Replans mostly start from the same facts with the same actions, the fixpoint below is the expensive part
+	if (Domain == &InDomain && DomainSerial == InDomain.Serial && StartFacts == NewStartFacts
+		&& bBuiltLandmarks == bLandmarks && bBuiltMutexes == bMutexes && AvailableActions == InAvailableActions)
+	{
+		return;
+	}
+	Reset();
+	Domain = &InDomain;
+	DomainSerial = InDomain.Serial;
+	StartFacts = NewStartFacts;
+	AvailableActions = InAvailableActions;
+	bBuiltLandmarks = bLandmarks;
+	bBuiltMutexes = bMutexes;
+
+	if (bMutexes)
+	{
+		for (const FFactMutex& Mutex : InDomain.Mutexes)
+		{
+			const uint64 Pair = (1ull << Mutex.FactA) | (1ull << Mutex.FactB);
+			if ((StartFacts & Pair) == Pair)
+			{
+				continue;
+			}
+			FActiveMutex& Active = ActiveMutexes[ActiveMutexes.AddDefaulted()];
+			Active.KeyA = Facts[Mutex.FactA].Key;
+			Active.ValueA = Facts[Mutex.FactA].Value;
+			Active.KeyB = Facts[Mutex.FactB].Key;
+			Active.ValueB = Facts[Mutex.FactB].Value;
+			Active.KeyMask = (1u << (uint32)Active.KeyA) | (1u << (uint32)Active.KeyB);
+		}
+	}
+
+	if (bLandmarks)
+	{
+		//Greatest fixpoint of LM(f) = {f} + the landmarks every available achiever of f needs,
+		//starting from "every fact" for facts the start state doesn't have
+		const uint64 AllFacts = InDomain.GetFactMask();
+		FactLandmarks.SetNumUninitialized(Facts.Num());
+		for (int32 FactIdx = 0; FactIdx < Facts.Num(); ++FactIdx)
+		{
+			FactLandmarks[FactIdx] = (StartFacts & (1ull << FactIdx)) ? (1ull << FactIdx) : AllFacts;
+		}
+		bool bChanged = true;
+		for (int32 Pass = 0; bChanged && Pass <= Facts.Num(); ++Pass)
+		{
+			bChanged = false;
+			for (int32 FactIdx = 0; FactIdx < Facts.Num(); ++FactIdx)
+			{
+				if (StartFacts & (1ull << FactIdx))
+				{
+					continue;
+				}
+				uint64 Shared = AllFacts;
+				for (int32 ActionIdx : InDomain.FactAchievers[FactIdx])
+				{
+					if (!AvailableActions[ActionIdx])
+					{
+						continue;
+					}
+					uint64 Needed = 0;
+					const uint64 PreFacts = InDomain.ActionPreFacts[ActionIdx];
+					for (int32 PreIdx = 0; PreIdx < Facts.Num(); ++PreIdx)
+					{
+						if (PreFacts & (1ull << PreIdx))
+						{
+							Needed |= FactLandmarks[PreIdx];
+						}
+					}
+					Shared &= Needed;
+				}
+				const uint64 NewLandmarks = FactLandmarks[FactIdx] & (Shared | (1ull << FactIdx));
+				if (NewLandmarks != FactLandmarks[FactIdx])
+				{
+					FactLandmarks[FactIdx] = NewLandmarks;
+					bChanged = true;
+				}
+			}
+		}
+	}
+}
+
+void FRegressionAnalysis::Reset()
+{
+	Domain = nullptr;
+	StartFacts = 0;
+	FactLandmarks.Reset();
+	ActiveMutexes.Reset();
+	DomainSerial = 0;
+	AvailableActions.Empty();
+	bBuiltLandmarks = false;
+	bBuiltMutexes = false;
+}
+
+bool FRegressionAnalysis::IsMutex(const FWorldState& State, uint32 ExactKeys) const
+{
+	for (const FActiveMutex& Mutex : ActiveMutexes)
+	{
+		if ((ExactKeys & Mutex.KeyMask) == Mutex.KeyMask && State.GetProp(Mutex.KeyA) == Mutex.ValueA && State.GetProp(Mutex.KeyB) == Mutex.ValueB)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+int32 FRegressionAnalysis::GetLandmarkCost(const FWorldState& State, uint32 ExactKeys, const TSet<EWorldKey>& UnsatisfiedKeys, const TArray<int32>& Costs) const
+{
+	if (FactLandmarks.Num() == 0)
+	{
+		return 0;
+	}
+	uint64 Landmarks = 0;
+	for (EWorldKey Key : UnsatisfiedKeys)
+	{
+		if ((ExactKeys & (1u << (uint32)Key)) == 0)
+		{
+			continue;
+		}
+		const int32 FactIdx = Domain->FindFact(Key, State.GetProp(Key));
+		if (FactIdx != INDEX_NONE)
+		{
+			Landmarks |= FactLandmarks[FactIdx];
+		}
+	}
+	Landmarks &= ~StartFacts;
+
+	double Cost = 0.0;
+	for (int32 FactIdx = 0; FactIdx < FactLandmarks.Num(); ++FactIdx)
+	{
+		if ((Landmarks & (1ull << FactIdx)) == 0)
+		{
+			continue;
+		}
+		double Cheapest = -1.0;
+		for (int32 ActionIdx : Domain->FactAchievers[FactIdx])
+		{
+			if (AvailableActions[ActionIdx])
+			{
+				//Never 0, the action produces FactIdx itself
+				const double Share = double(Costs[ActionIdx]) / FMath::CountBits(Domain->ActionEffectFacts[ActionIdx] & Landmarks);
+				Cheapest = (Cheapest < 0.0) ? Share : FMath::Min(Cheapest, Share);
+			}
+		}
+		//A landmark nothing available produces makes the node a dead end, adding nothing is still a lower bound
+		Cost += FMath::Max(Cheapest, 0.0);
+	}
+	//Rounding down keeps the bound, plans cost whole numbers
+	return (int32)FMath::FloorToDouble(Cost);
+}
@@ -0,0 +1,201 @@
+#include "../Public/PlannerMacroMiningCommandlet.h"
+#include "../Public/PlannerAsset.h"
+#include "../Public/PlannerCapture.h"
+#include "../Public/PlannerBenchmark.h"
+#include "../Public/GOAPAction.h"
+#include "Misc/PackageName.h"
+#include "Dom/JsonObject.h"
+#include "UObject/Package.h"
+
+namespace
+{
+	struct FMinedChain
+	{
+		TArray<int32> StepIndices;
+		int32 Support = 0;
+		//Search depth saved every time the macro is used instead of the chain
+		int32 Score() const { return Support * (StepIndices.Num() - 1); }
+	};
+}
+
+UPlannerMacroMiningCommandlet::UPlannerMacroMiningCommandlet()
+{
+	IsClient = false;
+	//Saving the asset needs the editor
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UPlannerMacroMiningCommandlet::Main(const FString& Params)
+{
+	FString AssetPath;
+	FString FileList;
+	if (!FParse::Value(*Params, TEXT("asset="), AssetPath) || !FParse::Value(*Params, TEXT("files="), FileList))
+	{
+		UE_LOG(LogPlannerCapture, Error, TEXT("Usage: -run=PlannerMacroMining -asset=<object path> -files=<a.bin,b.bin> [-minsupport=N] [-maxlen=3] [-maxmacros=8] [-json=<out.json>] [-save]"));
+		return 1;
+	}
+	int32 MinSupport = 20;
+	FParse::Value(*Params, TEXT("minsupport="), MinSupport);
+	int32 MaxLen = 3;
+	FParse::Value(*Params, TEXT("maxlen="), MaxLen);
+	MaxLen = FMath::Max(MaxLen, 2);
+	int32 MaxMacros = 8;
+	FParse::Value(*Params, TEXT("maxmacros="), MaxMacros);
+	FString JsonPath = TEXT("GOAPMacros");
+	FParse::Value(*Params, TEXT("json="), JsonPath);
+	const bool bSave = FParse::Param(*Params, TEXT("save"));
+
+	UPlannerAsset* Asset = LoadObject<UPlannerAsset>(nullptr, *AssetPath);
+	if (!Asset)
+	{
+		UE_LOG(LogPlannerCapture, Error, TEXT("Could not load planner asset %s"), *AssetPath);
+		return 1;
+	}
+
+	//Plans record GetActionId, which is the same for the asset's actions and their runtime copies
+	TMap<FString, int32> IdToIndex;
+	for (int32 ActionIdx = 0; ActionIdx < Asset->Actions.Num(); ++ActionIdx)
+	{
+		if (Asset->Actions[ActionIdx])
+		{
+			IdToIndex.Add(FPlannerCapture::GetActionId(*Asset->Actions[ActionIdx]), ActionIdx);
+		}
+	}
+
+	TArray<FString> Files;
+	FileList.ParseIntoArray(Files, TEXT(","));
+	TMap<TArray<int32>, int32> Support;
+	int32 NumPlans = 0;
+	for (const FString& File : Files)
+	{
+		TArray<FPlannerCaptureRecord> Records;
+		if (!FPlannerCapture::LoadFile(File, Records))
+		{
+			return 1;
+		}
+		for (const FPlannerCaptureRecord& Record : Records)
+		{
+			if (!Record.bFound || Record.PlanActions.Num() < 2)
+			{
+				continue;
+			}
+			++NumPlans;
+			//Steps from other assets map to INDEX_NONE and break chains
+			TArray<int32> Steps;
+			for (const FString& Id : Record.PlanActions)
+			{
+				const int32* ActionIdx = IdToIndex.Find(Id);
+				Steps.Add(ActionIdx ? *ActionIdx : INDEX_NONE);
+			}
+			for (int32 Start = 0; Start < Steps.Num(); ++Start)
+			{
+				TArray<int32> Chain;
+				for (int32 End = Start; End < Steps.Num() && Chain.Num() < MaxLen && Steps[End] != INDEX_NONE; ++End)
+				{
+					Chain.Add(Steps[End]);
+					if (Chain.Num() >= 2)
+					{
+						Support.FindOrAdd(Chain) += 1;
+					}
+				}
+			}
+		}
+	}
+
+	TArray<FMinedChain> Candidates;
+	for (const auto& Entry : Support)
+	{
+		if (Entry.Value >= MinSupport)
+		{
+			FMinedChain& Candidate = Candidates[Candidates.AddDefaulted()];
+			Candidate.StepIndices = Entry.Key;
+			Candidate.Support = Entry.Value;
+		}
+	}
+	Candidates.Sort([](const FMinedChain& Lhs, const FMinedChain& Rhs) { return Lhs.Score() > Rhs.Score(); });
+
+	//Chains the asset already has a macro for
+	TArray<TArray<int32>> Existing;
+	for (UGOAPAction* Action : Asset->Actions)
+	{
+		if (const UGOAPAction_Macro* Macro = Cast<UGOAPAction_Macro>(Action))
+		{
+			Existing.Add(Macro->GetStepIndices());
+		}
+	}
+
+	TArray<TSharedPtr<FJsonValue>> MacrosJson;
+	int32 NumAdded = 0;
+	for (const FMinedChain& Candidate : Candidates)
+	{
+		if (NumAdded >= MaxMacros)
+		{
+			break;
+		}
+		if (Existing.Contains(Candidate.StepIndices))
+		{
+			continue;
+		}
+
+		TArray<const UGOAPAction*> Chain;
+		TArray<FString> StepNames;
+		for (int32 ActionIdx : Candidate.StepIndices)
+		{
+			Chain.Add(Asset->Actions[ActionIdx]);
+			StepNames.Add(FPlannerCapture::GetActionId(*Asset->Actions[ActionIdx]));
+		}
+		TArray<FWorldProperty> Preconditions;
+		TArray<FAISymEffect> Effects;
+		int32 Cost = 0;
+		if (!UGOAPAction_Macro::Combine(Chain, Preconditions, Effects, Cost))
+		{
+			UE_LOG(LogPlannerCapture, Display, TEXT("Skipping %s, the chain can't be folded into one action"), *FString::Join(StepNames, TEXT(" > ")));
+			continue;
+		}
+
+		const FString MacroName = FString::Printf(TEXT("Macro: %s"), *FString::Join(StepNames, TEXT(" > ")));
+		if (bSave)
+		{
+			UGOAPAction_Macro* Macro = NewObject<UGOAPAction_Macro>(Asset);
+			Macro->Setup(MacroName, Candidate.StepIndices, Preconditions, Effects, Cost);
+			Asset->Actions.Add(Macro);
+			Asset->CompiledDomain.Reset();
+		}
+		Existing.Add(Candidate.StepIndices);
+		++NumAdded;
+
+		UE_LOG(LogPlannerCapture, Display, TEXT("%s: support %d, cost %d, %d preconditions, %d effects"), *MacroName, Candidate.Support, Cost, Preconditions.Num(), Effects.Num());
+		TSharedRef<FJsonObject> MacroJson = MakeShared<FJsonObject>();
+		MacroJson->SetStringField(TEXT("name"), MacroName);
+		MacroJson->SetNumberField(TEXT("support"), Candidate.Support);
+		MacroJson->SetNumberField(TEXT("steps"), Candidate.StepIndices.Num());
+		MacroJson->SetNumberField(TEXT("cost"), Cost);
+		MacroJson->SetNumberField(TEXT("preconditions"), Preconditions.Num());
+		MacroJson->SetNumberField(TEXT("effects"), Effects.Num());
+		MacrosJson.Add(MakeShared<FJsonValueObject>(MacroJson));
+	}
+
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetStringField(TEXT("asset"), AssetPath);
+	Root->SetNumberField(TEXT("plans"), NumPlans);
+	Root->SetNumberField(TEXT("chains"), Support.Num());
+	Root->SetBoolField(TEXT("saved"), bSave);
+	Root->SetArrayField(TEXT("macros"), MacrosJson);
+	FPlannerBenchmark::WriteResults(JsonPath, Root);
+
+	if (bSave && NumAdded > 0)
+	{
+		UPackage* Package = Asset->GetOutermost();
+		Package->MarkPackageDirty();
+		const FString Filename = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+		if (!UPackage::SavePackage(Package, Asset, RF_Public | RF_Standalone, *Filename))
+		{
+			UE_LOG(LogPlannerCapture, Error, TEXT("Could not save %s"), *Filename);
+			return 1;
+		}
+	}
+	UE_LOG(LogPlannerCapture, Display, TEXT("%d plans, %d macros %s"), NumPlans, NumAdded, bSave ? TEXT("added") : TEXT("found (dry run, pass -save to add them)"));
+	return 0;
+}
@@ -0,0 +1,156 @@
+#include "../Public/PlannerReplayCommandlet.h"
+#include "../Public/PlannerCapture.h"
+#include "../Public/PlannerBenchmark.h"
+#include "../Public/PlannerComponent.h"
+#include "../Public/PlannerAsset.h"
+#include "HAL/PlatformTime.h"
+#include "Dom/JsonObject.h"
+#include "UObject/Package.h"
+
+UPlannerReplayCommandlet::UPlannerReplayCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UPlannerReplayCommandlet::Main(const FString& Params)
+{
+	FString CapturePath;
+	if (!FParse::Value(*Params, TEXT("file="), CapturePath))
+	{
+		UE_LOG(LogPlannerCapture, Error, TEXT("Usage: -run=PlannerReplay -file=<capture.bin> [-iterations=N] [-json=<out.json>]"));
+		return 1;
+	}
+	int32 Iterations = 10;
+	FParse::Value(*Params, TEXT("iterations="), Iterations);
+	Iterations = FMath::Max(Iterations, 1);
+	FString JsonPath;
+	FParse::Value(*Params, TEXT("json="), JsonPath);
+
+	TArray<FPlannerCaptureRecord> Records;
+	if (!FPlannerCapture::LoadFile(CapturePath, Records))
+	{
+		return 1;
+	}
+
+	TArray<TSharedPtr<FJsonValue>> RecordsJson;
+	int32 NumMismatches = 0;
+	double TotalMs = 0.0;
+	double TotalCapturedMs = 0.0;
+	int64 TotalNodes = 0;
+	TArray<FPlanStepInfo> Plan;
+	for (int32 RecordIdx = 0; RecordIdx < Records.Num(); ++RecordIdx)
+	{
+		const FPlannerCaptureRecord& Record = Records[RecordIdx];
+
+		//The search ran on the asset's compiled domain, replay on the same one or the slice, landmarks and mutexes differ
+		const FCompiledPlannerDomain* Domain = nullptr;
+		if (!Record.DomainPath.IsEmpty())
+		{
+			UPlannerAsset* Asset = LoadObject<UPlannerAsset>(nullptr, *Record.DomainPath);
+			Domain = Asset ? &Asset->GetCompiledDomain() : nullptr;
+			if (!Domain || Domain->NumActions != Record.Actions.Num())
+			{
+				UE_LOG(LogPlannerCapture, Error, TEXT("Record %d: %s is missing or no longer has the captured actions, skipping"), RecordIdx, *Record.DomainPath);
+				++NumMismatches;
+				continue;
+			}
+		}
+
+		//Rebuild the action set in capture order so the edge table iterates the same way
+		TArray<UGOAPAction_Synthetic*> Actions;
+		TMap<const UGOAPAction*, int32> ActionCosts;
+		FAStarPlanner Planner;
+		Planner.MaxDepth = Record.MaxDepth;
+		Planner.bUseSlices = Record.bUseSlices;
+		Planner.bUseLandmarks = Record.bUseLandmarks;
+		Planner.bUseMutexes = Record.bUseMutexes;
+		for (const FCapturedAction& Captured : Record.Actions)
+		{
+			UGOAPAction_Synthetic* Action = NewObject<UGOAPAction_Synthetic>(GetTransientPackage());
+			Action->Setup(Captured.Preconditions, Captured.Effects, Captured.Cost, Captured.Name);
+			Action->bContextValid = Captured.bContextValid;
+			Action->AddToRoot();
+			Actions.Add(Action);
+			ActionCosts.Add(Action, Captured.Cost);
+			Planner.AddAction(Action);
+		}
+
+		double BestMs = TNumericLimits<double>::Max();
+		double SumMs = 0.0;
+		bool bMatches = true;
+		bool bLastFound = false;
+		int32 LastCost = 0;
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			Plan.Reset();
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			const bool bFound = Planner.Search(Record.GoalCondition, Record.InitialState, Plan, Domain, Record.GoalIdx);
+			const double Ms = FPlatformTime::GetSecondsPerCycle64() * double(FPlatformTime::Cycles64() - StartCycles) * 1000.0;
+			BestMs = FMath::Min(BestMs, Ms);
+			SumMs += Ms;
+
+			//Same plan step for step, not just the same length
+			bLastFound = bFound;
+			LastCost = 0;
+			bool bSamePlan = bFound == Record.bFound && Plan.Num() == Record.PlanActions.Num();
+			for (int32 StepIdx = 0; StepIdx < Plan.Num(); ++StepIdx)
+			{
+				const UGOAPAction* Action = Plan[StepIdx].Action;
+				const int32* Cost = ActionCosts.Find(Action);
+				LastCost += Cost ? *Cost : 0;
+				bSamePlan = bSamePlan && Action && FPlannerCapture::GetActionId(*Action) == Record.PlanActions[StepIdx];
+			}
+			if (!bSamePlan || LastCost != Record.PlanCost)
+			{
+				bMatches = false;
+			}
+		}
+
+		for (UGOAPAction_Synthetic* Action : Actions)
+		{
+			Action->RemoveFromRoot();
+		}
+
+		const double MeanMs = SumMs / Iterations;
+		TotalMs += MeanMs;
+		TotalCapturedMs += Record.SearchMs;
+		TotalNodes += Planner.LastSearchStats.NodesExpanded;
+		if (!bMatches)
+		{
+			++NumMismatches;
+			UE_LOG(LogPlannerCapture, Warning, TEXT("Record %d: replay does not match capture (found %d, %d steps, cost %d), got (found %d, %d steps, cost %d)"),
+				RecordIdx, Record.bFound, Record.PlanLength, Record.PlanCost, bLastFound, Plan.Num(), LastCost);
+		}
+
+		TSharedRef<FJsonObject> RecordJson = MakeShared<FJsonObject>();
+		RecordJson->SetNumberField(TEXT("index"), RecordIdx);
+		RecordJson->SetNumberField(TEXT("actions"), Record.Actions.Num());
+		RecordJson->SetNumberField(TEXT("nodes_expanded"), Planner.LastSearchStats.NodesExpanded);
+		RecordJson->SetNumberField(TEXT("captured_ms"), Record.SearchMs);
+		RecordJson->SetNumberField(TEXT("mean_ms"), MeanMs);
+		RecordJson->SetNumberField(TEXT("best_ms"), BestMs);
+		RecordJson->SetBoolField(TEXT("deterministic"), bMatches);
+		RecordsJson.Add(MakeShared<FJsonValueObject>(RecordJson));
+	}
+
+	UE_LOG(LogPlannerCapture, Display, TEXT("Replayed %d searches x%d: %.3f ms total (captured %.3f ms), %lld nodes expanded, %d mismatches"),
+		Records.Num(), Iterations, TotalMs, TotalCapturedMs, TotalNodes, NumMismatches);
+
+	if (!JsonPath.IsEmpty())
+	{
+		TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+		Root->SetStringField(TEXT("capture"), CapturePath);
+		Root->SetNumberField(TEXT("iterations"), Iterations);
+		Root->SetNumberField(TEXT("total_ms"), TotalMs);
+		Root->SetNumberField(TEXT("captured_ms"), TotalCapturedMs);
+		Root->SetNumberField(TEXT("nodes_expanded"), double(TotalNodes));
+		Root->SetNumberField(TEXT("mismatches"), NumMismatches);
+		Root->SetArrayField(TEXT("records"), RecordsJson);
+		FPlannerBenchmark::WriteResults(JsonPath, Root);
+	}
+
+	return NumMismatches == 0 ? 0 : 2;
+}
@@ -1,6 +1,7 @@
 #include "..\Public\StateNode.h"
 #include "..\Public\WorldState.h"
 #include "..\Public\GOAPAction.h"
+#include "..\Public\GOAPStats.h"
 
 FStateNode::FStateNode(const FWorldState& InitialState, const TArray<FWorldProperty>& SymbolSet) :
 	CurrentState(MakeShared<FWorldState>(InitialState)),
@@ -32,8 +33,10 @@ FStateNode::FStateNode(const FStateNode& Node) :
 	ParentEdge(Node.ParentEdge),
 	UnsatisfiedKeys(Node.UnsatisfiedKeys),
 	PropFlags(Node.PropFlags),
+	ExactKeys(Node.ExactKeys),
 	ForwardCost(Node.ForwardCost),
 	Heuristic(Node.Heuristic),
+	ExtraHeuristic(Node.ExtraHeuristic),
 	TotalCost(Node.TotalCost),
 	Closed(Node.Closed),
 	Depth(Node.Depth),
@@ -77,6 +80,12 @@ bool FStateNode::IsGoal()
 	return Heuristic <= 0;
 }
 
+void FStateNode::SetExtraHeuristic(int InExtraHeuristic)
+{
+	ExtraHeuristic = InExtraHeuristic;
+	CacheTotalCost();
+}
+
 void FStateNode::ReParent(const FStateNode& OtherNode)
 {
 	ParentNode = OtherNode.ParentNode;
@@ -98,8 +107,22 @@ void FStateNode::GetNeighboringEdges(const LookupTable& ActionMap, TArray<TWeakO
 	}
 }
 
+void FStateNode::GetNeighboringEdges(const TMultiMap<EWorldKey, int32>& ActionMap, TArray<int32>& OutActionIndices)
+{
+	for (const auto& Key : UnsatisfiedKeys)
+	{
+		ActionMap.MultiFind(Key, OutActionIndices);
+	}
+}
+
 bool FStateNode::ChainBackward(UGOAPAction& Action)
 {
+	return ChainBackward(Action, Action.Cost());
+}
+
+bool FStateNode::ChainBackward(UGOAPAction& Action, int32 ActionCost)
+{
+	SCOPE_CYCLE_COUNTER(STAT_GOAP_ChainBackward);
 
 	ParentEdge = &Action;
 	Depth += 1;
@@ -135,7 +158,7 @@ bool FStateNode::ChainBackward(UGOAPAction& Action)
 	CacheTypeHash(GetTypeHash(CurrentState.Get()));
 
 	//add cost of action to produce new forward cost
-	ForwardCost += Action.Cost();
+	ForwardCost += ActionCost;
 	//Also cache total cost for PQueue comparison
 	CacheTotalCost();
 	return true;
@@ -225,6 +248,10 @@ bool FStateNode::AddPrecondition(const FWorldProperty& Precondition)
 	{
 		SetKeyRelevance(Precondition.KeyRHS, true);
 	}
+	else if (Precondition.Comparator == ESymbolTest::Eq)
+	{
+		ExactKeys |= 1u << (uint8)Key;
+	}
 
 	//Compute new heuristic
 	int32 Distance = GoalState->HeuristicDist(Key, NewVal);
@@ -238,7 +265,7 @@ bool FStateNode::AddPrecondition(const FWorldProperty& Precondition)
 
 void FStateNode::CacheTotalCost()
 {
-	TotalCost = ForwardCost + Heuristic;
+	TotalCost = ForwardCost + Heuristic + ExtraHeuristic;
 }
 
 void FStateNode::LogNode() const
@@ -0,0 +1,117 @@
+#include "../../Public/PlannerComponent.h"
+#include "../../Public/PlannerBenchmark.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/Package.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	TArray<UGOAPAction*> MakeActions(int32 Num)
+	{
+		TArray<UGOAPAction*> Actions;
+		for (int32 Idx = 0; Idx < Num; ++Idx)
+		{
+			UGOAPAction_Synthetic* Action = NewObject<UGOAPAction_Synthetic>(GetTransientPackage());
+			Action->Setup(TArray<FWorldProperty>(), TArray<FAISymEffect>(), 1);
+			Actions.Add(Action);
+		}
+		return Actions;
+	}
+
+	FPlanStepInfo MakeStep(UGOAPAction* Action)
+	{
+		FPlanStepInfo Step;
+		Step.SetAction(Action);
+		return Step;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPlanInstanceWrapTest, "GOAP.PlanInstance.Wraparound",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPlanInstanceWrapTest::RunTest(const FString& Parameters)
+{
+	const TArray<UGOAPAction*> Actions = MakeActions(6);
+	FPlanInstance Plan;
+	Plan.Init(4);
+
+	Plan.AddStep(MakeStep(Actions[0]));
+	Plan.AddStep(MakeStep(Actions[1]));
+	Plan.AddStep(MakeStep(Actions[2]));
+	Plan.Advance();
+	Plan.Advance();
+	//Head is at slot 2, these go in slots 3, 0 and 1
+	Plan.AddStep(MakeStep(Actions[3]));
+	Plan.AddStep(MakeStep(Actions[4]));
+	Plan.AddStep(MakeStep(Actions[5]));
+
+	TestEqual(TEXT("Full ring"), Plan.Num(), 4);
+	for (int32 Offset = 0; Offset < Plan.Num(); ++Offset)
+	{
+		TestTrue(FString::Printf(TEXT("Step %d in order across the wrap"), Offset), Plan.GetStep(Offset).Action == Actions[2 + Offset]);
+	}
+	for (int32 Idx = 2; Idx < 6; ++Idx)
+	{
+		TestTrue(TEXT("Current advances in order"), Plan.GetCurrent() == Actions[Idx]);
+		Plan.Advance();
+	}
+	TestTrue(TEXT("Empty after the last step"), Plan.HasReachedEnd());
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPlanInstanceAbortTest, "GOAP.PlanInstance.AbortInFlight",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPlanInstanceAbortTest::RunTest(const FString& Parameters)
+{
+	const TArray<UGOAPAction*> Actions = MakeActions(6);
+	FPlanInstance Plan;
+	Plan.Init(4);
+
+	TArray<FPlanStepInfo> Steps = { MakeStep(Actions[0]), MakeStep(Actions[1]), MakeStep(Actions[2]) };
+	Plan.StartNewPlan(Steps, FWorldState());
+	Plan.Advance();
+
+	//The running step is aborting latently and stays at the head while the new plan queues behind it
+	Plan.Clear(true);
+	TestEqual(TEXT("Only the aborting step is kept"), Plan.Num(), 1);
+	TestTrue(TEXT("Aborting step is still current"), Plan.GetCurrent() == Actions[1]);
+	TestFalse(TEXT("No plan running"), Plan.IsRunningPlan());
+
+	TArray<FPlanStepInfo> NewSteps = { MakeStep(Actions[3]), MakeStep(Actions[4]), MakeStep(Actions[5]) };
+	Plan.StartNewPlan(NewSteps, FWorldState());
+	TestEqual(TEXT("Aborting step plus the new plan"), Plan.Num(), 4);
+	TestTrue(TEXT("Aborting step first"), Plan.GetStep(0).Action == Actions[1]);
+	TestTrue(TEXT("New plan after it"), Plan.GetStep(1).Action == Actions[3] && Plan.GetStep(3).Action == Actions[5]);
+
+	Plan.Clear(false);
+	TestEqual(TEXT("Clear without keeping empties the ring"), Plan.Num(), 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPlanInstanceNoAllocTest, "GOAP.PlanInstance.NoReallocation",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPlanInstanceNoAllocTest::RunTest(const FString& Parameters)
+{
+	const TArray<UGOAPAction*> Actions = MakeActions(3);
+	FPlanInstance Plan;
+	Plan.Init(3);
+	const FPlanStepInfo* Storage = Plan.Buffer.GetData();
+
+	TArray<FPlanStepInfo> Steps = { MakeStep(Actions[0]), MakeStep(Actions[1]), MakeStep(Actions[2]) };
+	for (int32 Round = 0; Round < 10; ++Round)
+	{
+		Plan.StartNewPlan(Steps, FWorldState());
+		Plan.Advance();
+		Plan.Clear(true);
+		Plan.Advance();
+	}
+
+	TestTrue(TEXT("Ring storage never moved"), Plan.Buffer.GetData() == Storage);
+	TestEqual(TEXT("Capacity unchanged"), Plan.GetCapacity(), 3);
+	return true;
+}
+
+#endif
@@ -0,0 +1,257 @@
+#include "../../Public/GOAPPlannerSubsystem.h"
+#include "../../Public/PlannerBenchmark.h"
+#include "../../Public/PlannerComponent.h"
+#include "../../Public/ShooterPlannerSchema.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/Package.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPlannerSyntheticDomainTest, "GOAP.Planner.SyntheticDomain",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPlannerSyntheticDomainTest::RunTest(const FString& Parameters)
+{
+	//The cheapest plan is SolutionDepth increments of one, whatever the distractors are
+	const int32 Depths[] = { 1, 3, 6 };
+	for (int32 Depth : Depths)
+	{
+		FSyntheticDomainParams Params;
+		Params.SolutionDepth = Depth;
+		Params.Seed = 1234 + Depth;
+
+		TArray<UGOAPAction*> Actions;
+		TArray<FWorldProperty> Goal;
+		FWorldState Start;
+		FPlannerBenchmark::GenerateDomain(Params, GetTransientPackage(), Actions, Goal, Start);
+
+		FAStarPlanner Planner;
+		Planner.MaxDepth = Depth * 2;
+		for (UGOAPAction* Action : Actions)
+		{
+			Planner.AddAction(Action);
+		}
+
+		TArray<FPlanStepInfo> Plan;
+		const bool bFound = Planner.Search(Goal, Start, Plan);
+		TestTrue(FString::Printf(TEXT("Depth %d: plan found"), Depth), bFound);
+		TestEqual(FString::Printf(TEXT("Depth %d: plan length"), Depth), Plan.Num(), Depth);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPlannerBenchmarkRunTest, "GOAP.Planner.Benchmark",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPlannerBenchmarkRunTest::RunTest(const FString& Parameters)
+{
+	FSyntheticDomainParams Params;
+	Params.NumSearches = 20;
+	const FPlannerBenchmarkResult Result = FPlannerBenchmark::Run(Params);
+	TestEqual(TEXT("Every search solved"), Result.NumSolved, Params.NumSearches);
+	TestTrue(TEXT("Nodes expanded"), Result.TotalNodesExpanded > 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStaticPlannerShooterTest, "GOAP.Planner.StaticShooter",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FStaticPlannerShooterTest::RunTest(const FString& Parameters)
+{
+	const FStaticPlannerBenchmarkResult Result = FPlannerBenchmark::RunStaticShooter(200, 1234);
+	TestEqual(TEXT("TStaticPlanner and FAStarPlanner agree"), Result.NumMismatches, 0);
+	TestTrue(TEXT("Searches solved"), Result.NumSolved > 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStaticPlannerSchemaBindingTest, "GOAP.Planner.StaticShooterBinding",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+//What UPlannerAsset::ValidateSearchType and UPlannerComponent::InitNativePlanner rely on
+bool FStaticPlannerSchemaBindingTest::RunTest(const FString& Parameters)
+{
+	typedef TStaticPlanner<FShooterPlannerSchema> FNativePlanner;
+	TArray<UGOAPAction*> Actions;
+	FPlannerBenchmark::GenerateShooterActions(GetTransientPackage(), Actions);
+	for (int32 ActionIdx = 0; ActionIdx < Actions.Num(); ++ActionIdx)
+	{
+		TestEqual(TEXT("Bound by name"), FNativePlanner::FindAction(Actions[ActionIdx]->GetActionName()), ActionIdx);
+		TestTrue(TEXT("Matches its schema entry"), FNativePlanner::MatchesAction(ActionIdx, *Actions[ActionIdx]));
+	}
+
+	//Same name, different cost
+	UGOAPAction_Synthetic* Changed = NewObject<UGOAPAction_Synthetic>(GetTransientPackage());
+	Changed->Setup(Actions[0]->GetPreconditions(), Actions[0]->GetEffects(), Actions[0]->Cost() + 1, Actions[0]->GetActionName());
+	TestFalse(TEXT("A changed action doesn't match"), FNativePlanner::MatchesAction(0, *Changed));
+	TestEqual(TEXT("Unknown names aren't bound"), FNativePlanner::FindAction(TEXT("NotAShooterAction")), (int32)INDEX_NONE);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPlannerLandmarkHeuristicTest, "GOAP.Planner.LandmarkHeuristic",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+//The landmark cost is a lower bound, so turning it on can only change how many nodes a search expands
+bool FPlannerLandmarkHeuristicTest::RunTest(const FString& Parameters)
+{
+	//One action producing two landmarks is paid for once: Prepare (cost 1) gives both facts Strike (cost 1) needs
+	TArray<UGOAPAction*> Actions;
+	TArray<FAISymEffect> PrepareEffects;
+	PrepareEffects.Add(FAISymEffect(EWorldKey::kUsingObject, (uint8)1));
+	PrepareEffects.Add(FAISymEffect(EWorldKey::kTargetSuppressed, (uint8)1));
+	UGOAPAction_Synthetic* Prepare = NewObject<UGOAPAction_Synthetic>(GetTransientPackage());
+	Prepare->Setup(TArray<FWorldProperty>(), PrepareEffects, 1, TEXT("Prepare"));
+	Actions.Add(Prepare);
+	TArray<FWorldProperty> StrikePreconditions;
+	StrikePreconditions.Add(FWorldProperty(EWorldKey::kUsingObject, (uint8)1));
+	StrikePreconditions.Add(FWorldProperty(EWorldKey::kTargetSuppressed, (uint8)1));
+	for (FWorldProperty& Precondition : StrikePreconditions)
+	{
+		Precondition.bIsNotSolvable = false;
+	}
+	TArray<FAISymEffect> StrikeEffects;
+	StrikeEffects.Add(FAISymEffect(EWorldKey::kTargetDead, (uint8)1));
+	UGOAPAction_Synthetic* Strike = NewObject<UGOAPAction_Synthetic>(GetTransientPackage());
+	Strike->Setup(StrikePreconditions, StrikeEffects, 1, TEXT("Strike"));
+	Actions.Add(Strike);
+
+	TArray<TArray<FWorldProperty>> GoalConditions;
+	TArray<FWorldProperty>& Goal = GoalConditions[GoalConditions.AddDefaulted()];
+	Goal.Add(FWorldProperty(EWorldKey::kTargetDead, (uint8)1));
+	Goal[0].bIsNotSolvable = false;
+	FCompiledPlannerDomain Domain;
+	Domain.Compile(Actions, GoalConditions);
+
+	FWorldState Start;
+	TBitArray<> Available(true, Actions.Num());
+	FRegressionAnalysis Analysis;
+	Analysis.Build(Domain, Start, Available, true, false);
+	FWorldState GoalState(Start);
+	GoalState.SetProp(EWorldKey::kTargetDead, 1);
+	TSet<EWorldKey> Unsatisfied;
+	Unsatisfied.Add(EWorldKey::kTargetDead);
+	TArray<int32> Costs;
+	Costs.Add(1);
+	Costs.Add(1);
+	TestEqual(TEXT("Landmark cost of the goal is the cheapest plan's"), Analysis.GetLandmarkCost(GoalState, 1u << (uint32)EWorldKey::kTargetDead, Unsatisfied, Costs), 2);
+
+	FAStarPlanner Planner;
+	Planner.MaxDepth = 4;
+	for (UGOAPAction* Action : Actions)
+	{
+		Planner.AddAction(Action);
+	}
+	TArray<FPlanStepInfo> Plan;
+	TestTrue(TEXT("Plan found with landmarks"), Planner.Search(Goal, Start, Plan, &Domain, 0));
+	TestEqual(TEXT("Cheapest plan with landmarks"), Plan.Num(), 2);
+
+	const bool Domains[] = { false, true };
+	for (bool bShooter : Domains)
+	{
+		const FLandmarkBenchmarkResult Result = FPlannerBenchmark::RunLandmarks(bShooter, 60, 1234);
+		TestTrue(FString::Printf(TEXT("%s: searches solved"), *Result.DomainName), Result.NumSolved > 0);
+		TestEqual(FString::Printf(TEXT("%s: plans cost the same with and without landmarks"), *Result.DomainName), Result.NumCostMismatches, 0);
+		AddInfo(FString::Printf(TEXT("%s: %lld nodes expanded with landmarks, %lld without, %.4f ms against %.4f ms per search"),
+			*Result.DomainName, Result.NodesExpandedWith, Result.NodesExpandedWithout, Result.MeanMsWith, Result.MeanMsWithout));
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPlannerSquadReplanTest, "GOAP.Planner.SquadReplans",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPlannerSquadReplanTest::RunTest(const FString& Parameters)
+{
+	const int32 SquadSizes[] = { 1, 4, 16 };
+	for (int32 SquadSize : SquadSizes)
+	{
+		const FSquadReplanBenchmarkResult Result = FPlannerBenchmark::RunSquadReplans(SquadSize, 50, 1234);
+		TestTrue(FString::Printf(TEXT("Squad of %d: sharing never searches more"), SquadSize), Result.SharedSearches <= Result.PerAgentSearches);
+		//A shared plan is the one the member's own search finds, never a costlier one
+		TestEqual(FString::Printf(TEXT("Squad of %d: shared plans cost what the member's own would"), SquadSize), Result.NumCostMismatches, 0);
+		AddInfo(FString::Printf(TEXT("Squad of %d: shared %.4f ms (%lld searches), per agent %.4f ms (%lld searches)"),
+			SquadSize, Result.SharedMs, Result.SharedSearches, Result.PerAgentMs, Result.PerAgentSearches));
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPlannerSquadWorldStateTest, "GOAP.Planner.SquadWorldState",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+//A member's own effects on a shared key go to the squad, only an explicit override cuts it off
+bool FPlannerSquadWorldStateTest::RunTest(const FString& Parameters)
+{
+	const EWorldKey Shared = EWorldKey::kTargetDead;
+	FPlannerAgentBatch Agents;
+	const int32 First = Agents.Add();
+	const int32 Second = Agents.Add();
+	const int32 SquadIdx = Agents.CreateSquad(1u << (uint32)Shared, FWorldState());
+	Agents.JoinSquad(First, SquadIdx);
+	Agents.JoinSquad(Second, SquadIdx);
+
+	//Like UPlannerComponent::OnTaskFinished for an action with a shared effect
+	TestTrue(TEXT("Effect applied"), Agents.ApplyEffect(First, FAISymEffect(Shared, 1)));
+	Agents.RunPasses(true);
+	TestEqual(TEXT("The squad has the effect"), Agents.Squads[SquadIdx].WS.GetProp(Shared), (uint8)1);
+	TestEqual(TEXT("The other member sees the effect"), Agents.WorldStates[Second].GetProp(Shared), (uint8)1);
+
+	Agents.SetSquadProp(SquadIdx, Shared, 0);
+	Agents.RunPasses(true);
+	TestEqual(TEXT("The acting member still sees squad writes"), Agents.WorldStates[First].GetProp(Shared), (uint8)0);
+	TestEqual(TEXT("So does the other member"), Agents.WorldStates[Second].GetProp(Shared), (uint8)0);
+
+	//UPlannerComponent::OverrideWSProp
+	Agents.OverrideSquadKey(First, Shared);
+	Agents.WorldStates[First].SetProp(Shared, 1);
+	Agents.WriteSharedKey(First, Shared);
+	Agents.RunPasses(true);
+	TestEqual(TEXT("An override stays local"), Agents.WorldStates[Second].GetProp(Shared), (uint8)0);
+	Agents.SetSquadProp(SquadIdx, Shared, 0);
+	Agents.RunPasses(true);
+	TestEqual(TEXT("An override ignores squad writes"), Agents.WorldStates[First].GetProp(Shared), (uint8)1);
+	Agents.RevertSquadKey(First, Shared);
+	Agents.RunPasses(true);
+	TestEqual(TEXT("Reverting takes the squad value again"), Agents.WorldStates[First].GetProp(Shared), (uint8)0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPlannerAgentBatchScalingTest, "GOAP.Planner.AgentBatchScaling",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+//Same runs as GOAP.Benchmark.Agents, with fewer frames
+//The batch has to stay linear in the number of agents and fit a slice of a 60Hz frame at 2000 agents
+bool FPlannerAgentBatchScalingTest::RunTest(const FString& Parameters)
+{
+	//Per frame, for 2000 agents
+	const double BudgetMs = 1.0;
+	//Per agent cost at 2000 agents against 100, plus slack for timer noise on the small run
+	const double MaxPerAgentGrowth = 2.0;
+	const double PerAgentSlackUs = 0.25;
+
+	const int32 AgentCounts[] = { 100, 500, 2000 };
+	double FirstPerAgentUs = 0.0;
+	for (int32 NumAgents : AgentCounts)
+	{
+		const FAgentBatchBenchmarkResult Result = FPlannerBenchmark::RunAgentBatch(NumAgents, 60, 1234);
+		TestEqual(FString::Printf(TEXT("%d agents: frames run"), NumAgents), Result.NumFrames, 60);
+		const double PerAgentUs = Result.MeanMs * 1000.0 / NumAgents;
+		AddInfo(FString::Printf(TEXT("%d agents: %.4f ms mean, %.4f ms p99, %.4f ms single threaded, %.4f us per agent, %.2f replans per frame"),
+			NumAgents, Result.MeanMs, Result.P99Ms, Result.SingleThreadMeanMs, PerAgentUs, Result.ReplansPerFrame));
+
+		if (NumAgents == AgentCounts[0])
+		{
+			FirstPerAgentUs = PerAgentUs;
+		}
+		else
+		{
+			TestTrue(FString::Printf(TEXT("%d agents: %.4f us per agent is within %.1fx of %d agents (%.4f us)"), NumAgents, PerAgentUs, MaxPerAgentGrowth, AgentCounts[0], FirstPerAgentUs),
+				PerAgentUs <= FirstPerAgentUs * MaxPerAgentGrowth + PerAgentSlackUs);
+		}
+		if (NumAgents == 2000)
+		{
+			TestTrue(FString::Printf(TEXT("2000 agents: %.4f ms mean is under the %.1f ms budget"), Result.MeanMs, BudgetMs), Result.MeanMs <= BudgetMs);
+		}
+	}
+	return true;
+}
+
+#endif
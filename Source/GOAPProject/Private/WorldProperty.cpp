@@ -99,32 +99,26 @@ namespace FPlannerWSOperations
 	const FWSOperationsSetup Setup;
 }
 
-bool FAISymEffect::Apply(uint8* Values) const
+bool FAISymEffect::Apply(uint8& ValueLHS, uint8 ValueRHS) const
 {
-	uint8 ValueRHS = (IsRHSAbsolute()) ? Value : Values[(uint8)KeyRHS];
-
-	uint8 KeyLHS = uint8(Key);
 	uint8 OpIdx = uint8(Op);
-	bool bIsValid = (*(FPlannerWSOperations::OpValidFuncs[OpIdx]))(Values[KeyLHS], ValueRHS);
+	bool bIsValid = (*(FPlannerWSOperations::OpValidFuncs[OpIdx]))(ValueLHS, ValueRHS);
 	if (!bIsValid)
 	{
 		return false;
 	}
-	(*(FPlannerWSOperations::OpFuncs[OpIdx]))(Values[KeyLHS], ValueRHS);
+	(*(FPlannerWSOperations::OpFuncs[OpIdx]))(ValueLHS, ValueRHS);
 	return true;
 }
 
-bool FAISymEffect::Revert(uint8* Values) const
+bool FAISymEffect::Revert(uint8& ValueLHS, uint8 ValueRHS) const
 {
-	uint8 ValueRHS = (IsRHSAbsolute()) ? Value : Values[(uint8)KeyRHS];
-
-	uint8 KeyLHS = uint8(Key);
 	uint8 OpIdx = uint8(Op);
-	bool bIsValid = (*(FPlannerWSOperations::InvOpValidFuncs[OpIdx]))(Values[KeyLHS], ValueRHS);
+	bool bIsValid = (*(FPlannerWSOperations::InvOpValidFuncs[OpIdx]))(ValueLHS, ValueRHS);
 	if (!bIsValid)
 	{
 		return false;
 	}
-	(*(FPlannerWSOperations::InvOpFuncs[OpIdx]))(Values[KeyLHS], ValueRHS);
+	(*(FPlannerWSOperations::InvOpFuncs[OpIdx]))(ValueLHS, ValueRHS);
 	return true;
 }
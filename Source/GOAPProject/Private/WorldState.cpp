@@ -6,42 +6,47 @@
 
 DEFINE_LOG_CATEGORY(LogWS);
 
-void FWorldState::SetProp(EWorldKey Key, uint8 nValue) 
-{
-	uint8 Idx = (uint8)Key;
-	State[Idx] = nValue;
-}
-
-const uint8& FWorldState::GetProp(EWorldKey Key) const
-{
-	uint8 Idx = (uint8)Key;
-	return State[Idx];
-}
-
 bool FWorldState::CheckCondition(const FWorldProperty& Condition) const
 {
-	return Condition.Evaluate(State.GetData());
+	uint8 RHSValue = (Condition.IsRHSAbsolute()) ? Condition.Value : GetProp(Condition.KeyRHS);
+	return Condition.Evaluate(GetProp(Condition.Key), RHSValue);
 }
 
 void FWorldState::SatisfyCondition(const FWorldProperty& Condition)
 {
-	uint8 NewValue = Condition.MinSatisfyVal(State.GetData());
-	State[uint8(Condition.Key)] = NewValue;
+	uint8 RHSValue = (Condition.IsRHSAbsolute()) ? Condition.Value : GetProp(Condition.KeyRHS);
+	uint8 NewValue = FMath::Min(Condition.MinSatisfyVal(RHSValue), GetMaxValue(Condition.Key));
+	SetProp(Condition.Key, NewValue);
 }
 
 bool FWorldState::ApplyEffect(const FAISymEffect& Effect)
 {
-	return Effect.Apply(State.GetData());
+	uint8 Value = GetProp(Effect.Key);
+	uint8 ValueRHS = (Effect.IsRHSAbsolute()) ? Effect.Value : GetProp(Effect.KeyRHS);
+	//the result also has to fit in the key's field
+	if (!Effect.Apply(Value, ValueRHS) || Value > GetMaxValue(Effect.Key))
+	{
+		return false;
+	}
+	SetProp(Effect.Key, Value);
+	return true;
 }
 
 bool FWorldState::RevertEffect(const FAISymEffect& Effect)
 {
-	return Effect.Revert(State.GetData());
+	uint8 Value = GetProp(Effect.Key);
+	uint8 ValueRHS = (Effect.IsRHSAbsolute()) ? Effect.Value : GetProp(Effect.KeyRHS);
+	if (!Effect.Revert(Value, ValueRHS) || Value > GetMaxValue(Effect.Key))
+	{
+		return false;
+	}
+	SetProp(Effect.Key, Value);
+	return true;
 }
 
 int32 FWorldState::HeuristicDist(EWorldKey Key, uint8 Value, bool bHamming) const
 {
-	int32 StateVal = State[(uint8)Key];
+	int32 StateVal = GetProp(Key);
 	if (bHamming)
 	{
 		return StateVal != Value;
@@ -54,11 +59,9 @@ int32 FWorldState::HeuristicDist(EWorldKey Key, uint8 Value, bool bHamming) cons
 
 void FWorldState::LogWS() const
 {
-	uint8 Key = 0;
-	for (const auto& Value : State)
+	for (uint32 Key = 0; Key < Num(); ++Key)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("< k%d | v%d >"), Key, Value);
-		++Key;
+		UE_LOG(LogTemp, Warning, TEXT("< k%d | v%d >"), Key, GetProp((EWorldKey)Key));
 	}
 }
 
@@ -68,12 +71,11 @@ void FWorldState::DescribeSelfToGameplayDebugger(FGameplayDebuggerCategory* Debu
 {
 	DebuggerCategory->AddTextLine(FString(TEXT("WorldState")));
 
-	uint8 Key = 0;
-	for (const auto& Value : State)
+	const UEnum* KeyEnum = StaticEnum<EWorldKey>();
+	for (uint32 Key = 0; Key < Num(); ++Key)
 	{
-		FString PropText = FString::Printf(TEXT("< k%d | v%d >"), Key, Value);
+		FString PropText = FString::Printf(TEXT("  %s: {white}%d"), *KeyEnum->GetNameStringByValue(Key), GetProp((EWorldKey)Key));
 		DebuggerCategory->AddTextLine(PropText);
-		++Key;
 	}
 }
 #endif //WITH_GAMEPLAY_DEBUGGER
\ No newline at end of file
@@ -0,0 +1,34 @@
+#include "../Public/WorldStateSnapshot.h"
+
+bool FWorldStateSnapshotStore::Publish(const FWorldState& State)
+{
+	check(IsInGameThread());
+	const uint32 Version = Sequence.Load() >> 1;
+	if (Buffers[Version & 1] == State)
+	{
+		return false;
+	}
+	Sequence.Store(Version * 2 + 1);
+	FPlatformMisc::MemoryBarrier();
+	Buffers[(Version + 1) & 1] = State;
+	FPlatformMisc::MemoryBarrier();
+	Sequence.Store((Version + 1) * 2);
+	return true;
+}
+
+FWorldStateSnapshot FWorldStateSnapshotStore::Read() const
+{
+	FWorldStateSnapshot Snapshot;
+	for (;;)
+	{
+		const uint32 Before = Sequence.Load();
+		Snapshot.Version = Before >> 1;
+		Snapshot.WS = Buffers[Snapshot.Version & 1];
+		FPlatformMisc::MemoryBarrier();
+		//Our buffer is only written again by the publish after next, which starts at Version * 2 + 3
+		if (Sequence.Load() - Snapshot.Version * 2 <= 2)
+		{
+			return Snapshot;
+		}
+	}
+}
@@ -30,35 +30,6 @@ protected:
 	typedef TMultiMap<EWorldKey, TWeakObjectPtr<UGOAPAction>> LookupTable;
 	typedef TSharedPtr<FStateNode> NodePtr;
 
-	struct FPriorityQueue
-	{
-		TArray<NodePtr> Heap;
-		TSharedPtrLess<FStateNode> LessFn;
-		
-		FPriorityQueue() : Heap(), LessFn()
-		{
-			Heap.Heapify(LessFn);
-		}
-		void Push(const NodePtr& InItem)
-		{
-			Heap.HeapPush(InItem, LessFn);
-		}
-
-		void Pop(NodePtr& OutItem)
-		{
-			Heap.HeapPop(OutItem, LessFn);
-		}
-
-		void ReSort()
-		{
-			Heap.HeapSort(LessFn);
-		}
-
-		TArray<NodePtr>::SizeType Num() const
-		{
-			return Heap.Num();
-		}
-	};
 	LookupTable ActionTable;
 
 	UPROPERTY()
@@ -72,6 +43,7 @@ public:
 	void OnRegister() override;
 	void OnUnregister() override;
 
+	//Returns the goal node, or null if no plan within MaxDepth exists
 	TSharedPtr<FStateNode> Search(UGOAPGoal* Goal, const FWorldState& InitialState);
 
 	UFUNCTION()
@@ -0,0 +1,210 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "StateNode.h"
+#include "GOAPStats.h"
+
+//Counters for the last regressive search
+struct GOAPPROJECT_API FPlannerSearchStats
+{
+	int32 NodesExpanded = 0;
+	int32 NodesGenerated = 0;
+	//Children that hashed to a node already in the pool
+	int32 DuplicateHits = 0;
+	int32 Reparents = 0;
+	int32 FringePeak = 0;
+	//Children dropped for needing two facts the domain's mutexes rule out together
+	int32 MutexPrunes = 0;
+	//Context and cost lookups of the actions the search may use, and how many FAStarPlanner's action tables answered from cache
+	int32 CacheLookups = 0;
+	int32 CacheHits = 0;
+	//Every FStateNode the search created, including children ChainBackward or the mutexes rejected
+	int32 NodesAllocated = 0;
+	//Bytes held by the node pool and open list when the search ended, only filled when asked for.
+	//The pool never drops a node, so this is the search's peak
+	int64 PeakBytes = 0;
+};
+
+/** Open list policy, a binary heap ordered by FStateNode::GetCost
+  * Uses TArray's heap functionality to mimic a priority queue
+  */
+struct FStateNodeHeap
+{
+	typedef TSharedPtr<FStateNode> NodePtr;
+
+	TArray<NodePtr> Heap;
+	TSharedPtrLess<FStateNode> LessFn;
+
+	FORCEINLINE void Push(const NodePtr& Node)
+	{
+		Heap.HeapPush(Node, LessFn);
+	}
+	FORCEINLINE void Pop(NodePtr& OutNode)
+	{
+		Heap.HeapPop(OutNode, LessFn);
+	}
+	//An open node got cheaper
+	FORCEINLINE void Update()
+	{
+		Heap.HeapSort(LessFn);
+	}
+	FORCEINLINE int32 Num() const
+	{
+		return Heap.Num();
+	}
+	//Nodes are owned by the closed set, only the heap itself
+	SIZE_T GetAllocatedSize() const
+	{
+		return Heap.GetAllocatedSize();
+	}
+};
+
+/** Closed set policy
+  * To save time, ALL nodes are added to a single set, and keep track of whether they're closed
+  * This does mean that we're using additional space, but it's easier and faster
+  */
+struct FStateNodePool
+{
+	typedef TSharedPtr<FStateNode> NodePtr;
+
+	TSet<NodePtr, FStateNode::SetKeyFuncs> Nodes;
+
+	FORCEINLINE NodePtr* Find(const NodePtr& Node)
+	{
+		return Nodes.Find(Node);
+	}
+	FORCEINLINE void Add(const NodePtr& Node)
+	{
+		Nodes.Add(Node);
+	}
+	SIZE_T GetAllocatedSize() const
+	{
+		SIZE_T Size = Nodes.GetAllocatedSize();
+		for (const NodePtr& Node : Nodes)
+		{
+			Size += Node->GetAllocatedSize();
+		}
+		return Size;
+	}
+};
+
+//Heuristic policy for nodes ordered by their own regression heuristic only
+struct FNoExtraHeuristic
+{
+	FORCEINLINE int32 operator()(const FStateNode& Node) const
+	{
+		return 0;
+	}
+};
+
+//Termination policy, a goal node is any node whose state matches the initial state
+struct FDepthLimitedGoal
+{
+	int32 MaxDepth;
+
+	explicit FDepthLimitedGoal(int32 InMaxDepth) : MaxDepth(InMaxDepth) {}
+
+	FORCEINLINE bool IsGoal(FStateNode& Node) const
+	{
+		return Node.IsGoal();
+	}
+	//Nodes past MaxDepth are closed without expanding, so a partial plan is never returned
+	FORCEINLINE bool ShouldExpand(const FStateNode& Node) const
+	{
+		return Node.GetDepth() <= MaxDepth;
+	}
+};
+
+/** TRegressiveSearch
+  * The A* loop behind UAStarComponent and FAStarPlanner. Everything that differs between searches is
+  * a policy resolved at compile time:
+  *	OpenListType		Push(Node), Pop(OutNode), Update() after an open node got cheaper, Num()
+  *	ClosedSetType		Find(Node) returning the pooled node with the same state or null, Add(Node)
+  *	SuccessorType		Generate(Node, Emit), calls Emit(Child) for every child ChainBackward accepted
+  *	HeuristicType		operator()(Node), cost added on top of the node's own heuristic
+  *	TerminationType		IsGoal(Node), ShouldExpand(Node)
+  * Returns the goal node, or null if the open list ran out first. With bMeasureMemory the open list and
+  * closed set also need GetAllocatedSize(), which walks every pooled node, so benchmarks only.
+  */
+template<typename OpenListType = FStateNodeHeap, typename ClosedSetType = FStateNodePool>
+struct TRegressiveSearch
+{
+	typedef TSharedPtr<FStateNode> NodePtr;
+
+	template<typename SuccessorType, typename HeuristicType, typename TerminationType>
+	static NodePtr Run(const NodePtr& Start, SuccessorType& Successors, const HeuristicType& Heuristic, const TerminationType& Termination, FPlannerSearchStats& Stats, bool bMeasureMemory = false)
+	{
+		OpenListType Open;
+		ClosedSetType Closed;
+		auto Finish = [&](const NodePtr& Result)
+		{
+			if (bMeasureMemory)
+			{
+				Stats.PeakBytes = int64(Closed.GetAllocatedSize() + Open.GetAllocatedSize());
+			}
+			return Result;
+		};
+
+		Start->SetExtraHeuristic(Heuristic(*Start));
+		Open.Push(Start);
+		Closed.Add(Start);
+
+		NodePtr CurrentNode;
+		while (Open.Num() != 0)
+		{
+			//pop the lowest cost node from p-queue
+			Open.Pop(CurrentNode);
+			if (!CurrentNode.IsValid())
+			{
+				break;
+			}
+			CurrentNode->MarkClosed();
+			if (Termination.IsGoal(*CurrentNode))
+			{
+				return Finish(CurrentNode);
+			}
+			if (!Termination.ShouldExpand(*CurrentNode))
+			{
+				continue;
+			}
+
+			//Verbose group, a scope per expansion is too fine grained for the default GOAP stats
+			SCOPE_CYCLE_COUNTER(STAT_GOAP_Successors);
+			++Stats.NodesExpanded;
+			Successors.Generate(*CurrentNode, [&](const NodePtr& ChildNode)
+			{
+				++Stats.NodesGenerated;
+				//check if node exists already
+				const NodePtr* FindNode = Closed.Find(ChildNode);
+				if (FindNode != nullptr && FindNode->IsValid())
+				{
+					++Stats.DuplicateHits;
+					NodePtr ExistingNode = *FindNode;
+					if (ChildNode->GetForwardCost() < ExistingNode->GetForwardCost())
+					{
+						++Stats.Reparents;
+						ExistingNode->ReParent(*ChildNode);
+						if (ExistingNode->IsClosed())
+						{
+							ExistingNode->MarkOpened();
+							Open.Push(ExistingNode);
+						}
+						else
+						{
+							Open.Update();
+						}
+					}
+				}
+				else
+				{
+					ChildNode->SetExtraHeuristic(Heuristic(*ChildNode));
+					ChildNode->MarkOpened(); //just in case we haven't
+					Open.Push(ChildNode);
+					Closed.Add(ChildNode);
+				}
+			});
+			Stats.FringePeak = FMath::Max(Stats.FringePeak, (int32)Open.Num());
+		}
+		return Finish(nullptr);
+	}
+};
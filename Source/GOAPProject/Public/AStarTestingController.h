@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "AIController.h"
 #include "WorldState.h"
+#include "PlannerBenchmark.h"
 #include "AStarTestingController.generated.h"
 
 class UAStarComponent;
@@ -37,9 +38,14 @@ protected:
 	UPROPERTY(transient)
 		TArray<UGOAPAction*> Actions;
 
+	//Domain searched by Plan()
+	UPROPERTY(EditAnywhere)
+		FSyntheticDomainParams BenchmarkParams;
+
 public:
 
 	AAStarTestingController();
+	//Runs the planner benchmark on BenchmarkParams and logs the results as JSON
 	UFUNCTION(BlueprintCallable)
 		void Plan();
 	UFUNCTION()
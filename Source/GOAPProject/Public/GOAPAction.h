@@ -20,6 +20,7 @@ class UAnimMontage;
 class AAIController;
 class UBrainComponent;
 class UPlannerComponent;
+class UGOAPCostProvider;
 struct FAIRequestID;
 struct FPathFollowingResult;
 struct FWorldState;
@@ -72,6 +73,18 @@ protected:
 	UPROPERTY(EditDefaultsOnly)
 	int EdgeCost;
 
+	//Optional dynamic cost, EdgeCost is passed in as the base cost
+	UPROPERTY(EditAnywhere, Instanced)
+		UGOAPCostProvider* CostProvider = nullptr;
+
+	//Keep the VerifyContext result between searches, it's only re-run when one of
+	//ContextInvalidationKeys changes or the planner component invalidates this action
+	UPROPERTY(EditAnywhere)
+		bool bCacheContext = false;
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bCacheContext"))
+		TArray<EWorldKey> ContextInvalidationKeys;
+
 	UPROPERTY()
 		EActionStatus TaskStatus;
 
@@ -95,6 +108,10 @@ public:
 		return EdgeCost;
 	}
 
+	//Cost the planner stores in its cost table, evaluated once per search at most
+	int32 SnapshotCost(const FWorldState& WS) const;
+	const UGOAPCostProvider* GetCostProvider() const { return CostProvider; }
+
 	//TODO: don't need to get rid of this, but shouldn't do it in the planner
 	/**VerifyContext
 	  * Used to verify context preconditions and cache data dependencies
@@ -107,6 +124,9 @@ public:
 		return true;
 	}
 
+	bool CachesContext() const { return bCacheContext; }
+	const TArray<EWorldKey>& GetContextInvalidationKeys() const { return ContextInvalidationKeys; }
+
 	bool ValidatePlannerPreconditions(const FWorldState& WorldState);
 	//Should be called when actions are created
 	//Does not activate the action, just adds it to the controller
@@ -236,4 +256,40 @@ public:
 		return UAITask::NewAITask<T>(Controller, *this);
 	}
 };
+/** Chain of an asset's actions that the planner treats as a single edge
+  * Made by -run=PlannerMacroMining from recorded plans. StepIndices index the planner asset's
+  * Actions, and UPlannerComponent::StartNewPlan expands the macro back into those steps so it's
+  * never run itself.
+  */
+UCLASS(HideDropdown)
+class GOAPPROJECT_API UGOAPAction_Macro : public UGOAPAction
+{
+	GENERATED_BODY()
+
+protected:
+	UPROPERTY(VisibleAnywhere)
+		TArray<int32> StepIndices;
+
+	//The owning component's copies of the steps, see ResolveSteps
+	UPROPERTY(transient)
+		TArray<UGOAPAction*> Steps;
+public:
+	/** Preconditions and effects of running Chain in order
+	  * Preconditions met by an earlier step's effects are dropped and later effects on a key
+	  * replace earlier ones. Returns false for chains that can't be folded: steps with variable
+	  * (KeyRHS) conditions or effects, Inc/Dec effects, cost providers, nested macros, or a step
+	  * whose precondition an earlier step breaks.
+	  */
+	static bool Combine(const TArray<const UGOAPAction*>& Chain, TArray<FWorldProperty>& OutPreconditions, TArray<FAISymEffect>& OutEffects, int32& OutCost);
+
+	void Setup(const FString& InName, const TArray<int32>& InStepIndices, const TArray<FWorldProperty>& InPreconditions, const TArray<FAISymEffect>& InEffects, int32 InCost);
+	//ActionSet of the owning component, which is in asset order
+	void ResolveSteps(const TArray<UGOAPAction*>& ActionSet);
+	const TArray<UGOAPAction*>& GetSteps() const { return Steps; }
+	const TArray<int32>& GetStepIndices() const { return StepIndices; }
+
+	virtual bool VerifyContext() override;
+	virtual EActionResult StartAction() override;
+};
+
 typedef TMultiMap<EWorldKey, TWeakObjectPtr<UGOAPAction>> LookupTable;
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "GOAPCooldownSubsystem.generated.h"
+
+class UPlannerComponent;
+class UWorld;
+
+struct GOAPPROJECT_API FCooldownTimerHandle
+{
+	int32 Index = INDEX_NONE;
+	uint32 Serial = 0;
+
+	bool IsValid() const { return Index != INDEX_NONE; }
+	void Reset() { Index = INDEX_NONE; }
+};
+
+/** Tag cooldowns for every agent in a hierarchical timer wheel
+  * 4 levels of 64 slots at CooldownTickSeconds resolution, so inserting, cancelling and expiring
+  * a cooldown are all O(1). When a cooldown ends only its planner is told, see
+  * UPlannerComponent::OnCooldownExpired.
+  */
+UCLASS()
+class GOAPPROJECT_API UGOAPCooldownSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+public:
+	static UGOAPCooldownSubsystem* Get(const UObject* WorldContextObject);
+
+	static constexpr float CooldownTickSeconds = 0.05f;
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	//EndTime is in world seconds
+	FCooldownTimerHandle Schedule(UPlannerComponent& Owner, const FGameplayTag& Tag, float EndTime);
+	void Cancel(FCooldownTimerHandle& Handle);
+
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	//Only ticked by our own world, editor preview worlds included
+	virtual bool IsTickableInEditor() const override { return true; }
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+
+private:
+	static constexpr int32 SlotBits = 6;
+	static constexpr int32 SlotsPerLevel = 1 << SlotBits;
+	static constexpr int32 NumLevels = 4;
+
+	struct FTimerEntry
+	{
+		TWeakObjectPtr<UPlannerComponent> Owner;
+		FGameplayTag Tag;
+		uint64 ExpireTick = 0;
+		uint32 Serial = 0;
+		//Intrusive list, slot heads live in SlotHeads
+		int32 Prev = INDEX_NONE;
+		int32 Next = INDEX_NONE;
+		int32 Slot = INDEX_NONE;
+	};
+
+	TArray<FTimerEntry> Entries;
+	//Free entries are chained through Next
+	int32 FreeHead = INDEX_NONE;
+	int32 SlotHeads[NumLevels * SlotsPerLevel];
+	int32 NumActive = 0;
+	uint32 NextSerial = 1;
+
+	uint64 CurrentTick = 0;
+
+	void Link(int32 EntryIdx);
+	void Unlink(int32 EntryIdx);
+	void Release(int32 EntryIdx);
+	//Moves every entry of Slot back through Link, which puts them on a lower level
+	void Cascade(int32 Level);
+	void Advance(uint64 TargetTick);
+	/** Brings CurrentTick to NowTick when Advance can't
+	  * An empty wheel just jumps, so a quiet period never has to be walked tick by tick. If world time
+	  * went backwards every active cooldown keeps its remaining time.
+	  */
+	void SyncToWorldTime(uint64 NowTick);
+	static uint64 GetWorldTick(const UWorld& World);
+};
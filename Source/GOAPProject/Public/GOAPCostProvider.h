@@ -0,0 +1,56 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WorldProperty.h"
+
+#include "GOAPCostProvider.generated.h"
+
+class AAIController;
+class UGOAPAction;
+struct FWorldState;
+
+/** Dynamic action cost
+  * The planner snapshots every action's cost once per search on the game thread, so CalcCost can
+  * touch game code freely. Costs are reused across searches until one of DependencyKeys changes.
+  */
+UCLASS(abstract, EditInlineNew)
+class GOAPPROJECT_API UGOAPCostProvider : public UObject
+{
+	GENERATED_BODY()
+
+protected:
+	//World state keys the cost depends on
+	UPROPERTY(EditAnywhere)
+		TArray<EWorldKey> DependencyKeys;
+
+	//Re-evaluate every search instead of waiting for DependencyKeys to change
+	UPROPERTY(EditAnywhere)
+		bool bAlwaysRefresh = false;
+
+public:
+	UGOAPCostProvider(const FObjectInitializer& ObjectInitializer);
+
+	//AIOwner is null when the action isn't owned by an agent, e.g. in the benchmark commandlets
+	virtual int32 CalcCost(AAIController* AIOwner, const FWorldState& WS, int32 BaseCost) const { return BaseCost; }
+
+	const TArray<EWorldKey>& GetDependencyKeys() const { return DependencyKeys; }
+	bool ShouldAlwaysRefresh() const { return bAlwaysRefresh; }
+};
+
+//Adds a cost per DistancePerCost units between the pawn and a blackboard actor or location
+UCLASS()
+class GOAPPROJECT_API UGOAPCost_BBDistance : public UGOAPCostProvider
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere)
+		FName BBTargetName;
+
+	UPROPERTY(EditAnywhere)
+		float DistancePerCost = 500.f;
+
+public:
+	UGOAPCost_BBDistance(const FObjectInitializer& ObjectInitializer);
+
+	virtual int32 CalcCost(AAIController* AIOwner, const FWorldState& WS, int32 BaseCost) const override;
+};
@@ -9,6 +9,19 @@
 class AAIController;
 class UPlannerComponent;
 struct FWorldState;
+struct FWorldStateSnapshot;
+
+DECLARE_LOG_CATEGORY_EXTERN(LogDecorator, Warning, All);
+
+//Events that can change a decorator's result. The planner component subscribes to these for it
+struct GOAPPROJECT_API FDecoratorInvalidation
+{
+	TArray<FName> BBKeys;
+	TArray<FGameplayTag> Tags;
+	bool bPerception = false;
+	//Reads WS. The result is kept until the published world state gets a new version
+	bool bWorldState = false;
+};
 
 UCLASS(abstract, EditInlineNew)
 class GOAPPROJECT_API UGOAPDecorator : public UObject
@@ -20,6 +33,33 @@ public:
 
 	virtual bool CalcRawConditionValue(AAIController& AIOwner, const FWorldState& WS) { return false; } //default behavior
 	virtual void OnTaskDeactivated(UPlannerComponent& OwnerComp) {}
+
+	/** Returns true if the result can be cached until one of the events in OutInvalidation happens
+	  * Decorators that can't describe what changes their result are evaluated every time
+	  */
+	virtual bool DescribeInvalidation(FDecoratorInvalidation& OutInvalidation) const { return false; }
+
+	//Cached CalcRawConditionValue, run against the agent's published world state
+	bool GetConditionValue(AAIController& AIOwner, const FWorldStateSnapshot& Snapshot);
+	void Invalidate() { bHasCachedValue = false; }
+
+	//Called by the planner component that owns the goal
+	void SetOwner(UPlannerComponent& OwnerComponent);
+
+protected:
+	UPROPERTY(transient)
+		UPlannerComponent* OwnerPlanner = nullptr;
+
+	//Time based results (stimulus ages, cooldowns) call this from CalcRawConditionValue
+	void InvalidateAt(float Time) { CacheExpireTime = Time; }
+
+private:
+	bool bCanCache = false;
+	bool bCacheOnWSVersion = false;
+	bool bHasCachedValue = false;
+	bool bCachedValue = false;
+	float CacheExpireTime = 0.f;
+	uint32 CachedWSVersion = 0;
 };
 
 UCLASS()
@@ -36,6 +76,7 @@ public:
 	UGOAPDec_ShouldFlushOut(const FObjectInitializer& ObjectInitializer);
 
 	virtual bool CalcRawConditionValue(AAIController& AIOwner, const FWorldState& WS) override;
+	virtual bool DescribeInvalidation(FDecoratorInvalidation& OutInvalidation) const override;
 };
 
 UCLASS()
@@ -53,6 +94,7 @@ public:
 	UGOAPDec_IsKeyOfType(const FObjectInitializer& ObjectInitializer);
 
 	virtual bool CalcRawConditionValue(AAIController& AIOwner, const FWorldState& WS) override;
+	virtual bool DescribeInvalidation(FDecoratorInvalidation& OutInvalidation) const override;
 };
 
 UCLASS()
@@ -66,6 +108,7 @@ public:
 	UGOAPDec_DamagedSince(const FObjectInitializer& ObjectInitializer);
 
 	virtual bool CalcRawConditionValue(AAIController& AIOwner, const FWorldState& WS) override;
+	virtual bool DescribeInvalidation(FDecoratorInvalidation& OutInvalidation) const override;
 };
 
 UCLASS()
@@ -81,6 +124,7 @@ class GOAPPROJECT_API UGOAPDec_TagCooldown : public UGOAPDecorator
 public:
 	UGOAPDec_TagCooldown(const FObjectInitializer& ObjectInitializer);
 	virtual bool CalcRawConditionValue(AAIController& AIOwner, const FWorldState& WS) override;
+	virtual bool DescribeInvalidation(FDecoratorInvalidation& OutInvalidation) const override;
 
 	virtual void OnTaskDeactivated(UPlannerComponent& OwnerComp) override;
 };
\ No newline at end of file
@@ -7,12 +7,49 @@
 
 class UGOAPAction;
 class UGOAPDecorator;
+class UCurveFloat;
 struct FWorldState;
+struct FWorldStateSnapshot;
 class AAIController;
 class UPlannerComponent;
 
 DECLARE_LOG_CATEGORY_EXTERN(LogGoal, Warning, All);
 
+UENUM()
+enum class EInsistenceInput : uint8
+{
+	//Float or int blackboard key
+	BBValue,
+	//Distance from the pawn to a blackboard actor or vector
+	BBDistance,
+	WSKey,
+	//Seconds since this goal's last plan finished
+	TimeSinceFinished,
+	MAX UMETA(Hidden)
+};
+
+//Curve(Input) * Weight, evaluated in batch by UGOAPInsistenceSubsystem
+USTRUCT()
+struct GOAPPROJECT_API FInsistenceTerm
+{
+	GENERATED_BODY()
+public:
+	UPROPERTY(EditAnywhere)
+		UCurveFloat* Curve = nullptr;
+
+	UPROPERTY(EditAnywhere)
+		EInsistenceInput Input = EInsistenceInput::BBValue;
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "Input == EInsistenceInput::BBValue || Input == EInsistenceInput::BBDistance"))
+		FName BBKeyName = NAME_None;
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "Input == EInsistenceInput::WSKey"))
+		EWorldKey WSKey = EWorldKey::SYMBOL_MAX;
+
+	UPROPERTY(EditAnywhere)
+		float Weight = 1.f;
+};
+
 
 //TODO: add Decorators
 UCLASS(Config=AI, EditInlineNew, BlueprintType)
@@ -52,11 +89,21 @@ protected:
 	//cached Owner Component
 	UPROPERTY(transient)
 		UPlannerComponent* OwnerComp;
-	//constant for now
-	//TODO: use response curve
+	//Constant unless InsistenceTerms are set, then it's the sum of the terms
 	UPROPERTY(EditAnywhere)
 		float Insistence = 1.0;
 
+	UPROPERTY(EditAnywhere)
+		TArray<FInsistenceTerm> InsistenceTerms;
+
+	//How many members of a squad can pursue this goal at once, 0 for any number.
+	//Members past the limit fall through to their next goal, which is how squads split into roles
+	UPROPERTY(EditAnywhere)
+		int32 MaxSquadAssignees = 0;
+
+	UPROPERTY(transient)
+		float LastFinishedTime = 0.f;
+
 	UPROPERTY()
 		bool bCachedValidity;
 
@@ -65,15 +112,26 @@ protected:
 public:
 	UGOAPGoal();
 	const TArray<FWorldProperty>& GetGoalCondition() const { return GoalCondition;  }
+	const TArray<FWorldProperty>& GetPreconditions() const { return Preconditions; }
 	TArray<UGOAPAction*> GetSubTasks() const { return SubTasks; }
+	const TArray<UGOAPDecorator*>& GetDecorators() const { return Decorators; }
 	FString GetTaskName() { return TaskName;  }
 
 	bool IsValid() const { return bCachedValidity; }
-	virtual bool ValidateContextPreconditions(const FWorldState& WS) const;
+	int32 GetMaxSquadAssignees() const { return MaxSquadAssignees; }
+	//Decorators see the world state as last published so they can cache on its version
+	virtual bool ValidateContextPreconditions(const FWorldStateSnapshot& Snapshot) const;
 
 	virtual void OnPlanFinished();
 	TArray<FAISymEffect> GetEffects() { return Effects; }
 	void SetOwner(AAIController& Controller, UPlannerComponent& OwnerComponent);
-	void OnWSUpdated(const FWorldState& WorldState);
+	//Returns true if the goal's validity changed
+	bool OnWSUpdated(const FWorldState& WorldState);
+	//For validity computed elsewhere (UGOAPPlannerSubsystem), returns true if it changed
+	bool SetValidity(bool bValid);
 	float GetInsistence() const;
+	const TArray<FInsistenceTerm>& GetInsistenceTerms() const { return InsistenceTerms; }
+	float GetLastFinishedTime() const { return LastFinishedTime; }
+	//Notifies the owning planner so its goal queue stays sorted
+	void SetInsistence(float NewInsistence);
 };
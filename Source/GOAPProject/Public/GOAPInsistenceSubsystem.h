@@ -0,0 +1,116 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "BehaviorTree/BehaviorTreeTypes.h"
+#include "WorldProperty.h"
+#include "GOAPInsistenceSubsystem.generated.h"
+
+class UCurveFloat;
+class UGOAPGoal;
+class UPlannerComponent;
+struct FInsistenceTerm;
+struct FWorldState;
+
+/** Evaluates every registered agent's goal insistence curves in one pass
+  * Every GOAP.InsistenceInterval seconds the inputs of all FInsistenceTerms are gathered into flat
+  * arrays, run through baked lookup tables of the curves and the sums are pushed to the goals with
+  * SetInsistence, which keeps each planner's goal queue sorted.
+  */
+UCLASS()
+class GOAPPROJECT_API UGOAPInsistenceSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+public:
+	static UGOAPInsistenceSubsystem* Get(const UObject* WorldContextObject);
+
+	//Bakes the planner's terms, call again if its goals change
+	void RegisterPlanner(UPlannerComponent& Planner);
+	void UnregisterPlanner(UPlannerComponent& Planner);
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	//Only ticked by our own world, editor preview worlds included
+	virtual bool IsTickableInEditor() const override { return true; }
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+
+	//Runs the batch right away, Tick calls this on the interval
+	void UpdateInsistence();
+
+private:
+	static constexpr int32 NumCurveSamples = 32;
+
+	//Curve resampled over its time range, inputs outside the range clamp to the ends
+	struct FBakedCurve
+	{
+		float MinTime = 0.f;
+		float InvStep = 0.f;
+		float Samples[NumCurveSamples];
+	};
+
+	//Where a term's input comes from, with the blackboard key's type already checked
+	enum class EBakedInput : uint8
+	{
+		None,
+		WSKey,
+		TimeSinceFinished,
+		BBInt,
+		BBFloat,
+		BBBool,
+		BBObjectDistance,
+		BBLocationDistance
+	};
+
+	//A term with its curve and blackboard key resolved when its planner registers
+	struct FBakedTerm
+	{
+		EBakedInput Input = EBakedInput::None;
+		EWorldKey WSKey = EWorldKey::SYMBOL_MAX;
+		FBlackboard::FKey KeyID = FBlackboard::InvalidKey;
+		int32 CurveIdx = INDEX_NONE;
+		float Weight = 0.f;
+		//Into FRegisteredPlanner::Goals
+		int32 GoalIdx = INDEX_NONE;
+	};
+
+	struct FRegisteredPlanner
+	{
+		TWeakObjectPtr<UPlannerComponent> Planner;
+		//Goals with at least one term, owned by the planner
+		TArray<TWeakObjectPtr<UGOAPGoal>> Goals;
+		TArray<FBakedTerm> Terms;
+	};
+	TArray<FRegisteredPlanner> Planners;
+
+	//Curves are baked the first time a term uses them. Weak keys, so a new curve that gets the
+	//address of a collected one is baked again instead of resolving to the old samples
+	TMap<TWeakObjectPtr<const UCurveFloat>, int32> CurveIndices;
+	TArray<FBakedCurve> BakedCurves;
+	//Edited since they were baked, baked again in place at the start of the next update
+	TArray<TWeakObjectPtr<const UCurveFloat>> DirtyCurves;
+#if WITH_EDITOR
+	void OnObjectModified(UObject* Object);
+#endif
+
+	//Batch arrays, one entry per term. Kept between updates so they don't reallocate
+	TArray<float> TermInputs;
+	TArray<int32> TermCurves;
+	TArray<float> TermWeights;
+	TArray<int32> TermGoals;
+	TArray<float> TermValues;
+	//One entry per goal with terms
+	TArray<UGOAPGoal*> BatchGoals;
+	TArray<float> GoalInsistence;
+
+	float TimeUntilUpdate = 0.f;
+
+	int32 FindOrBakeCurve(const UCurveFloat& Curve);
+	static void BakeCurve(const UCurveFloat& Curve, FBakedCurve& OutBaked);
+	FBakedTerm BakeTerm(const FInsistenceTerm& Term, const UPlannerComponent& Planner);
+	float GatherInput(const FBakedTerm& Term, const UPlannerComponent& Planner, const FWorldState& WS, const UGOAPGoal& Goal, float Now) const;
+};
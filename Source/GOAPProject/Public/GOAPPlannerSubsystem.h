@@ -0,0 +1,232 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Containers/Queue.h"
+#include "WorldState.h"
+#include "WorldProperty.h"
+#include "WorldStateSnapshot.h"
+#include "PlannerComponent.h"
+#include "GOAPPlannerSubsystem.generated.h"
+
+class UGOAPGoal;
+
+namespace EPlannerAgentFlags
+{
+	enum Type : uint8
+	{
+		Running = 1 << 0,
+		HasPlan = 1 << 1,
+		//The plan's head has started, expected effects only count while this is set
+		HasCurrentAction = 1 << 2,
+		GoalsDirty = 1 << 3,
+		ReplanNeeded = 1 << 4,
+		PlanUpdateNeeded = 1 << 5,
+		//Set by the batch when a goal's validity flipped
+		GoalsChanged = 1 << 6,
+	};
+}
+
+//Goal preconditions copied out of the goal so validation never touches the UObject
+struct GOAPPROJECT_API FBatchedGoal
+{
+	UGOAPGoal* Goal = nullptr;
+	TArray<FWorldProperty, TInlineAllocator<4>> Preconditions;
+	bool bValid = false;
+	bool bChanged = false;
+};
+
+/** World state shared by a squad
+  * Members see SharedKeys from here unless they overrode the key (OverrideSquadKey, it goes in
+  * their LocalKeys). Their own writes to a shared key, action effects included, go to the squad.
+  * A write bumps Version and members pick it up in the next RunPasses as dirty keys, so it's one
+  * write and at most one replan per member.
+  */
+struct GOAPPROJECT_API FSquadWorldState
+{
+	FWorldState WS;
+	uint32 SharedKeys = 0;
+	uint32 Version = 0;
+	int32 NumMembers = 0;
+	bool bInUse = false;
+};
+
+/** Hot planner state of every agent, the same index in every array
+  * RunPasses does the per frame checks of all agents in contiguous chunks on the task graph and
+  * only leaves flags behind, UGOAPPlannerSubsystem then does the UObject work for the agents that
+  * need it. Also used without a subsystem by GOAP.Benchmark.Agents.
+  */
+struct GOAPPROJECT_API FPlannerAgentBatch
+{
+	static constexpr int32 AgentsPerChunk = 64;
+
+	TArray<FWorldState> WorldStates;
+	//Keys written with SetWSProp since the last pass, one bit per EWorldKey
+	TArray<uint32> DirtyKeys;
+	//Keys the current action and the current goal expect to change, and the values they expect
+	TArray<uint32> ActionExpectedKeys;
+	TArray<FWorldState> ActionExpectedValues;
+	TArray<uint32> GoalExpectedKeys;
+	TArray<FWorldState> GoalExpectedValues;
+	//EPlannerAgentFlags
+	TArray<uint8> Flags;
+	TArray<EReplanCause> ReplanCauses;
+	//Agent i owns GoalCounts[i] entries of Goals starting at GoalStarts[i]
+	TArray<int32> GoalStarts;
+	TArray<int32> GoalCounts;
+	TArray<FBatchedGoal> Goals;
+	//INDEX_NONE if not in a squad
+	TArray<int32> SquadIndices;
+	//Shared keys the agent overrode and no longer takes from the squad
+	TArray<uint32> LocalKeys;
+	//Squad version the agent's world state was last synced to
+	TArray<uint32> SquadVersions;
+	//Not per agent, free slots have bInUse false
+	TArray<FSquadWorldState> Squads;
+	//WorldStates as of the last PublishSnapshots, for readers off the game thread. Stores don't move when agents do
+	TArray<FWorldStateSnapshotStoreRef> Snapshots;
+	//Bumped by every PublishSnapshots
+	uint32 PublishEpoch = 0;
+
+	int32 Num() const { return Flags.Num(); }
+	SIZE_T GetAllocatedSize() const;
+	int32 Add();
+	void RemoveAtSwap(int32 AgentIdx);
+	void SetGoals(int32 AgentIdx, TArray<FBatchedGoal>& InGoals);
+
+	FORCEINLINE bool HasFlag(int32 AgentIdx, uint8 Flag) const { return (Flags[AgentIdx] & Flag) != 0; }
+	FORCEINLINE void SetFlag(int32 AgentIdx, uint8 Flag, bool bSet)
+	{
+		Flags[AgentIdx] = bSet ? (Flags[AgentIdx] | Flag) : (Flags[AgentIdx] & ~Flag);
+	}
+	FORCEINLINE void MarkDirty(int32 AgentIdx, EWorldKey Key) { DirtyKeys[AgentIdx] |= 1u << (uint32)Key; }
+
+	void AddExpected(int32 AgentIdx, bool bGoal, EWorldKey Key, uint8 Value);
+	void ClearExpected(int32 AgentIdx, bool bAction, bool bGoal);
+
+	int32 CreateSquad(uint32 SharedKeys, const FWorldState& InitialWS);
+	//Members keep the values they had and carry on on their own
+	void DestroySquad(int32 SquadIdx);
+	//Drops any local copies, the agent takes every shared key from the squad right away
+	void JoinSquad(int32 AgentIdx, int32 SquadIdx);
+	void LeaveSquad(int32 AgentIdx);
+	void SetSquadProp(int32 SquadIdx, EWorldKey Key, uint8 Value);
+	bool IsSharedKey(int32 AgentIdx, EWorldKey Key) const;
+	//Called after the agent's own writes, sends its value of a shared key to the squad unless it overrode the key
+	void WriteSharedKey(int32 AgentIdx, EWorldKey Key);
+	//The agent's own effect, see WriteSharedKey. False if it didn't apply
+	bool ApplyEffect(int32 AgentIdx, const FAISymEffect& Effect);
+	//The agent keeps its own value of a shared key and stops taking squad writes to it
+	void OverrideSquadKey(int32 AgentIdx, EWorldKey Key);
+	//Takes the key from the squad again
+	void RevertSquadKey(int32 AgentIdx, EWorldKey Key);
+
+	//Squad syncs, expected effect checks, then goal validation for every agent with a changed world state
+	void RunPasses(bool bForceSingleThread = false);
+	//Copies every changed world state into its agent's snapshot store. Returns how many were published
+	int32 PublishSnapshots();
+
+private:
+	void SyncSquad(int32 AgentIdx);
+	void CheckExpectedEffects(int32 AgentIdx);
+	void ValidateGoals(int32 AgentIdx);
+};
+
+//World state write posted from any thread, see UGOAPPlannerSubsystem::PostWSProp
+struct GOAPPROJECT_API FPostedWSWrite
+{
+	TWeakObjectPtr<UPlannerComponent> Agent;
+	EWorldKey Key = EWorldKey::SYMBOL_MAX;
+	uint8 Value = 0;
+};
+
+/** Owns the world state, expected effects and scheduling flags of every running planner in its world
+  * UPlannerComponent is a handle into Agents. Each frame the checks that used to run in every
+  * component's tick are done for all agents at once, then only the agents that have to replan or
+  * advance their plan are visited. Every world has its own batch, so PIE clients, game worlds and
+  * editor preview worlds never share agents.
+  */
+UCLASS()
+class GOAPPROJECT_API UGOAPPlannerSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+public:
+	//The subsystem of WorldContextObject's world, null without a world
+	static UGOAPPlannerSubsystem* Get(const UObject* WorldContextObject);
+
+	int32 RegisterAgent(UPlannerComponent& Planner);
+	void UnregisterAgent(int32 AgentIdx);
+	void SetAgentGoals(int32 AgentIdx, const TArray<UGOAPGoal*>& InGoals);
+
+	//Squad IDs are slots and get reused once a squad is destroyed
+	UFUNCTION(BlueprintCallable)
+		int32 CreateSquad(const TArray<EWorldKey>& SharedKeys);
+	UFUNCTION(BlueprintCallable)
+		void DestroySquad(int32 SquadId);
+	//One write for the whole squad, members that overrode the key locally don't see it
+	UFUNCTION(BlueprintCallable)
+		void SetSquadWSProp(int32 SquadId, EWorldKey Key, uint8 Value);
+
+	/** Safe to call from any thread, for perception and async trace results
+	  * Writes are queued without locking and applied with SetWSProp at the start of the next Tick,
+	  * before the batch passes and any replan decisions. If an agent's key is posted more than once
+	  * in a frame, only the last write is applied.
+	  */
+	void PostWSProp(UPlannerComponent* Agent, EWorldKey Key, uint8 Value);
+
+	//A bound blackboard key changed, the agent's bindings are synced once, right after the posted writes
+	void RequestBindingSync(UPlannerComponent& Agent);
+
+	/** Snapshots are published once per frame, at the end of Tick after plan updates and replans
+	  * Game thread code in between sees the live world state, snapshot readers see every agent as it
+	  * was at the end of the same frame. The epoch counts publishes.
+	  */
+	uint32 GetPublishEpoch() const { return Agents.PublishEpoch; }
+
+	//Planners report every search they run from Tick, the largest fringe is published as the frame's Fringe Peak
+	void AddSearchStats(const FPlannerSearchStats& Stats);
+
+	FPlannerAgentBatch& GetAgents() { return Agents; }
+	const FPlannerAgentBatch& GetAgents() const { return Agents; }
+
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	//Only ticked by our own world, editor preview worlds included
+	virtual bool IsTickableInEditor() const override { return true; }
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+
+private:
+	FPlannerAgentBatch Agents;
+	TArray<TWeakObjectPtr<UPlannerComponent>> Owners;
+
+	//Agents can be unregistered by the planners we call into, those are removed after the loop
+	bool bUpdatingAgents = false;
+	TArray<int32> PendingRemovals;
+	//Squad members that need to replan this frame
+	TArray<int32> SquadReplans;
+	//Contexts of the squads in SquadReplans, by squad index
+	TMap<int32, FSquadPlanContext> SquadContexts;
+	//Largest fringe of the searches run this frame, game thread only
+	int32 FrameFringePeak = 0;
+
+	//Producers are any thread, the game thread is the only consumer
+	TQueue<FPostedWSWrite, EQueueMode::Mpsc> PostedWrites;
+	//Last posted value of every key written this frame, indexed like Agents
+	TArray<uint32> PostedKeys;
+	TArray<FWorldState> PostedValues;
+	TArray<int32> PostedAgents;
+	void ApplyPostedWrites();
+
+	//Agents with dirty blackboard bindings, each at most once
+	TArray<TWeakObjectPtr<UPlannerComponent>> BindingSyncs;
+	void ApplyBindingSyncs();
+
+	void RemoveAgent(int32 AgentIdx);
+	void ApplyGoalChanges(int32 AgentIdx, UPlannerComponent& Planner);
+	//Replans squad members after everyone else so they can share plans and respect role limits
+	void ProcessSquadReplans();
+};
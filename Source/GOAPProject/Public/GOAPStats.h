@@ -0,0 +1,39 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+//"stat GOAP" in game, and the GOAP category in CSV profiler captures
+DECLARE_STATS_GROUP(TEXT("GOAP"), STATGROUP_GOAP, STATCAT_Advanced);
+//Timers inside the search loops, off unless "stat group enable GOAPVerbose" since they cost about as much as what they time
+DECLARE_STATS_GROUP_VERBOSE(TEXT("GOAP Verbose"), STATGROUP_GOAPVerbose, STATCAT_Advanced);
+
+//Timers
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Search"), STAT_GOAP_Search, STATGROUP_GOAP, GOAPPROJECT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Successor Generation"), STAT_GOAP_Successors, STATGROUP_GOAPVerbose, GOAPPROJECT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ChainBackward"), STAT_GOAP_ChainBackward, STATGROUP_GOAPVerbose, GOAPPROJECT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Process Replan Request"), STAT_GOAP_ProcessReplan, STATGROUP_GOAP, GOAPPROJECT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Plan Execution"), STAT_GOAP_UpdatePlanExecution, STATGROUP_GOAP, GOAPPROJECT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Service Tick"), STAT_GOAP_ServiceTick, STATGROUP_GOAP, GOAPPROJECT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Goal Validation"), STAT_GOAP_GoalValidation, STATGROUP_GOAP, GOAPPROJECT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Agent Batch"), STAT_GOAP_AgentBatch, STATGROUP_GOAP, GOAPPROJECT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Insistence Update"), STAT_GOAP_InsistenceUpdate, STATGROUP_GOAP, GOAPPROJECT_API);
+
+//Counters, reset every frame
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Nodes Expanded"), STAT_GOAP_NodesExpanded, STATGROUP_GOAP, GOAPPROJECT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Nodes Generated"), STAT_GOAP_NodesGenerated, STATGROUP_GOAP, GOAPPROJECT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Duplicate Hits"), STAT_GOAP_DuplicateHits, STATGROUP_GOAP, GOAPPROJECT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Reparents"), STAT_GOAP_Reparents, STATGROUP_GOAP, GOAPPROJECT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Mutex Prunes"), STAT_GOAP_MutexPrunes, STATGROUP_GOAP, GOAPPROJECT_API);
+//Largest open list of a planner search this frame, set by the planner subsystem
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Fringe Peak"), STAT_GOAP_FringePeak, STATGROUP_GOAP, GOAPPROJECT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Replans"), STAT_GOAP_Replans, STATGROUP_GOAP, GOAPPROJECT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Squad Shared Plans"), STAT_GOAP_SquadSharedPlans, STATGROUP_GOAP, GOAPPROJECT_API);
+//Searches run by squad members replanning together, compare with Squad Shared Plans
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Squad Searches"), STAT_GOAP_SquadSearches, STATGROUP_GOAP, GOAPPROJECT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Posted WS Writes"), STAT_GOAP_PostedWrites, STATGROUP_GOAP, GOAPPROJECT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Blackboard Binding Syncs"), STAT_GOAP_BindingSyncs, STATGROUP_GOAP, GOAPPROJECT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Published WS Snapshots"), STAT_GOAP_PublishedSnapshots, STATGROUP_GOAP, GOAPPROJECT_API);
+
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(GOAPPROJECT_API, GOAP);
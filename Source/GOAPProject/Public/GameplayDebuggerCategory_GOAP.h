@@ -7,6 +7,7 @@
 
 class AActor;
 class APlayerController;
+class UPlannerComponent;
 
 class FGameplayDebuggerCategory_GOAP : public FGameplayDebuggerCategory
 {
@@ -14,7 +15,34 @@ public:
 	FGameplayDebuggerCategory_GOAP();
 
 	virtual void CollectData(APlayerController* OwnerPC, AActor* DebugActor) override;
+	virtual void DrawData(APlayerController* OwnerPC, FGameplayDebuggerCanvasContext& CanvasContext) override;
 
 	static TSharedRef<FGameplayDebuggerCategory> MakeInstance();
+
+protected:
+	//Only numbers and short names go over the wire, text is built in DrawData
+	struct FRepData
+	{
+		FString PlannerName;
+		FString GoalName;
+		TArray<FString> PlanSteps;
+		int32 CurrentStep = INDEX_NONE;
+		//Indexed by EWorldKey, see UPlannerComponent::DescribeWSValue
+		TArray<FString> WorldStateValues;
+
+		float MeanSearchMs = 0.f;
+		float MaxSearchMs = 0.f;
+		int32 LastNodesExpanded = 0;
+		int32 ReplanCount = 0;
+		TArray<int32> ReplanCauses;
+		float DuplicateRate = 0.f;
+		float CacheHitRate = 0.f;
+		float TimeSinceReplan = -1.f;
+
+		void Serialize(FArchive& Ar);
+	};
+	FRepData DataPack;
+
+	static UPlannerComponent* FindPlannerComponent(AActor* DebugActor);
 };
-#endif // WITH_GAMEPLAY_DEBUGGER
\ No newline at end of file
+#endif // WITH_GAMEPLAY_DEBUGGER
@@ -2,6 +2,7 @@
 
 #include "CoreMinimal.h"
 #include "WorldProperty.h"
+#include "PlannerDomain.h"
 #include "PlannerAsset.generated.h"
 
 class UGOAPAction;
@@ -36,6 +37,47 @@ public:
 		uint8 Value;
 };
 
+UENUM()
+enum class EBBBindingMode : uint8
+{
+	//SetValue while the key is set (object not null, valid vector, true bool...), otherwise UnsetValue
+	IsSet,
+	//Bool, Int, Float and Enum keys, clamped to what the world state key can hold
+	CopyValue,
+	MAX UMETA(Hidden)
+};
+
+//Which planner searches for the agents running the asset
+UENUM()
+enum class EPlannerSearchType : uint8
+{
+	//FAStarPlanner over the asset's actions
+	Runtime,
+	//TStaticPlanner<FShooterPlannerSchema>. Every action has to match a schema action of the same name,
+	//goals comparing two keys still go through FAStarPlanner
+	NativeShooter,
+	MAX UMETA(Hidden)
+};
+
+//Keeps a world state key in sync with a blackboard key through a blackboard observer, no service needed
+USTRUCT()
+struct GOAPPROJECT_API FWSBlackboardBinding
+{
+	GENERATED_BODY()
+public:
+	UPROPERTY(EditAnywhere)
+		FName BBKeyName = NAME_None;
+	UPROPERTY(EditAnywhere)
+		EWorldKey WSKey = EWorldKey::SYMBOL_MAX;
+	UPROPERTY(EditAnywhere)
+		EBBBindingMode Mode = EBBBindingMode::IsSet;
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "Mode == EBBBindingMode::IsSet"))
+		uint8 SetValue = 1;
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "Mode == EBBBindingMode::IsSet"))
+		uint8 UnsetValue = 0;
+};
+
 UCLASS(BlueprintType, Blueprintable)
 class GOAPPROJECT_API UPlannerAsset : public UObject
 {
@@ -48,6 +90,11 @@ protected:
 	UPROPERTY(EditDefaultsOnly)
 		TArray<FWSKeyConfig> WSKeyDefaults;
 
+	//Applied after WSKeyDefaults when the planner starts, then batched into one update per
+	//planner subsystem tick whenever the blackboard keys change
+	UPROPERTY(EditDefaultsOnly)
+		TArray<FWSBlackboardBinding> BlackboardBindings;
+
 	UPROPERTY(EditDefaultsOnly, Instanced)
 		TArray<UGOAPAction*> Actions;
 
@@ -59,5 +106,29 @@ protected:
 	//Ring buffer for running tasks only needs to be max plan size + 1 (for cancelling actions)
 	UPROPERTY(EditDefaultsOnly)
 		uint32 MaxPlanSize = 5;
+
+	UPROPERTY(EditDefaultsOnly)
+		EPlannerSearchType SearchType = EPlannerSearchType::Runtime;
+
+	//Built the first time an agent starts with this asset, cleared by edits
+	FCompiledPlannerDomain CompiledDomain;
+public:
+	//Per goal action slices, compiled on first use. Game thread only
+	const FCompiledPlannerDomain& GetCompiledDomain();
+
+	//Defaults, Eq conditions and Set effects whose value doesn't fit the key (FWorldStateLayout::KeyBits).
+	//Those would be silently truncated by FWorldState::SetProp
+	bool ValidateWorldStateValues(TArray<FText>& OutErrors) const;
+	//Actions that don't match the native schema picked by SearchType. Planners fall back to FAStarPlanner if there are any
+	bool ValidateSearchType(TArray<FText>& OutErrors) const;
+	EPlannerSearchType GetSearchType() const { return SearchType; }
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+	virtual EDataValidationResult IsDataValid(TArray<FText>& ValidationErrors) override;
+#endif
+protected:
 	friend class UPlannerComponent;
+	friend class UPlannerAssetBenchmarkCommandlet;
+	friend class UPlannerMacroMiningCommandlet;
 };
\ No newline at end of file
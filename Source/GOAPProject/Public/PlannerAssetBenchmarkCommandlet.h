@@ -0,0 +1,22 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PlannerAssetBenchmarkCommandlet.generated.h"
+
+/** Solves every goal of every UPlannerAsset in the project without spawning controllers
+  * -run=PlannerAssetBenchmark [-samples=N] [-seed=S] [-json=<out.json>] [-maxms=<budget>] [-noslice] [-nolandmarks] [-nomutexes] -nullrhi
+  * Sample 0 is the asset's WSKeyDefaults, the rest randomize the keys the asset's actions and goals touch.
+  * Searches use the asset's compiled domain (slices, landmarks, mutexes), the -no flags turn each part off
+  * so the expanded node counts can be compared.
+  * Returns non-zero if any asset's worst search is over -maxms so it can gate asset changes on a build box.
+  */
+UCLASS()
+class GOAPPROJECT_API UPlannerAssetBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+public:
+	UPlannerAssetBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,193 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WorldProperty.h"
+#include "WorldState.h"
+#include "GOAPAction.h"
+#include "PlannerBenchmark.generated.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogPlannerBenchmark, Log, All);
+
+/** Knobs for the generated domain
+  * The solution is a chain of increments on kAtLocation (always used, whatever NumKeys is), so
+  * SolutionDepth is the number of steps in the cheapest plan. BranchingFactor actions can advance
+  * the chain from every node and the rest of the actions are distractors on the boolean keys.
+  */
+USTRUCT(BlueprintType)
+struct GOAPPROJECT_API FSyntheticDomainParams
+{
+	GENERATED_BODY()
+public:
+	//Clamped to EWorldKey::SYMBOL_MAX
+	UPROPERTY(EditAnywhere)
+		int32 NumKeys = 8;
+
+	UPROPERTY(EditAnywhere)
+		int32 NumActions = 16;
+
+	UPROPERTY(EditAnywhere)
+		int32 BranchingFactor = 4;
+
+	UPROPERTY(EditAnywhere)
+		int32 SolutionDepth = 4;
+
+	UPROPERTY(EditAnywhere)
+		int32 NumSearches = 200;
+
+	UPROPERTY(EditAnywhere)
+		int32 Seed = 1234;
+};
+
+struct GOAPPROJECT_API FPlannerBenchmarkResult
+{
+	FSyntheticDomainParams Params;
+	int32 NumSolved = 0;
+	int64 TotalNodesExpanded = 0;
+	double NodesExpandedPerSecond = 0.0;
+	//FPlannerSearchStats::NodesAllocated, every node costs a handful of heap blocks (see FStateNode::GetAllocatedSize)
+	double NodesAllocatedPerSearch = 0.0;
+	//Largest FPlannerSearchStats::PeakBytes of a single search
+	int64 PeakBytes = 0;
+	double MeanMs = 0.0;
+	double P50Ms = 0.0;
+	double P99Ms = 0.0;
+
+	TSharedRef<class FJsonObject> ToJsonObject() const;
+	FString ToJson() const;
+};
+
+//Cost of one frame of FPlannerAgentBatch::RunPasses for a given number of agents
+struct GOAPPROJECT_API FAgentBatchBenchmarkResult
+{
+	int32 NumAgents = 0;
+	int32 NumFrames = 0;
+	int32 GoalsPerAgent = 0;
+	//Fraction of agents that get a world state write every frame
+	float WriteRate = 0.f;
+	double MeanMs = 0.0;
+	double P99Ms = 0.0;
+	//Same frames with ParallelFor forced onto the game thread
+	double SingleThreadMeanMs = 0.0;
+	double ReplansPerFrame = 0.0;
+
+	TSharedRef<class FJsonObject> ToJsonObject() const;
+};
+
+//Shared squad facts written once through FSquadWorldState versus into every member
+struct GOAPPROJECT_API FSquadBenchmarkResult
+{
+	int32 NumAgents = 0;
+	int32 SquadSize = 0;
+	int32 NumFrames = 0;
+	//Mean per frame, writes plus RunPasses
+	double SharedMs = 0.0;
+	double PerAgentMs = 0.0;
+	//Mean per frame, the writes alone
+	double SharedWriteMs = 0.0;
+	double PerAgentWriteMs = 0.0;
+	int64 SharedWrites = 0;
+	int64 PerAgentWrites = 0;
+	double SharedReplansPerFrame = 0.0;
+	double PerAgentReplansPerFrame = 0.0;
+	//FPlannerAgentBatch::GetAllocatedSize
+	int64 SharedBytes = 0;
+	int64 PerAgentBytes = 0;
+
+	TSharedRef<class FJsonObject> ToJsonObject() const;
+};
+
+//A squad replanning on one event, members sharing plans through FSquadPlanContext versus every member searching
+struct GOAPPROJECT_API FSquadReplanBenchmarkResult
+{
+	int32 SquadSize = 0;
+	int32 NumEvents = 0;
+	//Chance for each start state key of a member to differ from the squad's
+	float DivergenceRate = 0.f;
+	//Mean per event, for the whole squad
+	double SharedMs = 0.0;
+	double PerAgentMs = 0.0;
+	int64 SharedSearches = 0;
+	int64 PerAgentSearches = 0;
+	//Members whose shared plan costs something else than their own search's plan. Plans are only
+	//shared between identical searches, so anything but 0 is a bug
+	int32 NumCostMismatches = 0;
+
+	TSharedRef<class FJsonObject> ToJsonObject() const;
+};
+
+//TStaticPlanner<FShooterPlannerSchema> against FAStarPlanner on the same searches
+struct GOAPPROJECT_API FStaticPlannerBenchmarkResult
+{
+	int32 NumSearches = 0;
+	int32 NumSolved = 0;
+	//Searches where the two planners disagree on whether there is a plan or on its cost
+	int32 NumMismatches = 0;
+	double StaticMeanMs = 0.0;
+	double RuntimeMeanMs = 0.0;
+
+	TSharedRef<class FJsonObject> ToJsonObject() const;
+};
+
+//FAStarPlanner on the same searches with and without the landmark heuristic, slices and mutexes on in both
+struct GOAPPROJECT_API FLandmarkBenchmarkResult
+{
+	//"synthetic" or "shooter"
+	FString DomainName;
+	int32 NumSearches = 0;
+	int32 NumSolved = 0;
+	//Searches where the two disagree on whether there is a plan or on its cost. The landmark cost is a
+	//lower bound, so anything but 0 is a bug
+	int32 NumCostMismatches = 0;
+	int64 NodesExpandedWith = 0;
+	int64 NodesExpandedWithout = 0;
+	double MeanMsWith = 0.0;
+	double MeanMsWithout = 0.0;
+
+	TSharedRef<class FJsonObject> ToJsonObject() const;
+};
+
+//Action whose preconditions and effects are filled in by the domain generator or a replayed capture
+UCLASS(HideDropdown)
+class GOAPPROJECT_API UGOAPAction_Synthetic : public UGOAPAction
+{
+	GENERATED_BODY()
+public:
+	//Result of VerifyContext, captured actions replay what the real action returned
+	bool bContextValid = true;
+
+	void Setup(const TArray<FWorldProperty>& InPreconditions, const TArray<FAISymEffect>& InEffects, int InCost, const FString& InName = FString());
+
+	virtual bool VerifyContext() override
+	{
+		return bContextValid;
+	}
+};
+
+namespace FPlannerBenchmark
+{
+	//Actions are created in Outer and are not rooted
+	GOAPPROJECT_API void GenerateDomain(const FSyntheticDomainParams& Params, UObject* Outer, TArray<UGOAPAction*>& OutActions, TArray<FWorldProperty>& OutGoal, FWorldState& OutStart);
+
+	//Writes Root as condensed JSON to Saved/Profiling/<Name>.json, or to Name itself when it has an extension. Returns the path
+	GOAPPROJECT_API FString WriteResults(const FString& Name, const TSharedRef<class FJsonObject>& Root);
+
+	//Runs Params.NumSearches searches of FAStarPlanner on the game thread
+	GOAPPROJECT_API FPlannerBenchmarkResult Run(const FSyntheticDomainParams& Params);
+
+	//Fills an agent batch without components and times the per frame passes of UGOAPPlannerSubsystem
+	GOAPPROJECT_API FAgentBatchBenchmarkResult RunAgentBatch(int32 NumAgents, int32 NumFrames, int32 Seed);
+
+	GOAPPROJECT_API FSquadBenchmarkResult RunSquadBatch(int32 NumAgents, int32 SquadSize, int32 NumFrames, int32 Seed);
+
+	//Shooter actions, every event gives the squad a goal and start states that mostly agree
+	GOAPPROJECT_API FSquadReplanBenchmarkResult RunSquadReplans(int32 SquadSize, int32 NumEvents, int32 Seed);
+
+	//Synthetic actions mirroring FShooterPlannerSchema, in schema order
+	GOAPPROJECT_API void GenerateShooterActions(UObject* Outer, TArray<UGOAPAction*>& OutActions);
+
+	//Random start states, goals cycle through the shooter goals
+	GOAPPROJECT_API FStaticPlannerBenchmarkResult RunStaticShooter(int32 NumSearches, int32 Seed);
+
+	//Synthetic searches get a generated domain each, shooter searches random start states and the shooter goals
+	GOAPPROJECT_API FLandmarkBenchmarkResult RunLandmarks(bool bShooter, int32 NumSearches, int32 Seed);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WorldProperty.h"
+#include "WorldState.h"
+
+class UGOAPAction;
+struct FAStarPlanner;
+struct FCompiledPlannerDomain;
+struct FPlanStepInfo;
+
+DECLARE_LOG_CATEGORY_EXTERN(LogPlannerCapture, Log, All);
+
+/** Captured planner search
+  * Everything FAStarPlanner::Search needs to run again without the agent: the goal, the start state,
+  * the action set in the order it was added and what VerifyContext returned for each action.
+  * Actions the search never asked about are stored as valid, removed actions keep their slot as
+  * never valid so indices still line up with the compiled domain.
+  */
+struct GOAPPROJECT_API FCapturedAction
+{
+	FString Name;
+	TArray<FWorldProperty> Preconditions;
+	TArray<FAISymEffect> Effects;
+	int32 Cost = 0;
+	bool bContextValid = true;
+};
+
+//Found by TArray's operator<< through ADL, so they can't live in an anonymous namespace
+GOAPPROJECT_API FArchive& operator<<(FArchive& Ar, FWorldProperty& Property);
+GOAPPROJECT_API FArchive& operator<<(FArchive& Ar, FAISymEffect& Effect);
+GOAPPROJECT_API FArchive& operator<<(FArchive& Ar, FCapturedAction& Action);
+
+struct GOAPPROJECT_API FPlannerCaptureRecord
+{
+	TArray<FWorldProperty> GoalCondition;
+	FWorldState InitialState;
+	int32 MaxDepth = 0;
+	TArray<FCapturedAction> Actions;
+	//FCompiledPlannerDomain::SourcePath and the goal's index in it, empty for searches run without a domain
+	FString DomainPath;
+	int32 GoalIdx = INDEX_NONE;
+	bool bUseSlices = true;
+	bool bUseLandmarks = true;
+	bool bUseMutexes = true;
+
+	//Results of the original search, used to check that the replay is deterministic
+	bool bFound = false;
+	int32 PlanLength = 0;
+	//Sum of the captured costs of the plan's actions
+	int32 PlanCost = 0;
+	double SearchMs = 0.0;
+	//GetActionId of each step in execution order, mined by -run=PlannerMacroMining
+	TArray<FString> PlanActions;
+
+	friend GOAPPROJECT_API FArchive& operator<<(FArchive& Ar, FPlannerCaptureRecord& Record);
+};
+
+/** Opt-in recorder, enabled with GOAP.Capture 1
+  * Records are appended to Saved/Profiling/GOAPCapture-<timestamp>.bin and can be replayed with
+  * -run=PlannerReplay -file=<path>
+  */
+namespace FPlannerCapture
+{
+	GOAPPROJECT_API bool IsCapturing();
+
+	//ActionName, or the object name for unnamed actions. Runtime copies keep their asset subobject's name
+	GOAPPROJECT_API FString GetActionId(const UGOAPAction& Action);
+
+	//Domain and GoalIdx as passed to FAStarPlanner::Search
+	GOAPPROJECT_API void Record(const FAStarPlanner& Planner, const FCompiledPlannerDomain* Domain, int32 GoalIdx, const TArray<FWorldProperty>& GoalCondition,
+		const FWorldState& InitialState, const TMap<const UGOAPAction*, bool>& ContextResults, bool bFound, const TArray<FPlanStepInfo>& Plan, double SearchMs);
+
+	//Closes the current capture file, the next record opens a new one
+	GOAPPROJECT_API void Flush();
+
+	//Returns false if the file is missing or was written with a different world state layout
+	GOAPPROJECT_API bool LoadFile(const FString& Path, TArray<FPlannerCaptureRecord>& OutRecords);
+}
@@ -3,19 +3,47 @@
 #include "CoreMinimal.h"
 #include "BrainComponent.h"
 #include "WorldState.h"
+#include "WorldStateSnapshot.h"
 #include "WorldProperty.h"
 #include "StateNode.h"
 #include "GameplayTagContainer.h"
 #include "BehaviorTree/BehaviorTreeTypes.h"
+#include "Perception/AIPerceptionTypes.h"
+#include "GOAPCooldownSubsystem.h"
+#include "PlannerDomain.h"
+#include "AStarSearch.h"
 #include "PlannerComponent.generated.h"
 
 class UGOAPAction;
+class UGOAPDecorator;
 class UGOAPGoal;
+class UGOAPPlannerSubsystem;
 class UPlannerAsset;
+struct FWSBlackboardBinding;
 class UPlannerService;
 struct FStateNode;
+struct FAStarPlanner;
+struct FShooterPlannerSchema;
+template<typename SchemaType> struct TStaticPlanner;
 
 
+/** Resolved values a plan step needs once it finishes
+  * Only the keys read by the step's variable (KeyRHS) effects are kept, and only if they differ
+  * from the state the plan was searched from. Everything else resolves to the plan's start state.
+  * Values are kept in a packed world state, so any number of keys fits.
+  */
+struct GOAPPROJECT_API FResolvedWSDelta
+{
+	static_assert((uint32)EWorldKey::SYMBOL_MAX <= 32, "FResolvedWSDelta::KeyMask holds one bit per EWorldKey");
+
+	uint32 KeyMask = 0;
+	FWorldState Values;
+
+	void Build(const UGOAPAction* Action, const FWorldState& ResolvedWS, const FWorldState& PlanStartWS);
+	bool Find(EWorldKey Key, uint8& OutValue) const;
+	void Reset() { KeyMask = 0; }
+};
+
 USTRUCT(BlueprintType)
 struct GOAPPROJECT_API FPlanStepInfo
 {
@@ -26,88 +54,256 @@ public:
 	FPlanStepInfo(const FPlanStepInfo& Other) = default;
 
 		UPROPERTY()
-		UGOAPAction* Action;
+		UGOAPAction* Action = nullptr;
 
-		UPROPERTY()
-		FWorldState ResolvedWS;
+		FResolvedWSDelta ResolvedDelta;
 
 		void SetAction(UGOAPAction* NewAction);
-		void SetResolvedWS(const FWorldState& WS);
+		//Call after SetAction, only the keys the action's variable effects read are stored
+		void SetResolvedWS(const FWorldState& WS, const FWorldState& PlanStartWS);
 
 
 };
 
+/** Plans squad members found while replanning in the same UGOAPPlannerSubsystem update
+  * This is plan sharing, not squad planning: every member still plans for itself, a member only
+  * takes another's plan when its own search would have had exactly the same inputs. That is the
+  * same asset and goal, the same start values on every key the goal's search can read and the
+  * same available actions at the same costs, so the shared plan is the one it would have found.
+  * Also counts the members pursuing each goal for UGOAPGoal::GetMaxSquadAssignees.
+  */
+struct GOAPPROJECT_API FSquadPlanContext
+{
+	struct FSolvedPlan
+	{
+		const UPlannerAsset* Asset = nullptr;
+		int32 GoalIdx = INDEX_NONE;
+		FWorldState SearchStartWS;
+		//FAStarPlanner::GetSearchKeys of the search that found it
+		uint32 SearchKeys = 0;
+		//The actions that search could use and their costs, indexed like the planner's actions
+		TBitArray<> SearchActions;
+		TArray<int32> Costs;
+		//Indices into the planner's actions, which are in asset order
+		TArray<int32> ActionIndices;
+		TArray<FResolvedWSDelta> ResolvedDeltas;
+
+		//Planner has to be prepared for a search from StartWS, see FAStarPlanner::PrepareSearch
+		bool Matches(const UPlannerAsset* InAsset, int32 InGoalIdx, const FWorldState& StartWS, const FAStarPlanner& Planner) const;
+	};
+	TArray<FSolvedPlan> Plans;
+	//Members pursuing each asset goal
+	TMap<TPair<const UPlannerAsset*, int32>, int32> GoalAssignees;
+
+	bool HasRoom(const UPlannerAsset* Asset, int32 GoalIdx, int32 MaxAssignees) const
+	{
+		return MaxAssignees <= 0 || GoalAssignees.FindRef(TPair<const UPlannerAsset*, int32>(Asset, GoalIdx)) < MaxAssignees;
+	}
+	void Assign(const UPlannerAsset* Asset, int32 GoalIdx, int32 Delta)
+	{
+		GoalAssignees.FindOrAdd(TPair<const UPlannerAsset*, int32>(Asset, GoalIdx)) += Delta;
+	}
+	const FSolvedPlan* FindPlan(const UPlannerAsset* Asset, int32 GoalIdx, const FWorldState& StartWS, const FAStarPlanner& Planner) const;
+	//Planner is the one that just found Plan
+	void AddPlan(const UPlannerAsset* Asset, int32 GoalIdx, const FWorldState& StartWS, const FAStarPlanner& Planner, const TArray<FPlanStepInfo>& Plan);
+};
+
+UENUM()
+enum class EReplanCause : uint8
+{
+	//Replanning because no plan is running
+	NoPlan,
+	WorldStateChanged,
+	PlanFinished,
+	ActionFailed,
+	PreconditionsFailed,
+	External,
+	CooldownExpired,
+
+	MAX UMETA(Hidden)
+};
+
+//Rolling planner numbers shown by the gameplay debugger
+struct GOAPPROJECT_API FPlannerDebugStats
+{
+	static constexpr int32 LatencyWindow = 16;
+
+	float SearchMs[LatencyWindow] = {};
+	int32 NumSamples = 0;
+	int32 NextSample = 0;
+
+	int32 LastNodesExpanded = 0;
+	int32 ReplanCount = 0;
+	int32 ReplanCauses[(int32)EReplanCause::MAX] = {};
+
+	//Children the searches generated, and how many hashed to a node already in the pool
+	int64 NodeLookups = 0;
+	int64 DuplicateHits = 0;
+	//Action context and cost tables plus squad shared plans, hits skipped VerifyContext, a cost snapshot or a whole search
+	int64 CacheLookups = 0;
+	int64 CacheHits = 0;
+
+	float LastReplanTime = 0.f;
+
+	void AddSearch(float Ms, const FPlannerSearchStats& Stats);
+	void AddCacheLookup(bool bHit);
+	float GetMeanSearchMs() const;
+	float GetMaxSearchMs() const;
+	float GetDuplicateRate() const;
+	float GetCacheHitRate() const;
+};
+
+/** Goals that can be planned for, highest insistence first
+  * Only updated when a goal's validity or insistence changes. Decorators aren't part of the
+  * ordering, they're checked lazily in priority order when replanning.
+  */
+struct GOAPPROJECT_API FGoalPriorityQueue
+{
+	TArray<UGOAPGoal*> Sorted;
+
+	//Re-inserts Goal, or drops it if it's invalid or has no insistence
+	void Update(UGOAPGoal& Goal);
+	void Reset() { Sorted.Reset(); }
+};
+
 struct GOAPPROJECT_API FAStarPlanner
 {
 	
 private:
 	typedef TSharedPtr<FStateNode> NodePtr;
 
-	struct FPriorityQueue
-	{
-		TArray<NodePtr> Heap;
-		TSharedPtrLess<FStateNode> LessFn;
-
-		FPriorityQueue() : Heap(), LessFn()
-		{
-			Heap.Heapify(LessFn);
-		}
-		void Push(const NodePtr& InItem)
-		{
-			Heap.HeapPush(InItem, LessFn);
-		}
-
-		void Pop(NodePtr& OutItem)
-		{
-			Heap.HeapPop(OutItem, LessFn);
-		}
-
-		void ReSort()
-		{
-			Heap.HeapSort(LessFn);
-		}
-
-		TArray<NodePtr>::SizeType Num() const
-		{
-			return Heap.Num();
-		}
-	};
+	//Effect key -> index into ActionList
+	TMultiMap<EWorldKey, int32> EdgeTable;
+
+	//Every added action, in the order they were added
+	//Removed actions leave a null entry so indices stay stable
+	TArray<TWeakObjectPtr<UGOAPAction>> ActionList;
+
+	/** Action availability, indexed like ActionList
+	  * ContextAvailable holds the last VerifyContext result, ContextCached is set for actions that
+	  * keep that result between searches. ContextKeyMasks has a bit per EWorldKey that invalidates it.
+	  */
+	TBitArray<> ContextAvailable;
+	TBitArray<> ContextCached;
+	TArray<uint32> ContextKeyMasks;
+
+	//Cost snapshot, same layout as the context tables
+	TArray<int32> CostTable;
+	TBitArray<> CostCached;
+	TArray<uint32> CostKeyMasks;
 
-	TMultiMap<EWorldKey, TWeakObjectPtr<UGOAPAction>> EdgeTable;
+	//State the cached results were evaluated against
+	FWorldState CachedTablesWS;
+
+	//Runs VerifyContext and snapshots costs at most once per action per search
+	//Actions outside Slice are skipped, their cached results are only invalidated
+	void RefreshActionTables(const FWorldState& InitialState, const TBitArray<>* Slice);
+
+	//Set by PrepareSearch, the next search with the same domain and goal from CachedTablesWS uses them as they are
+	bool bSearchPrepared = false;
+	const FCompiledPlannerDomain* PreparedDomain = nullptr;
+	int32 PreparedGoalIdx = INDEX_NONE;
+	//PreparedDomain if it matches the action list
+	const FCompiledPlannerDomain* SearchDomain = nullptr;
+	//Actions the search starts with, available and relevant to its goal
+	TBitArray<> SearchActions;
+	uint32 SearchKeys = 0;
+
+	//Pushes LastSearchStats to the GOAP stat group and CSV profiler
+	void PublishSearchStats() const;
+
+	//Only set while a search is being captured
+	TMap<const UGOAPAction*, bool>* ObservedContextResults = nullptr;
+
+	//Per goal of the search's domain, at GoalIdx + 1 so searches without a goal index have one too.
+	//Only rebuilt when the start facts or the available actions of that goal change
+	TArray<FRegressionAnalysis> GoalAnalyses;
+
+	bool SearchInternal(const TArray<FWorldProperty>& GoalCondition, const FWorldState& InitialState, TArray<FPlanStepInfo>& Plan, const FCompiledPlannerDomain* Domain, int32 GoalIdx);
 
 public:
 	int32 MaxDepth;
+
+	//What a search takes from its domain, all on by default. Benchmarks turn them off to compare
+	bool bUseSlices = true;
+	bool bUseLandmarks = true;
+	bool bUseMutexes = true;
+	//Fills LastSearchStats.PeakBytes, walks the whole node pool after every search
+	bool bMeasureMemory = false;
+
+	FPlannerSearchStats LastSearchStats;
 	
-	bool Search(const TArray<FWorldProperty>& GoalCondition, const FWorldState& InitialState, TArray<FPlanStepInfo>& Plan);
+	/** Domain must have been compiled from the same actions, in the order they were added
+	  * With it the search only uses GoalIdx's slice (see FGoalDomainSlice), raises the heuristic to
+	  * the cost of the landmarks the start state is missing and drops children its mutexes rule out.
+	  */
+	bool Search(const TArray<FWorldProperty>& GoalCondition, const FWorldState& InitialState, TArray<FPlanStepInfo>& Plan, const FCompiledPlannerDomain* Domain = nullptr, int32 GoalIdx = INDEX_NONE);
+	/** Refreshes the action tables for a search from InitialState, the next Search with the same
+	  * arguments doesn't do it again. Only needed to look at GetSearchActions and GetSearchKeys
+	  * before searching, see FSquadPlanContext.
+	  */
+	void PrepareSearch(const FWorldState& InitialState, const FCompiledPlannerDomain* Domain = nullptr, int32 GoalIdx = INDEX_NONE);
+	//Of the last PrepareSearch or Search: the actions it could use, and the start state keys it could read
+	const TBitArray<>& GetSearchActions() const { return SearchActions; }
+	uint32 GetSearchKeys() const { return SearchKeys; }
 	void AddAction(UGOAPAction* Action);
 	void RemoveAction(UGOAPAction* Action);
 	void ClearEdgeTable();
+
+	//Forces the next search to re-run VerifyContext for Action, or for every action
+	void InvalidateContext(const UGOAPAction* Action);
+	void InvalidateAllContexts();
+	void InvalidateCosts();
+
+	//Cost used by the last search for the action at ActionIdx in GetActions()
+	int32 GetCachedCost(int32 ActionIdx) const { return CostTable[ActionIdx]; }
+
+	const TArray<TWeakObjectPtr<UGOAPAction>>& GetActions() const { return ActionList; }
 };
 
+/** Fixed capacity ring of plan steps
+  * Sized once by Init, starting/advancing/clearing a plan only overwrites slots.
+  * The step at HeadIdx is the current action, a latent abort keeps it at the head while
+  * the next plan is queued behind it.
+  */
 USTRUCT()
 struct GOAPPROJECT_API FPlanInstance
 {
 	GENERATED_BODY()
 public:
 	int32 HeadIdx = 0;
-	int32 TailIdx = 0;
+	//Steps from HeadIdx onwards, including the current one
+	int32 Count = 0;
+
+	//Base the steps' resolved deltas are stored against
+	UPROPERTY()
+		FWorldState StartWS;
 
 	bool bInProgress = false;
-	bool bFull = false;
 	UPROPERTY()
 		TArray<FPlanStepInfo> Buffer;
 
 
-	void StartNewPlan(TArray<FPlanStepInfo>& Plan);
+	void StartNewPlan(TArray<FPlanStepInfo>& Plan, const FWorldState& PlanStartWS);
 	void AddStep(const FPlanStepInfo& PlanStep);
 	bool HasCurrentAction() const;
 	UGOAPAction* GetCurrent();
 	uint8 GetResolvedWSValue(EWorldKey Key);
 	bool Advance();
 	bool HasReachedEnd() const;
+	//The only allocation, nothing after it grows or shrinks the ring
 	void Init(int32 BufferSize);
 	void Clear(bool bLeaveCurrent);
 	bool IsRunningPlan() const;
+
+	int32 Num() const { return Count; }
+	int32 GetCapacity() const { return Buffer.Num(); }
+	//Offset 0 is the current step
+	const FPlanStepInfo& GetStep(int32 Offset) const
+	{
+		check(Offset >= 0 && Offset < Count);
+		return Buffer[(HeadIdx + Offset) % Buffer.Num()];
+	}
 };
 
 UCLASS()
@@ -117,42 +313,97 @@ class GOAPPROJECT_API UPlannerComponent : public UBrainComponent
 protected:
 	//more behavior I had to rip from the BT system
 	TMap<FGameplayTag, float> CooldownTagsMap;
+	//Wakes us up when a cooldown ends, see UGOAPCooldownSubsystem
+	TMap<FGameplayTag, FCooldownTimerHandle> CooldownTimers;
 public:
 	//unused for now. using messages first
 	void OnTaskFinished(UGOAPAction* Action, EPlannerTaskFinishedResult::Type Result);
+	/** Registers us with our world's UGOAPPlannerSubsystem, which owns our world state and runs our replans.
+	  * Works in any world, editor preview worlds included.
+	  */
 	void StartPlanner(UPlannerAsset& PlannerAsset);
 	void StopPlanner();
 
 	void RunAllActions();
 	bool IsRunningPlan() const;
-	void ScheduleReplan();
+	void ScheduleReplan(EReplanCause Cause = EReplanCause::External);
+	//Goals call this when their insistence changes
+	void OnGoalPriorityChanged(UGOAPGoal& Goal);
+	//For actions with bCacheContext, when something outside the world state changes what VerifyContext would return
+	UFUNCTION(BlueprintCallable)
+		void InvalidateActionContext(UGOAPAction* Action);
 	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
 	virtual FString GetDebugInfoString() const;
 
+	UGOAPGoal* GetCurrentGoal() const { return CurrentGoal; }
+	const FPlanInstance& GetPlanInstance() const { return PlanInstance; }
+	const TArray<UGOAPGoal*>& GetGoals() const { return Goals; }
+	const FPlannerDebugStats& GetDebugStats() const { return DebugStats; }
+	//The value as text, with the blackboard key's name for keys the asset sets from a blackboard key
+	FString DescribeWSValue(EWorldKey Key, uint8 Value) const;
+	//Live world state, changes through the frame as writes and effects land
+	const FWorldState& GetWorldState() const;
+	//World state as of the end of the planner subsystem's last tick, Version 0 before the first publish.
+	//Game thread only, the subsystem moves agents around in its arrays. Other threads go through GetWorldStateStore
+	FWorldStateSnapshot GetWorldStateSnapshot() const;
+	uint32 GetWorldStateVersion() const;
+	//Null before StartPlanner. Get it on the game thread, then Read it from any thread for as long as needed
+	TSharedPtr<const FWorldStateSnapshotStore, ESPMode::ThreadSafe> GetWorldStateStore() const;
+
 	//0.f if tag is not set at all
 	float GetTagCooldownEndTime(FGameplayTag Tag);
 	//If AddToDuration is false, the cooldown duration is overwritten
 	void AddTagCooldownDuration(FGameplayTag CooldownTag, float Duration, bool AddToDuration);
+	//Called by the cooldown subsystem once the tag's end time has passed
+	void OnCooldownExpired(const FGameplayTag& Tag);
 
 	void SetWSProp(const EWorldKey& Key, const uint8& Value);
+	//SetWSProp for any thread, applied at the start of the planner subsystem's next tick.
+	//Does nothing before StartPlanner
+	void PostWSProp(EWorldKey Key, uint8 Value);
+
+	//See UGOAPPlannerSubsystem::CreateSquad. Leaves the current squad first
+	UFUNCTION(BlueprintCallable)
+		void JoinSquad(int32 SquadId);
+	UFUNCTION(BlueprintCallable)
+		void LeaveSquad();
+	//Writes to the squad if Key is shared, even if we overrode it, otherwise the same as SetWSProp
+	UFUNCTION(BlueprintCallable)
+		void SetSquadWSProp(EWorldKey Key, uint8 Value);
+	//SetWSProp and action effects write shared keys to the squad, this keeps a value of our own
+	//and ignores squad writes to Key until RevertToSquadWSProp
+	UFUNCTION(BlueprintCallable)
+		void OverrideWSProp(EWorldKey Key, uint8 Value);
+	//Goes back to the squad's value after OverrideWSProp
+	UFUNCTION(BlueprintCallable)
+		void RevertToSquadWSProp(EWorldKey Key);
 
 protected:
 
 	FAStarPlanner AStarPlanner;
+	//Set when the asset's SearchType is NativeShooter and its actions match the schema, see StartPlanner
+	TSharedPtr<TStaticPlanner<FShooterPlannerSchema>> NativePlanner;
 
-	bool bReplanNeeded = false;
 	bool bPlanInProgress = false;
-	bool bPlanUpdateNeeded = false;
-	bool bWorldStateUpdated = false;
 	bool bRunning = false;
 
+	//Our slot in the planner subsystem, which owns the world state, the expected effects
+	//and the replan/update flags. INDEX_NONE until StartPlanner
 	UPROPERTY(transient)
-		TArray<UGOAPAction*> ActionSet;
+		UGOAPPlannerSubsystem* PlannerSubsystem;
+	int32 AgentIndex = INDEX_NONE;
+	friend class UGOAPPlannerSubsystem;
 
-	TMap<EWorldKey, uint8> ExpectedEffects;
+	FWorldState& GetMutableWorldState();
+	void SetAgentFlag(uint8 Flag, bool bSet);
+	//Mirrors PlanInstance into the agent flags, call after anything that changes the plan's head
+	void SyncPlanFlags();
 
-	TMap<EWorldKey, uint8> GoalExpectedEffects;
+	FPlannerDebugStats DebugStats;
+
+	UPROPERTY(transient)
+		TArray<UGOAPAction*> ActionSet;
 
 	UPROPERTY(transient)
 		TArray<UPlannerService*> Services;
@@ -160,12 +411,38 @@ protected:
 	UPROPERTY(transient)
 		TArray<UGOAPGoal*> Goals;
 
+	//Points into Goals
+	FGoalPriorityQueue GoalQueue;
+
+	//Cached decorators by the event that invalidates them, see UGOAPDecorator::DescribeInvalidation
+	TMultiMap<FBlackboard::FKey, UGOAPDecorator*> BBKeyDecorators;
+	TMultiMap<FGameplayTag, UGOAPDecorator*> TagDecorators;
+	TArray<UGOAPDecorator*> PerceptionDecorators;
+
+	//Asset->BlackboardBindings resolved against our blackboard, InvalidKey for bindings that can't work
+	TArray<FBlackboard::FKey> BindingKeyIDs;
+	//Bindings whose blackboard key changed since the last sync
+	TBitArray<> DirtyBindings;
+	bool bBindingSyncPending = false;
+	//Resolves the bindings and writes their current values, before anything reads the world state
+	void InitBlackboardBindings(const UPlannerAsset& PlannerAsset);
+	uint8 EvaluateBinding(const UBlackboardComponent& Blackboard, const FWSBlackboardBinding& Binding, FBlackboard::FKey KeyID) const;
+	//Called by the planner subsystem at the start of its tick, one SetWSProp per dirty binding
+	void SyncBlackboardBindings();
+
+	//Decorator invalidation and world state binding observers, they share the blackboard observer owner
+	void RegisterObservers();
+	void UnregisterObservers();
+	EBlackboardNotificationResult OnDecoratorBBKeyChanged(const UBlackboardComponent& Blackboard, FBlackboard::FKey ChangedKeyID);
+	EBlackboardNotificationResult OnBoundBBKeyChanged(const UBlackboardComponent& Blackboard, FBlackboard::FKey ChangedKeyID);
+	UFUNCTION()
+		void OnDecoratorPerceptionUpdated(AActor* Actor, FAIStimulus Stimulus);
+	void InvalidateTagDecorators(const FGameplayTag& Tag);
+	void CancelCooldownTimers();
+
 	UPROPERTY(transient)
 		UPlannerAsset* Asset;
 
-	//this might need to get wrapped in an object so property-specific delegates can be added
-	FWorldState WorldState;
-
 	//After taking current action, used to validate effects if WS changes
 	FWorldState PredictedWS;
 	//Also add planner instance
@@ -175,7 +452,11 @@ protected:
 	void RequestExecutionUpdate();
 	void UpdatePlanExecution();
 
-	void ProcessReplanRequest();
+	//Squad members replanning together share Squad, see UGOAPPlannerSubsystem::Tick
+	void ProcessReplanRequest(FSquadPlanContext* Squad = nullptr);
+	int32 GetCurrentGoalIndex() const { return CurrentGoal ? Goals.IndexOfByKey(CurrentGoal) : INDEX_NONE; }
+	//Binds ActionSet to the asset's native schema, leaves NativePlanner null if the asset doesn't use one
+	void InitNativePlanner(const UPlannerAsset& PlannerAsset);
 	
 	virtual void Cleanup() override;
 
@@ -197,5 +478,5 @@ protected:
 
 	void AbortPlan();
 
-	void StartNewPlan(TArray<UGOAPAction*> Subtasks, TArray<FPlanStepInfo>& Plan);
+	void StartNewPlan(TArray<UGOAPAction*> Subtasks, TArray<FPlanStepInfo>& Plan, const FWorldState& PlanStartWS);
 };
\ No newline at end of file
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WorldProperty.h"
+#include "WorldState.h"
+
+class UGOAPAction;
+class UGOAPGoal;
+
+/** Part of the action domain one goal's search can ever use
+  * A regressive search only asks for actions that write a key it still has to satisfy, and the
+  * only keys it ever has to satisfy come from the goal condition and the preconditions of actions
+  * it has already chained. Anything outside that closure is never a candidate edge for the goal.
+  */
+struct GOAPPROJECT_API FGoalDomainSlice
+{
+	//Indexed like the action list the domain was compiled from
+	TBitArray<> RelevantActions;
+	int32 NumRelevantActions = 0;
+	//Keys read by the goal condition and the relevant actions, one bit per EWorldKey
+	uint32 RelevantKeys = 0;
+	//Keys the relevant actions can write
+	uint32 ChangeableKeys = 0;
+	//False if no action can produce any of the goal's conditions, so the goal is only ever
+	//satisfied when the world already matches it
+	bool bReachable = true;
+};
+
+//A key holding one value, the unit landmarks and mutexes are expressed in
+struct GOAPPROJECT_API FDomainFact
+{
+	EWorldKey Key = EWorldKey::SYMBOL_MAX;
+	uint8 Value = 0;
+};
+
+/** Two facts on different keys that no action can make hold together
+  * Every action that can produce one of them rules the other out afterwards, by setting its key
+  * to something else or by requiring something else of it. So if the start state doesn't have
+  * both, no state the actions can reach has both either.
+  */
+struct GOAPPROJECT_API FFactMutex
+{
+	int32 FactA = INDEX_NONE;
+	int32 FactB = INDEX_NONE;
+};
+
+/** Per goal slices of an asset's actions, see UPlannerAsset::GetCompiledDomain
+  * Actions and goals are referenced by their index in the asset.
+  */
+struct GOAPPROJECT_API FCompiledPlannerDomain
+{
+	TArray<FGoalDomainSlice> GoalSlices;
+	//Actions no goal's search can reach
+	TBitArray<> DeadActions;
+	//Keys any action can write
+	uint32 ChangeableKeys = 0;
+	int32 NumActions = 0;
+	bool bCompiled = false;
+	//Object path of the asset it was compiled from, captured searches load it again to replay
+	FString SourcePath;
+	//Different for every Compile, so results built from a domain can tell it was recompiled in place
+	uint32 Serial = 0;
+
+	//Landmark masks are a uint64 per fact
+	static constexpr int32 MaxFacts = 64;
+	//Values the domain tests with Eq or Sets as a constant, first MaxFacts only
+	TArray<FDomainFact> Facts;
+	//Per action, the facts its preconditions pin down
+	TArray<uint64> ActionPreFacts;
+	//Per fact, the actions that might produce it. Counting and variable effects count as producing anything
+	TArray<TArray<int32>> FactAchievers;
+	//Per action, the facts it might produce, FactAchievers the other way round
+	TArray<uint64> ActionEffectFacts;
+	TArray<FFactMutex> Mutexes;
+
+	//A bit for every fact in Facts
+	uint64 GetFactMask() const
+	{
+		return Facts.Num() >= MaxFacts ? ~0ull : (1ull << Facts.Num()) - 1;
+	}
+	int32 FindFact(EWorldKey Key, uint8 Value) const
+	{
+		const int32* FactIdx = FactIds.Find(((uint16)Key << 8) | Value);
+		return FactIdx ? *FactIdx : INDEX_NONE;
+	}
+
+	void Compile(const TArray<UGOAPAction*>& Actions, const TArray<UGOAPGoal*>& Goals);
+	//Goal conditions instead of goals, for domains that don't come from an asset
+	void Compile(const TArray<UGOAPAction*>& Actions, const TArray<TArray<FWorldProperty>>& GoalConditions);
+	void Reset();
+	//Warns about dead actions and unreachable goals
+	void LogDiagnostics(const UObject& Owner, const TArray<UGOAPAction*>& Actions, const TArray<UGOAPGoal*>& Goals) const;
+
+	//Null for goals the domain doesn't know about, the search then uses every action
+	const TBitArray<>* GetActionSlice(int32 GoalIdx) const
+	{
+		return GoalSlices.IsValidIndex(GoalIdx) ? &GoalSlices[GoalIdx].RelevantActions : nullptr;
+	}
+private:
+	TMap<uint16, int32> FactIds;
+	int32 AddFact(EWorldKey Key, uint8 Value);
+	void CompileFacts(const TArray<UGOAPAction*>& Actions, const TArray<TArray<FWorldProperty>>& GoalConditions);
+	void CompileMutexes(const TArray<UGOAPAction*>& Actions);
+};
+
+/** What FStateNode knows about a single search, built by FAStarPlanner from the compiled domain
+  * and the start state. Nodes only use it for facts on keys their conditions pin to one value.
+  * FAStarPlanner keeps one per goal, Build does nothing when nothing it depends on changed.
+  */
+struct GOAPPROJECT_API FRegressionAnalysis
+{
+	const FCompiledPlannerDomain* Domain = nullptr;
+	//Facts the start state already has
+	uint64 StartFacts = 0;
+	//Per domain fact, the facts every plan reaching it from the start state achieves on the way,
+	//itself included. Facts no available action leads to keep every fact. Empty if landmarks are off
+	TArray<uint64> FactLandmarks;
+
+	struct FActiveMutex
+	{
+		EWorldKey KeyA;
+		uint8 ValueA;
+		EWorldKey KeyB;
+		uint8 ValueB;
+		uint32 KeyMask;
+	};
+	//Domain mutexes the start state doesn't break
+	TArray<FActiveMutex> ActiveMutexes;
+
+	//AvailableActions is indexed like the domain's actions, only those can be achievers
+	void Build(const FCompiledPlannerDomain& InDomain, const FWorldState& StartState, const TBitArray<>& AvailableActions, bool bLandmarks, bool bMutexes);
+	void Reset();
+
+	//True if the values State pins on ExactKeys can't hold together
+	bool IsMutex(const FWorldState& State, uint32 ExactKeys) const;
+	/** Lower bound on the cost of reaching the unsatisfied pinned facts from the start state
+	  * Every landmark the start state doesn't have needs an achiever. Each achiever's cost (from
+	  * Costs, indexed like the domain's actions) is split evenly over the landmarks it can produce
+	  * and each landmark takes its cheapest share, so an action producing several landmarks is
+	  * only paid for once and the sum never overestimates.
+	  */
+	int32 GetLandmarkCost(const FWorldState& State, uint32 ExactKeys, const TSet<EWorldKey>& UnsatisfiedKeys, const TArray<int32>& Costs) const;
+
+private:
+	//What the last Build was for
+	uint32 DomainSerial = 0;
+	TBitArray<> AvailableActions;
+	bool bBuiltLandmarks = false;
+	bool bBuiltMutexes = false;
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PlannerMacroMiningCommandlet.generated.h"
+
+/** Turns action chains that keep showing up in captured plans into macro actions
+  * -run=PlannerMacroMining -asset=<object path> -files=<a.bin,b.bin> [-minsupport=N] [-maxlen=3] [-maxmacros=8] [-json=<out.json>] [-save]
+  * Counts every 2 to maxlen step run of the asset's actions in the captures' plans, folds the
+  * most frequent ones with UGOAPAction_Macro::Combine and appends them to the asset's Actions.
+  * Without -save it only reports what it would add.
+  */
+UCLASS()
+class GOAPPROJECT_API UPlannerMacroMiningCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+public:
+	UPlannerMacroMiningCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
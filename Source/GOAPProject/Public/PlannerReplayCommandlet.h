@@ -0,0 +1,21 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PlannerReplayCommandlet.generated.h"
+
+/** Re-runs captured planner searches headlessly
+  * -run=PlannerReplay -file=<capture.bin> [-iterations=N] [-json=<out.json>]
+  * Each record is searched N times through the same FAStarPlanner::Search entry point, on the captured
+  * asset's compiled domain and goal. Every run must find the captured plan, action for action and at
+  * the same total cost, so a planner change that alters plans shows up as a mismatch instead of a speedup
+  */
+UCLASS()
+class GOAPPROJECT_API UPlannerReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+public:
+	UPlannerReplayCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -11,6 +11,8 @@ class UPlannerService : public UObject
 
 public:
 
+	//Runs in the component's tick. Read the world state through PlannerComp.GetWorldStateSnapshot(), it holds
+	//still for the frame and its Version can key a cache. GetWorldState is live and changes with every write
 	virtual void TickService(UPlannerComponent& PlannerComp, float DeltaTime);
 
 };
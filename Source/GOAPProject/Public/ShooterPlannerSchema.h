@@ -0,0 +1,50 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "StaticPlanner.h"
+
+/** Native domain of the shooter archetypes, for TStaticPlanner
+  * Shooter planner assets select it with SearchType NativeShooter. Their actions are bound to these
+  * entries by name and have to match them (UPlannerAsset::ValidateSearchType), keep both in sync.
+  */
+struct FShooterPlannerSchema
+{
+	enum EAction : int32
+	{
+		TakeCover,
+		SuppressTarget,
+		AttackFromCover,
+		Attack,
+		Investigate,
+		Idle,
+		Num
+	};
+
+	static constexpr int32 NumActions = EAction::Num;
+
+	static constexpr FStaticActionDef GetAction(int32 Index)
+	{
+		constexpr FStaticActionDef Defs[NumActions] =
+		{
+			//TakeCover
+			{ {}, 0, { { EWorldKey::kUsingObject, ESymbolOp::Set, 1 }, { EWorldKey::kInDanger, ESymbolOp::Set, 0 } }, 2, 2 },
+			//SuppressTarget
+			{ { { EWorldKey::kUsingObject, ESymbolTest::Eq, 1, false } }, 1, { { EWorldKey::kTargetSuppressed, ESymbolOp::Set, 1 } }, 1, 1 },
+			//AttackFromCover
+			{ { { EWorldKey::kUsingObject, ESymbolTest::Eq, 1, false }, { EWorldKey::kTargetSuppressed, ESymbolTest::Eq, 1, false } }, 2, { { EWorldKey::kTargetDead, ESymbolOp::Set, 1 } }, 1, 2 },
+			//Attack, in the open
+			{ { { EWorldKey::kInDanger, ESymbolTest::Eq, 0, false } }, 1, { { EWorldKey::kTargetDead, ESymbolOp::Set, 1 } }, 1, 6 },
+			//Investigate
+			{ { { EWorldKey::kInDanger, ESymbolTest::Eq, 0, false } }, 1, { { EWorldKey::kDisturbanceHandled, ESymbolOp::Set, 1 }, { EWorldKey::kIdle, ESymbolOp::Set, 0 } }, 2, 3 },
+			//Idle
+			{ {}, 0, { { EWorldKey::kIdle, ESymbolOp::Set, 1 } }, 1, 1 },
+		};
+		return Defs[Index];
+	}
+
+	static const TCHAR* GetActionName(int32 Index)
+	{
+		static const TCHAR* Names[NumActions] = { TEXT("TakeCover"), TEXT("SuppressTarget"), TEXT("AttackFromCover"), TEXT("Attack"), TEXT("Investigate"), TEXT("Idle") };
+		return Names[Index];
+	}
+};
@@ -42,8 +42,13 @@ public:
 
 	TArray<bool> PropFlags;
 
+	//Relevant keys pinned to their exact value by an Eq condition, one bit per EWorldKey
+	uint32 ExactKeys = 0;
+
 	int ForwardCost;
 	int Heuristic;
+	//Set by the search's heuristic policy (landmarks for now), not part of the goal test
+	int ExtraHeuristic = 0;
 	int TotalCost;
 	bool Closed;
 	int Depth = 0;
@@ -59,9 +64,11 @@ public:
 		return PropFlags[(uint8)Key];
 	}
 
+	//Also drops the key's exact flag, AddPrecondition sets it again when the condition pins the value
 	void SetKeyRelevance(const EWorldKey& Key, bool bRelevance)
 	{
 		PropFlags[(uint8)Key] = bRelevance;
+		ExactKeys &= ~(1u << (uint8)Key);
 	}
 
 	void CacheTypeHash(uint32 Hash)
@@ -99,6 +106,8 @@ public:
 	  */
 	void ReParent(const FStateNode& OtherNode);
 	bool ChainBackward(UGOAPAction& Action);
+	//ActionCost comes from the planner's per-search cost table instead of Action.Cost()
+	bool ChainBackward(UGOAPAction& Action, int32 ActionCost);
 
 	//Applies the inverse of the effect to the WS value for Key
 	//The inverse of the "set" effect is to revert the value to whatever it was in the goal state
@@ -106,7 +115,17 @@ public:
 	bool InvertEffect(const EWorldKey& Key, const FAISymEffect& Effect);
 
 	bool IsGoal();
+	void SetExtraHeuristic(int InExtraHeuristic);
 	void GetNeighboringEdges(const LookupTable& action_map, TArray<TWeakObjectPtr<UGOAPAction>>& out_actions);
+	//Same as above for tables of action indices
+	void GetNeighboringEdges(const TMultiMap<EWorldKey, int32>& ActionMap, TArray<int32>& OutActionIndices);
+
+	//Heap the node owns, GoalState is shared with the whole search so it isn't counted
+	SIZE_T GetAllocatedSize() const
+	{
+		return sizeof(FStateNode) + sizeof(FWorldState) + UnsatisfiedKeys.GetAllocatedSize()
+			+ UnsatisfiedPreconditions.GetAllocatedSize() + PropFlags.GetAllocatedSize();
+	}
 
 	uint32 GetWSTypeHash() const
 	{
@@ -0,0 +1,491 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WorldProperty.h"
+#include "WorldState.h"
+#include "PlannerComponent.h"
+#include "GOAPAction.h"
+#include "AStarSearch.h"
+
+/** Compile-time planner domain
+  * For native archetypes whose actions never change, the whole domain can be described by a schema
+  * type and searched by TStaticPlanner without going through UGOAPAction virtuals or the
+  * EdgeTable multimap. Only absolute RHS values are supported, Search rejects goals that compare two keys.
+  * FShooterPlannerSchema (ShooterPlannerSchema.h) is the one shipped schema. A planner asset opts in
+  * through UPlannerAsset::SearchType, UPlannerComponent then binds the asset's actions by name.
+  *
+  * A schema looks like:
+  *	struct FMySchema
+  *	{
+  *		static constexpr int32 NumActions = 2;
+  *		static constexpr FStaticActionDef GetAction(int32 Index)
+  *		{
+  *			constexpr FStaticActionDef Defs[NumActions] =
+  *			{
+  *				//Preconditions, NumPreconditions, Effects, NumEffects, Cost
+  *				{ { { EWorldKey::kUsingObject, ESymbolTest::Eq, 1 } }, 1, { { EWorldKey::kTargetDead, ESymbolOp::Set, 1 } }, 1, 2 },
+  *				{ {}, 0, { { EWorldKey::kUsingObject, ESymbolOp::Set, 1 } }, 1, 1 },
+  *			};
+  *			return Defs[Index];
+  *		}
+  *	};
+  */
+namespace FStaticPlannerLimits
+{
+	static constexpr int32 MaxConditions = 4;
+	static constexpr int32 MaxEffects = 4;
+}
+
+struct FStaticCondition
+{
+	EWorldKey Key;
+	ESymbolTest Comparator;
+	uint8 Value;
+	bool bIsNotSolvable;
+};
+
+struct FStaticEffect
+{
+	EWorldKey Key;
+	ESymbolOp Op;
+	uint8 Value;
+};
+
+struct FStaticActionDef
+{
+	FStaticCondition Preconditions[FStaticPlannerLimits::MaxConditions];
+	int32 NumPreconditions;
+	FStaticEffect Effects[FStaticPlannerLimits::MaxEffects];
+	int32 NumEffects;
+	int32 Cost;
+};
+
+namespace FStaticPlannerOps
+{
+	FORCEINLINE constexpr bool Evaluate(ESymbolTest Comparator, uint8 LHS, uint8 RHS)
+	{
+		return (Comparator == ESymbolTest::Eq) ? LHS == RHS :
+			(Comparator == ESymbolTest::Gt) ? LHS > RHS :
+			(Comparator == ESymbolTest::Geq) ? LHS >= RHS :
+			(Comparator == ESymbolTest::Lt) ? LHS < RHS :
+			(Comparator == ESymbolTest::Leq) ? LHS <= RHS : false;
+	}
+
+	FORCEINLINE constexpr uint8 MinSatisfyVal(ESymbolTest Comparator, uint8 RHS)
+	{
+		return (Comparator == ESymbolTest::Gt) ? ((RHS < 255) ? RHS + 1 : 255) :
+			(Comparator == ESymbolTest::Lt) ? ((RHS > 0) ? RHS - 1 : 0) : RHS;
+	}
+
+	//Calls Func(Index) for Index in [0, Count), unrolled at compile time
+	template<int32 Count>
+	struct TUnroll
+	{
+		template<typename FuncType>
+		static FORCEINLINE bool All(FuncType&& Func)
+		{
+			return TUnroll<Count - 1>::All(Func) && Func(Count - 1);
+		}
+	};
+
+	template<>
+	struct TUnroll<0>
+	{
+		template<typename FuncType>
+		static FORCEINLINE bool All(FuncType&& Func)
+		{
+			return true;
+		}
+	};
+}
+
+/** TStaticPlanner
+  * Regressive A*, same semantics as FAStarPlanner and FStateNode, over a domain known at compile time.
+  * Edge lookup is a constexpr table of action bitmasks per key, the heuristic is FWorldState::HammingDist
+  * and nodes are plain structs in a single array. That's also why it keeps its own loop instead of
+  * TRegressiveSearch, whose policies work on shared FStateNodes.
+  */
+template<typename SchemaType>
+struct TStaticPlanner
+{
+	static constexpr int32 NumActions = SchemaType::NumActions;
+	static constexpr int32 NumKeys = (int32)EWorldKey::SYMBOL_MAX;
+	static_assert(NumActions <= 64, "TStaticPlanner stores candidate actions in a uint64");
+	static_assert(NumKeys <= 64, "TStaticPlanner stores key relevance in a uint64");
+
+	struct FEdgeTable
+	{
+		uint64 Masks[NumKeys];
+	};
+
+	//For every key, the set of actions with an effect on it
+	static constexpr FEdgeTable MakeEdgeTable()
+	{
+		FEdgeTable Table = {};
+		for (int32 ActionIdx = 0; ActionIdx < NumActions; ++ActionIdx)
+		{
+			const FStaticActionDef Def = SchemaType::GetAction(ActionIdx);
+			for (int32 EffectIdx = 0; EffectIdx < Def.NumEffects; ++EffectIdx)
+			{
+				Table.Masks[(int32)Def.Effects[EffectIdx].Key] |= (1ull << ActionIdx);
+			}
+		}
+		return Table;
+	}
+	static constexpr FEdgeTable EdgeTable = MakeEdgeTable();
+
+	int32 MaxDepth = 5;
+	FPlannerSearchStats LastSearchStats;
+
+	//Runtime actions executed for each schema action. Unbound actions are never planned
+	void BindAction(int32 Index, UGOAPAction* Action)
+	{
+		check(Index >= 0 && Index < NumActions);
+		BoundActions[Index] = Action;
+	}
+
+	//Index of the schema action named Name, INDEX_NONE if there's none
+	static int32 FindAction(const FString& Name)
+	{
+		for (int32 ActionIdx = 0; ActionIdx < NumActions; ++ActionIdx)
+		{
+			if (Name == SchemaType::GetActionName(ActionIdx))
+			{
+				return ActionIdx;
+			}
+		}
+		return INDEX_NONE;
+	}
+
+	//Whether Action plans exactly like schema action Index. A bound action that doesn't would make
+	//the two planners disagree, so assets are checked before anything is bound
+	static bool MatchesAction(int32 Index, const UGOAPAction& Action)
+	{
+		const FStaticActionDef Def = SchemaType::GetAction(Index);
+		const TArray<FWorldProperty>& Preconditions = Action.GetPreconditions();
+		const TArray<FAISymEffect>& Effects = Action.GetEffects();
+		if (Preconditions.Num() != Def.NumPreconditions || Effects.Num() != Def.NumEffects
+			|| Action.Cost() != Def.Cost || Action.GetCostProvider() != nullptr)
+		{
+			return false;
+		}
+		for (int32 Idx = 0; Idx < Def.NumPreconditions; ++Idx)
+		{
+			const FWorldProperty& Condition = Preconditions[Idx];
+			const FStaticCondition& StaticCondition = Def.Preconditions[Idx];
+			if (!Condition.IsRHSAbsolute() || Condition.Key != StaticCondition.Key || Condition.Comparator != StaticCondition.Comparator
+				|| Condition.Value != StaticCondition.Value || Condition.bIsNotSolvable != StaticCondition.bIsNotSolvable)
+			{
+				return false;
+			}
+		}
+		for (int32 Idx = 0; Idx < Def.NumEffects; ++Idx)
+		{
+			const FAISymEffect& Effect = Effects[Idx];
+			const FStaticEffect& StaticEffect = Def.Effects[Idx];
+			if (!Effect.IsRHSAbsolute() || Effect.Key != StaticEffect.Key || Effect.Op != StaticEffect.Op || Effect.Value != StaticEffect.Value)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static bool CanPlan(const TArray<FWorldProperty>& GoalCondition)
+	{
+		for (const FWorldProperty& Condition : GoalCondition)
+		{
+			if (!Condition.IsRHSAbsolute())
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool Search(const TArray<FWorldProperty>& GoalCondition, const FWorldState& InitialState, TArray<FPlanStepInfo>& Plan)
+	{
+		LastSearchStats = FPlannerSearchStats();
+		if (!CanPlan(GoalCondition))
+		{
+			UE_LOG(LogAction, Warning, TEXT("TStaticPlanner can't plan goal conditions that compare two keys, use FAStarPlanner for this goal"));
+			return false;
+		}
+
+		//Context checks are done once per search instead of once per expansion
+		uint64 AvailableMask = 0;
+		for (int32 ActionIdx = 0; ActionIdx < NumActions; ++ActionIdx)
+		{
+			UGOAPAction* Action = BoundActions[ActionIdx];
+			if (Action && Action->VerifyContext())
+			{
+				AvailableMask |= (1ull << ActionIdx);
+			}
+		}
+
+		Nodes.Reset();
+		Open.Reset();
+		NodeLookup.Reset();
+
+		FNode& Start = Nodes[Nodes.Add(FNode())];
+		Start.State = InitialState;
+		for (const FWorldProperty& Condition : GoalCondition)
+		{
+			const FStaticCondition StaticCondition = { Condition.Key, Condition.Comparator, Condition.Value, Condition.bIsNotSolvable };
+			if (!AddPrecondition(Start, InitialState, StaticCondition))
+			{
+				return false;
+			}
+		}
+		Start.Heuristic = Start.State.HammingDist(InitialState);
+		NodeLookup.Add(FNodeKey(Start), 0);
+		Open.HeapPush(0, FNodeLess(Nodes));
+
+		int32 FoundIdx = INDEX_NONE;
+		while (Open.Num() != 0)
+		{
+			int32 CurrentIdx;
+			Open.HeapPop(CurrentIdx, FNodeLess(Nodes));
+			Nodes[CurrentIdx].bClosed = true;
+
+			if (Nodes[CurrentIdx].Heuristic <= 0)
+			{
+				FoundIdx = CurrentIdx;
+				break;
+			}
+			if (Nodes[CurrentIdx].Depth > MaxDepth)
+			{
+				continue;
+			}
+			++LastSearchStats.NodesExpanded;
+
+			//Candidates are all available actions affecting an unsatisfied key
+			uint64 Candidates = 0;
+			for (int32 Key = 0; Key < NumKeys; ++Key)
+			{
+				if (Nodes[CurrentIdx].State.GetProp((EWorldKey)Key) != InitialState.GetProp((EWorldKey)Key))
+				{
+					Candidates |= EdgeTable.Masks[Key];
+				}
+			}
+			Candidates &= AvailableMask;
+
+			while (Candidates != 0)
+			{
+				const int32 ActionIdx = (int32)FPlatformMath::CountTrailingZeros64(Candidates);
+				Candidates &= Candidates - 1;
+
+				FNode Child = Nodes[CurrentIdx];
+				if (!ChainBackward(Child, InitialState, ActionIdx))
+				{
+					continue;
+				}
+				Child.Parent = CurrentIdx;
+				Child.bClosed = false;
+				++LastSearchStats.NodesGenerated;
+
+				//Same regressed state, which is the values and which keys are still constrained.
+				//Whoever got there cheaper is the node's parent
+				int32* ExistingIdx = NodeLookup.Find(FNodeKey(Child));
+				if (ExistingIdx)
+				{
+					++LastSearchStats.DuplicateHits;
+					FNode& Existing = Nodes[*ExistingIdx];
+					if (Child.ForwardCost < Existing.ForwardCost)
+					{
+						++LastSearchStats.Reparents;
+						Existing.Parent = Child.Parent;
+						Existing.ActionIdx = Child.ActionIdx;
+						Existing.ForwardCost = Child.ForwardCost;
+						Existing.Depth = Child.Depth;
+						if (Existing.bClosed)
+						{
+							Existing.bClosed = false;
+							Open.HeapPush(*ExistingIdx, FNodeLess(Nodes));
+						}
+						else
+						{
+							Open.Heapify(FNodeLess(Nodes));
+						}
+					}
+				}
+				else
+				{
+					const int32 ChildIdx = Nodes.Add(Child);
+					NodeLookup.Add(FNodeKey(Nodes[ChildIdx]), ChildIdx);
+					Open.HeapPush(ChildIdx, FNodeLess(Nodes));
+				}
+			}
+			LastSearchStats.FringePeak = FMath::Max(LastSearchStats.FringePeak, Open.Num());
+		}
+
+		if (FoundIdx == INDEX_NONE)
+		{
+			return false;
+		}
+
+		int32 NodeIdx = FoundIdx;
+		while (Nodes[NodeIdx].Parent != INDEX_NONE)
+		{
+			const FNode& Node = Nodes[NodeIdx];
+			FPlanStepInfo NewStep;
+			NewStep.SetAction(BoundActions[Node.ActionIdx]);
+			NewStep.SetResolvedWS(Nodes[Node.Parent].State, InitialState);
+			Plan.Add(NewStep);
+			NodeIdx = Node.Parent;
+		}
+		return true;
+	}
+
+private:
+	struct FNode
+	{
+		FWorldState State;
+		uint64 RelevantKeys = 0;
+		int32 Parent = INDEX_NONE;
+		int32 ActionIdx = INDEX_NONE;
+		int32 ForwardCost = 0;
+		int32 Heuristic = 0;
+		int32 Depth = 0;
+		bool bClosed = false;
+
+		int32 GetCost() const { return ForwardCost + Heuristic; }
+	};
+
+	struct FNodeKey
+	{
+		FWorldState State;
+		uint64 RelevantKeys;
+
+		explicit FNodeKey(const FNode& Node) : State(Node.State), RelevantKeys(Node.RelevantKeys) {}
+
+		bool operator==(const FNodeKey& Other) const
+		{
+			return State == Other.State && RelevantKeys == Other.RelevantKeys;
+		}
+		friend uint32 GetTypeHash(const FNodeKey& Key)
+		{
+			return HashCombine(GetTypeHash(Key.State), GetTypeHash(Key.RelevantKeys));
+		}
+	};
+
+	struct FNodeLess
+	{
+		const TArray<FNode>& Nodes;
+		explicit FNodeLess(const TArray<FNode>& InNodes) : Nodes(InNodes) {}
+
+		FORCEINLINE bool operator()(int32 A, int32 B) const
+		{
+			return Nodes[A].GetCost() < Nodes[B].GetCost();
+		}
+	};
+
+	UGOAPAction* BoundActions[NumActions] = {};
+
+	//Kept between searches so the allocations are reused
+	TArray<FNode> Nodes;
+	TArray<int32> Open;
+	TMap<FNodeKey, int32> NodeLookup;
+
+	static FORCEINLINE bool AddPrecondition(FNode& Node, const FWorldState& Ground, const FStaticCondition& Condition)
+	{
+		const uint64 KeyBit = 1ull << (uint32)Condition.Key;
+		//the precondition can't conflict with a known value
+		if (Node.RelevantKeys & KeyBit)
+		{
+			return FStaticPlannerOps::Evaluate(Condition.Comparator, Node.State.GetProp(Condition.Key), Condition.Value);
+		}
+
+		const uint8 GroundVal = Ground.GetProp(Condition.Key);
+		if (FStaticPlannerOps::Evaluate(Condition.Comparator, GroundVal, Condition.Value))
+		{
+			Node.State.SetProp(Condition.Key, GroundVal);
+		}
+		else
+		{
+			if (Condition.bIsNotSolvable)
+			{
+				return false;
+			}
+			const uint8 NewVal = FStaticPlannerOps::MinSatisfyVal(Condition.Comparator, Condition.Value);
+			Node.State.SetProp(Condition.Key, FMath::Min(NewVal, FWorldState::GetMaxValue(Condition.Key)));
+		}
+		Node.RelevantKeys |= KeyBit;
+		return true;
+	}
+
+	static FORCEINLINE bool InvertEffect(FNode& Node, const FWorldState& Ground, const FStaticEffect& Effect)
+	{
+		const uint64 KeyBit = 1ull << (uint32)Effect.Key;
+		if ((Node.RelevantKeys & KeyBit) == 0)
+		{
+			return true;
+		}
+		const uint8 CurVal = Node.State.GetProp(Effect.Key);
+		switch (Effect.Op)
+		{
+		case ESymbolOp::Set:
+			//could have been anything before, so go back to the ground truth
+			if (CurVal != Effect.Value)
+			{
+				return false;
+			}
+			Node.RelevantKeys &= ~KeyBit;
+			Node.State.SetProp(Effect.Key, Ground.GetProp(Effect.Key));
+			return true;
+		case ESymbolOp::Inc:
+			if (CurVal < Effect.Value)
+			{
+				return false;
+			}
+			Node.State.SetProp(Effect.Key, CurVal - Effect.Value);
+			return true;
+		case ESymbolOp::Dec:
+			if ((uint32)CurVal + Effect.Value > FWorldState::GetMaxValue(Effect.Key))
+			{
+				return false;
+			}
+			Node.State.SetProp(Effect.Key, CurVal + Effect.Value);
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	static FORCEINLINE bool ChainBackward(FNode& Node, const FWorldState& Ground, int32 ActionIdx)
+	{
+		const FStaticActionDef Def = SchemaType::GetAction(ActionIdx);
+		const int32 PrevHeuristic = Node.Heuristic;
+
+		const bool bEffectsValid = FStaticPlannerOps::TUnroll<FStaticPlannerLimits::MaxEffects>::All([&](int32 Idx)
+		{
+			return Idx >= Def.NumEffects || InvertEffect(Node, Ground, Def.Effects[Idx]);
+		});
+		if (!bEffectsValid)
+		{
+			return false;
+		}
+
+		const bool bPreconditionsValid = FStaticPlannerOps::TUnroll<FStaticPlannerLimits::MaxConditions>::All([&](int32 Idx)
+		{
+			return Idx >= Def.NumPreconditions || AddPrecondition(Node, Ground, Def.Preconditions[Idx]);
+		});
+		if (!bPreconditionsValid)
+		{
+			return false;
+		}
+
+		Node.Heuristic = Node.State.HammingDist(Ground);
+		if (Node.Heuristic > PrevHeuristic)
+		{
+			return false;
+		}
+		Node.ActionIdx = ActionIdx;
+		Node.Depth += 1;
+		Node.ForwardCost += Def.Cost;
+		return true;
+	}
+};
+
+template<typename SchemaType>
+constexpr typename TStaticPlanner<SchemaType>::FEdgeTable TStaticPlanner<SchemaType>::EdgeTable;
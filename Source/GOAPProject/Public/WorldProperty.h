@@ -144,32 +144,29 @@ public:
 		}
 	}
 
-	bool Evaluate(const uint8* Values) const
+	//RHSValue is either Value or the value of KeyRHS, depending on IsRHSAbsolute
+	bool Evaluate(uint8 LHSValue, uint8 RHSValue) const
 	{
-		uint8 RHSValue = (IsRHSAbsolute()) ? Value : Values[uint8(KeyRHS)];
-
-		uint8 LHSValue = Values[uint8(Key)];
 		switch (Comparator)
 		{
 		case ESymbolTest::Eq:
-			return LHSValue == Value;
+			return LHSValue == RHSValue;
 			//break;
 		case ESymbolTest::Gt:
-			return LHSValue > Value;
+			return LHSValue > RHSValue;
 		case ESymbolTest::Geq:
-			return LHSValue >= Value;
+			return LHSValue >= RHSValue;
 		case ESymbolTest::Lt:
-			return LHSValue < Value;
+			return LHSValue < RHSValue;
 		case ESymbolTest::Leq:
-			return LHSValue <= Value;
+			return LHSValue <= RHSValue;
 		default:
 			return false;
 		}
 	}
 	//Haven't figured out Neq, may have to remove it.
-	uint8 MinSatisfyVal(uint8* Values) const
+	uint8 MinSatisfyVal(uint8 RHSValue) const
 	{
-		uint8 RHSValue = (IsRHSAbsolute()) ? Value : Values[uint8(Key)];
 		switch (Comparator)
 		{
 		case ESymbolTest::Eq:
@@ -177,12 +174,12 @@ public:
 		case ESymbolTest::Geq:
 			//fallthrough
 		case ESymbolTest::Leq:
-			return Value;
+			return RHSValue;
 		// Must constrain designer somehow
 		case ESymbolTest::Gt:
-			return (Value < 255) ? Value + 1 : 255;
+			return (RHSValue < 255) ? RHSValue + 1 : 255;
 		case ESymbolTest::Lt:
-			return Value > 0 ? Value - 1 : 0;
+			return RHSValue > 0 ? RHSValue - 1 : 0;
 		default:
 			return 0;
 		}
@@ -221,7 +218,8 @@ public:
 	}
 
 	//Returns whether effect was applied successfully
-	bool Apply(uint8* Values) const;
+	//ValueRHS is either Value or the value of KeyRHS, depending on IsRHSAbsolute
+	bool Apply(uint8& ValueLHS, uint8 ValueRHS) const;
 
 	//the set operation's inverse changes the value back to the "Ground truth", i.e. the value in 
 	//the goal state, so that the hash of the world state will remain consistent
@@ -242,5 +240,5 @@ public:
 	}
 
 	//GroundValue is whatever the value in the GoalState is
-	bool Revert(uint8* Values) const;
+	bool Revert(uint8& ValueLHS, uint8 ValueRHS) const;
 };
\ No newline at end of file
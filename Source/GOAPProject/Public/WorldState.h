@@ -2,7 +2,7 @@
 #include "CoreMinimal.h"
 #include "Containers/Set.h"
 #include "Containers/StaticArray.h"
-#include "Hash/CityHash.h"
+#include "Math/UnrealMathUtility.h"
 
 #include "UObject/NoExportTypes.h"
 #include "WorldProperty.h"
@@ -13,23 +13,101 @@ class FGameplayDebuggerCategory;
 
 DECLARE_LOG_CATEGORY_EXTERN(LogWS, Warning, All);
 
+/** Bit layout of the packed world state
+  * Booleans get a single bit, small enums get a nibble and anything that can hold a
+  * blackboard key ID or a counter gets a full byte.
+  * Widths must be 1, 2, 4 or 8 so a value never has to be split between two words
+  */
+namespace FWorldStateLayout
+{
+	//Indexed by EWorldKey. Keep in sync with the enum!
+	static constexpr uint8 KeyBits[] =
+	{
+		1, //kIdle
+		8, //kAtLocation
+		1, //kTargetDead
+		1, //kDisturbanceHandled
+		1, //kUsingObject
+		1, //kTargetSuppressed
+		1, //kDead
+		1, //kInDanger
+	};
+	static_assert(sizeof(KeyBits) / sizeof(KeyBits[0]) == (uint32)EWorldKey::SYMBOL_MAX, "FWorldStateLayout::KeyBits is missing an EWorldKey entry");
+
+	static constexpr uint32 KeyOffset(uint32 Idx)
+	{
+		//Pad up to the next multiple of the width so fields are naturally aligned
+		return (Idx == 0) ? 0 : (((KeyOffset(Idx - 1) + KeyBits[Idx - 1]) + KeyBits[Idx] - 1) / KeyBits[Idx]) * KeyBits[Idx];
+	}
+
+	static constexpr uint32 TotalBits = KeyOffset((uint32)EWorldKey::SYMBOL_MAX - 1) + KeyBits[(uint32)EWorldKey::SYMBOL_MAX - 1];
+	static constexpr uint32 NumWords = (TotalBits + 63) / 64;
+	static_assert(NumWords <= 2, "World state no longer fits in two words, widen the storage or shrink key widths");
+
+	static constexpr uint32 WordIndex(uint32 Idx) { return KeyOffset(Idx) / 64; }
+	static constexpr uint32 BitIndex(uint32 Idx) { return KeyOffset(Idx) % 64; }
+	static constexpr uint8 ValueMask(uint32 Idx) { return (uint8)((1u << KeyBits[Idx]) - 1); }
+	//False if SetProp would truncate Value, e.g. 2 on a boolean key
+	static constexpr bool IsValidValue(EWorldKey Key, uint8 Value) { return (uint32)Key < (uint32)EWorldKey::SYMBOL_MAX && Value <= ValueMask((uint32)Key); }
+
+	//Masks used by the Hamming distance
+	//FieldMask has every bit of every Width-wide key in Word set, LowBitMask only the lowest bit of each
+	static constexpr uint64 FieldMask(uint32 Word, uint8 Width, uint32 Idx = 0)
+	{
+		return (Idx >= (uint32)EWorldKey::SYMBOL_MAX) ? 0 :
+			(((WordIndex(Idx) == Word && KeyBits[Idx] == Width) ? ((uint64)ValueMask(Idx) << BitIndex(Idx)) : 0) | FieldMask(Word, Width, Idx + 1));
+	}
+	static constexpr uint64 LowBitMask(uint32 Word, uint8 Width, uint32 Idx = 0)
+	{
+		return (Idx >= (uint32)EWorldKey::SYMBOL_MAX) ? 0 :
+			(((WordIndex(Idx) == Word && KeyBits[Idx] == Width) ? (1ull << BitIndex(Idx)) : 0) | LowBitMask(Word, Width, Idx + 1));
+	}
+}
+
 USTRUCT()
 struct GOAPPROJECT_API FWorldState
 {
-	
+
 	GENERATED_BODY()
 
-private: 
-		TStaticArray<uint8, (uint32)EWorldKey::SYMBOL_MAX> State;
+private:
+		//Packed values, see FWorldStateLayout
+		TStaticArray<uint64, FWorldStateLayout::NumWords> Words;
 
 public:
-	FWorldState() = default;
+	FWorldState()
+	{
+		for (uint32 Idx = 0; Idx < FWorldStateLayout::NumWords; ++Idx)
+		{
+			Words[Idx] = 0;
+		}
+	}
 	FWorldState(const FWorldState& Copy) = default;
+	FWorldState& operator=(const FWorldState& Copy) = default;
+
+	//Values wider than the key's field are masked off. This is the search's hot path, so asset values are
+	//checked by UPlannerAsset::ValidateWorldStateValues and game code writes by UPlannerComponent::SetWSProp
+	FORCEINLINE void SetProp(EWorldKey Key, uint8 Value)
+	{
+		const uint32 Idx = (uint32)Key;
+		checkSlow(Value <= FWorldStateLayout::ValueMask(Idx));
+		const uint64 Mask = (uint64)FWorldStateLayout::ValueMask(Idx) << FWorldStateLayout::BitIndex(Idx);
+		uint64& Word = Words[FWorldStateLayout::WordIndex(Idx)];
+		Word = (Word & ~Mask) | (((uint64)Value << FWorldStateLayout::BitIndex(Idx)) & Mask);
+	}
 
-	void SetProp(EWorldKey Key, uint8 Value);
+	FORCEINLINE uint8 GetProp(EWorldKey Key) const
+	{
+		const uint32 Idx = (uint32)Key;
+		return (uint8)(Words[FWorldStateLayout::WordIndex(Idx)] >> FWorldStateLayout::BitIndex(Idx)) & FWorldStateLayout::ValueMask(Idx);
+	}
+
+	//Largest value Key can hold
+	static constexpr uint8 GetMaxValue(EWorldKey Key)
+	{
+		return FWorldStateLayout::ValueMask((uint32)Key);
+	}
 
-	const uint8& GetProp(EWorldKey Key) const;
-	
 	bool CheckCondition(const FWorldProperty& Condition) const;
 
 	void SatisfyCondition(const FWorldProperty& Condition);
@@ -40,15 +118,73 @@ public:
 
 	uint32 Num() const
 	{
-		return State.Num();
+		return (uint32)EWorldKey::SYMBOL_MAX;
 	}
 	//Hamming distance by default, o.w. the absolute value of the difference
 	//should make this an int32
 	int32 HeuristicDist(EWorldKey Key, uint8 Value, bool bHamming=true) const;
 
+	//Number of keys whose values differ between the two states
+	int32 HammingDist(const FWorldState& Other) const
+	{
+		int32 Dist = 0;
+		for (uint32 Word = 0; Word < FWorldStateLayout::NumWords; ++Word)
+		{
+			const uint64 Diff = Words[Word] ^ Other.Words[Word];
+			//Fold each multi bit field down onto its lowest bit so a key only counts once
+			uint64 Folded = Diff & FWorldStateLayout::FieldMask(Word, 1);
+			uint64 Nibbles = Diff & FWorldStateLayout::FieldMask(Word, 2);
+			Nibbles |= Nibbles >> 1;
+			Folded |= Nibbles & FWorldStateLayout::LowBitMask(Word, 2);
+			Nibbles = Diff & FWorldStateLayout::FieldMask(Word, 4);
+			Nibbles |= Nibbles >> 2;
+			Nibbles |= Nibbles >> 1;
+			Folded |= Nibbles & FWorldStateLayout::LowBitMask(Word, 4);
+			uint64 Bytes = Diff & FWorldStateLayout::FieldMask(Word, 8);
+			Bytes |= Bytes >> 4;
+			Bytes |= Bytes >> 2;
+			Bytes |= Bytes >> 1;
+			Folded |= Bytes & FWorldStateLayout::LowBitMask(Word, 8);
+			Dist += (int32)FPlatformMath::CountBits(Folded);
+		}
+		return Dist;
+	}
+
+	friend FORCEINLINE bool operator==(const FWorldState& Lhs, const FWorldState& Rhs)
+	{
+		for (uint32 Word = 0; Word < FWorldStateLayout::NumWords; ++Word)
+		{
+			if (Lhs.Words[Word] != Rhs.Words[Word])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	friend FORCEINLINE bool operator!=(const FWorldState& Lhs, const FWorldState& Rhs)
+	{
+		return !(Lhs == Rhs);
+	}
+
 	friend FORCEINLINE uint32 GetTypeHash(const FWorldState& WorldState)
 	{
-		return CityHash32((const char*)WorldState.State.GetData(), WorldState.Num());
+		uint32 Hash = GetTypeHash(WorldState.Words[0]);
+		for (uint32 Word = 1; Word < FWorldStateLayout::NumWords; ++Word)
+		{
+			Hash = HashCombine(Hash, GetTypeHash(WorldState.Words[Word]));
+		}
+		return Hash;
+	}
+
+	//Raw words, only valid to load with the same FWorldStateLayout
+	friend FArchive& operator<<(FArchive& Ar, FWorldState& WorldState)
+	{
+		for (uint32 Word = 0; Word < FWorldStateLayout::NumWords; ++Word)
+		{
+			Ar << WorldState.Words[Word];
+		}
+		return Ar;
 	}
 
 	void LogWS() const;
@@ -57,4 +193,3 @@ public:
 #endif //WITH_GAMEPLAY_DEBUGGER
 
 };
-
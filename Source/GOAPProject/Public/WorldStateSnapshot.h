@@ -0,0 +1,41 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/Atomic.h"
+#include "WorldState.h"
+
+//Copy of an agent's world state as it was published
+struct GOAPPROJECT_API FWorldStateSnapshot
+{
+	FWorldState WS;
+	//Number of publishes that changed the state, 0 before the first one
+	uint32 Version = 0;
+};
+
+/** Double-buffered published world state of one agent
+  * The game thread publishes into the back buffer and flips it to the front. Readers on any thread
+  * copy the front buffer without locking and retry in the rare case two publishes happened during
+  * the copy, which is the only way the buffer they're reading can be reused.
+  * The version only moves when the published state changes, so caches can be keyed on it.
+  */
+class GOAPPROJECT_API FWorldStateSnapshotStore
+{
+public:
+	//Game thread only. Returns false, without a new version, if State is already published
+	bool Publish(const FWorldState& State);
+
+	FWorldStateSnapshot Read() const;
+
+	uint32 GetVersion() const
+	{
+		return Sequence.Load() >> 1;
+	}
+
+private:
+	FWorldState Buffers[2];
+	//Odd while a publish is writing the back buffer. Sequence / 2 is the version, whose buffer is Buffers[Version & 1]
+	TAtomic<uint32> Sequence{ 0 };
+};
+
+//Readers can keep the store after the agent is gone, it just stops getting new versions
+typedef TSharedRef<FWorldStateSnapshotStore, ESPMode::ThreadSafe> FWorldStateSnapshotStoreRef;